@@ -0,0 +1,249 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// Runs the decompile pipeline on each input several times and reports
+// per-phase timings, throughput and peak memory as JSON, so that runs before
+// and after a change can be compared.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "common/fileio.h"
+#include "common/json.h"
+#include "common/log.h"
+#include "common/profile.h"
+#include "common/stream.h"
+#include "common/threadpool.h"
+#include "director/chunk.h"
+#include "director/dirfile.h"
+
+namespace fs = std::filesystem;
+
+enum BenchPhase {
+	kBenchRead,
+	kBenchParseScripts,
+	kBenchRestoreScriptText,
+	kBenchWrite,
+	kBenchTotal,
+	kBenchPhaseCount
+};
+
+static const char *kBenchPhaseNames[kBenchPhaseCount] = {
+	"read",
+	"parseScripts",
+	"restoreScriptText",
+	"write",
+	"total"
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static uint64_t elapsedUs(Clock::time_point start) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+}
+
+// Resets the peak RSS so that each input is measured on its own. Only Linux
+// supports this; elsewhere the peak covers the whole run so far.
+static void resetPeakRSS() {
+#ifdef __linux__
+	std::ofstream clearRefs("/proc/self/clear_refs");
+	clearRefs << "5";
+#endif
+}
+
+static uint64_t peakRSSKB() {
+#ifdef __linux__
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line)) {
+		if (line.compare(0, 6, "VmHWM:") == 0)
+			return std::stoull(line.substr(6));
+	}
+#endif
+#ifndef _WIN32
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+	}
+#endif
+	return 0;
+}
+
+static bool runOnce(const fs::path &input, const fs::path &output, Common::ThreadPool *pool,
+		Common::Profile *profile, uint64_t (&times)[kBenchPhaseCount]) {
+	Common::ScopedTimer timer(profile, Common::kPhaseTotal);
+	Clock::time_point totalStart = Clock::now();
+	Clock::time_point start = totalStart;
+
+	Common::MappedFile file;
+	if (!file.open(input)) {
+		Common::warning(boost::format("Could not read %s!") % input);
+		return false;
+	}
+	file.advise(Common::kAccessRandom);
+	Common::ReadStream stream(file.view());
+	auto dir = std::make_unique<Director::DirectorFile>();
+	dir->sourceFile = &file;
+	dir->threadPool = pool;
+	dir->profile = profile;
+	if (!dir->read(&stream))
+		return false;
+	times[kBenchRead] = elapsedUs(start);
+
+	file.advise(Common::kAccessWillNeed);
+	dir->config->unprotect();
+	start = Clock::now();
+	dir->parseScripts();
+	times[kBenchParseScripts] = elapsedUs(start);
+
+	start = Clock::now();
+	dir->restoreScriptText();
+	times[kBenchRestoreScriptText] = elapsedUs(start);
+
+	start = Clock::now();
+	if (!dir->writeToFile(output))
+		return false;
+	times[kBenchWrite] = elapsedUs(start);
+
+	dir.reset();
+	times[kBenchTotal] = elapsedUs(totalStart);
+	return true;
+}
+
+static void usage(const char *argv0) {
+	std::cerr << "Usage: " << argv0 << " [options] <file>...\n"
+		<< "  --iterations N     Runs per file (default 5)\n"
+		<< "  --jobs N           Worker threads, including the main one (default 1)\n"
+		<< "  --output-dir DIR   Where to write the decompiled files (default: temp dir)\n";
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int iterations = 5;
+	unsigned int jobs = 1;
+	fs::path outputDir = fs::temp_directory_path();
+	std::vector<fs::path> inputs;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		auto next = [&]() -> std::string {
+			if (i + 1 >= argc) {
+				usage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			return argv[++i];
+		};
+		if (arg == "--iterations") {
+			iterations = std::max(1ul, std::stoul(next()));
+		} else if (arg == "--jobs") {
+			jobs = std::stoul(next());
+			if (jobs == 0)
+				jobs = Common::ThreadPool::hardwareThreads();
+		} else if (arg == "--output-dir") {
+			outputDir = next();
+		} else if (arg.compare(0, 2, "--") == 0) {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		} else {
+			inputs.push_back(arg);
+		}
+	}
+	if (inputs.empty()) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// Keep stdout for the results.
+	Common::g_logLevel = Common::kLogLevelWarning;
+
+	std::unique_ptr<Common::ThreadPool> pool;
+	if (jobs > 1) {
+		pool = std::make_unique<Common::ThreadPool>(jobs - 1);
+	}
+
+	bool ok = true;
+	Common::JSONWriter json;
+	json.startArray();
+	for (const auto &input : inputs) {
+		fs::path output = outputDir / ("bench_" + input.filename().string());
+		std::vector<uint64_t> samples[kBenchPhaseCount];
+		// Counters are the same for every run, so they come from the first.
+		Common::Profile profile;
+
+		resetPeakRSS();
+		bool failed = false;
+		for (unsigned int i = 0; i < iterations; i++) {
+			uint64_t times[kBenchPhaseCount] = {};
+			if (!runOnce(input, output, pool.get(), (i == 0) ? &profile : nullptr, times)) {
+				failed = true;
+				break;
+			}
+			for (int p = 0; p < kBenchPhaseCount; p++) {
+				samples[p].push_back(times[p]);
+			}
+		}
+		uint64_t peakRSS = peakRSSKB();
+		std::error_code ec;
+		fs::remove(output, ec);
+
+		if (failed) {
+			Common::warning(boost::format("Could not decompile %s!") % input);
+			ok = false;
+			continue;
+		}
+
+		uint64_t size = fs::file_size(input);
+		json.startObject();
+			json.writeKey("file");
+			json.writeVal(input.string());
+			json.writeKey("size");
+			json.writeVal(size);
+			json.writeKey("iterations");
+			json.writeVal(iterations);
+			json.writeKey("jobs");
+			json.writeVal(jobs);
+			json.writeKey("phases");
+			json.startObject();
+				for (int p = 0; p < kBenchPhaseCount; p++) {
+					std::vector<uint64_t> &s = samples[p];
+					std::sort(s.begin(), s.end());
+					json.writeKey(kBenchPhaseNames[p]);
+					json.startObject();
+						json.writeKey("minUs");
+						json.writeVal(s.front());
+						json.writeKey("medianUs");
+						json.writeVal(s[s.size() / 2]);
+					json.endObject();
+				}
+			json.endObject();
+			uint64_t medianTotal = samples[kBenchTotal][samples[kBenchTotal].size() / 2];
+			json.writeKey("bytesPerSecond");
+			json.writeVal(medianTotal ? size * 1000000 / medianTotal : (uint64_t)0);
+			json.writeKey("peakRSSKB");
+			json.writeVal(peakRSS);
+			json.writeKey("profile");
+			profile.writeJSON(json);
+		json.endObject();
+	}
+	json.endArray();
+
+	Common::flushLog();
+	std::cout << json.str();
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
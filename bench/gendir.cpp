@@ -0,0 +1,871 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// Generates synthetic Director files for benchmarking.
+//
+// The generated movies contain a configurable number of casts, each with
+// script members whose handlers exercise loops, conditionals and calls, plus
+// opaque bitmap and sound members which are passed through untouched. Output
+// can be a plain RIFX movie or cast (MV93/MC95), a little-endian XFIR file,
+// or an Afterburner-compressed one (FGDM/FGDC).
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/endian/conversion.hpp>
+#include <zlib.h>
+
+#include "common/fileio.h"
+#include "common/stream.h"
+#include "common/util.h"
+#include "director/chunk.h"
+#include "director/dirfile.h"
+#include "director/guid.h"
+#include "director/lingo.h"
+#include "director/subchunk.h"
+
+using namespace Director;
+
+/* ByteWriter */
+
+class ByteWriter {
+public:
+	std::vector<uint8_t> buf;
+	Common::Endianness endianness;
+
+	ByteWriter(Common::Endianness e = Common::kBigEndian) : endianness(e) {}
+
+	size_t pos() const { return buf.size(); }
+
+	void writeBytes(const void *data, size_t size) {
+		const uint8_t *bytes = static_cast<const uint8_t *>(data);
+		buf.insert(buf.end(), bytes, bytes + size);
+	}
+	void writeBytes(const std::vector<uint8_t> &bytes) {
+		buf.insert(buf.end(), bytes.begin(), bytes.end());
+	}
+	void writeUint8(uint8_t value) {
+		buf.push_back(value);
+	}
+	void writeUint16(uint16_t value) {
+		uint8_t b[2];
+		if (endianness)
+			boost::endian::store_little_u16(b, value);
+		else
+			boost::endian::store_big_u16(b, value);
+		writeBytes(b, 2);
+	}
+	void writeUint32(uint32_t value) {
+		uint8_t b[4];
+		if (endianness)
+			boost::endian::store_little_u32(b, value);
+		else
+			boost::endian::store_big_u32(b, value);
+		writeBytes(b, 4);
+	}
+	void writeVarInt(uint32_t value) {
+		uint8_t b[5];
+		size_t len = 0;
+		do {
+			b[len++] = value & 0x7f;
+			value >>= 7;
+		} while (value);
+		for (size_t i = len; i > 0; i--) {
+			writeUint8(b[i - 1] | ((i > 1) ? 0x80 : 0));
+		}
+	}
+	void writePascalString(const std::string &value) {
+		writeUint8(value.size());
+		writeBytes(value.data(), value.size());
+	}
+	void patchUint32(size_t p, uint32_t value) {
+		if (endianness)
+			boost::endian::store_little_u32(&buf[p], value);
+		else
+			boost::endian::store_big_u32(&buf[p], value);
+	}
+};
+
+static std::vector<uint8_t> compress(const std::vector<uint8_t> &data) {
+	uLongf len = compressBound(data.size());
+	std::vector<uint8_t> res(len);
+	::compress(res.data(), &len, data.data(), data.size());
+	res.resize(len);
+	return res;
+}
+
+/* Movie description */
+
+// Indices into the Fcdr compression table
+enum Compression {
+	kCompressionZlib = 0,
+	kCompressionNone = 1,
+	kCompressionSnd = 2
+};
+
+struct Resource {
+	uint32_t fourCC;
+	std::vector<uint8_t> data;
+	bool compress;
+	bool initialLoad;
+	uint32_t sndUncompressedSize = 0; // nonzero if data is an MP3 'snd ' chunk
+};
+
+struct GenOptions {
+	unsigned int casts = 1;
+	unsigned int scripts = 50;
+	unsigned int handlers = 8;
+	unsigned int handlerBlocks = 1;
+	unsigned int bitmaps = 20;
+	unsigned int bitmapSize = 64 * 1024;
+	unsigned int sounds = 0;
+	unsigned int soundSize = 32 * 1024;
+	uint32_t codec = FOURCC('M', 'V', '9', '3');
+	Common::Endianness endianness = Common::kBigEndian;
+	uint32_t seed = 1;
+};
+
+class MovieGenerator {
+public:
+	GenOptions opts;
+	std::vector<Resource> resources; // index = resource ID
+	std::vector<std::string> names;
+	std::map<std::string, int16_t> nameIDs;
+
+	MovieGenerator(const GenOptions &o) : opts(o) {
+		resources.resize(3); // RIFX, imap, mmap
+	}
+
+	int32_t add(uint32_t fourCC, std::vector<uint8_t> data, bool compress = true, bool initialLoad = false) {
+		resources.push_back({ fourCC, std::move(data), compress, initialLoad });
+		return resources.size() - 1;
+	}
+
+	int16_t nameID(const std::string &name) {
+		auto it = nameIDs.find(name);
+		if (it != nameIDs.end())
+			return it->second;
+		names.push_back(name);
+		nameIDs[name] = names.size() - 1;
+		return names.size() - 1;
+	}
+
+	uint32_t random() {
+		opts.seed = opts.seed * 1103515245 + 12345;
+		return (opts.seed >> 16) & 0x7fff;
+	}
+
+	std::vector<uint8_t> makeConfig(uint16_t maxMember);
+	std::vector<uint8_t> makeKeyTable(const std::vector<KeyTableEntry> &entries);
+	std::vector<uint8_t> makeCastList(uint16_t maxMember);
+	std::vector<uint8_t> makeCastMember(uint32_t type, uint32_t scriptId, const std::string &name, const std::vector<uint8_t> &specificData);
+	std::vector<uint8_t> makeHandlerBytecode(unsigned int index, int32_t literalID, std::vector<int16_t> &argNames, std::vector<int16_t> &localNames);
+	std::vector<uint8_t> makeScript(unsigned int scriptNum, int32_t castID);
+	std::vector<uint8_t> makeScriptContext(int32_t lnamID, const std::vector<int32_t> &scriptIDs);
+	std::vector<uint8_t> makeScriptNames();
+
+	void generate();
+	void generateCast(unsigned int index, int32_t lnamID, std::vector<KeyTableEntry> &keys);
+	std::vector<uint8_t> writeRIFX();
+	std::vector<uint8_t> writeAfterburner();
+};
+
+std::vector<uint8_t> MovieGenerator::makeConfig(uint16_t maxMember) {
+	DirectorFile dir;
+	dir.endianness = opts.endianness;
+	ConfigChunk config(&dir);
+	config.len = 100;
+	config.fileVersion = 1700;
+	config.movieTop = 0;
+	config.movieLeft = 0;
+	config.movieBottom = 480;
+	config.movieRight = 640;
+	config.minMember = 1;
+	config.maxMember = maxMember;
+	config.field9 = 0;
+	config.field10 = 0;
+	config.D7stageColorG = 0;
+	config.D7stageColorB = 0;
+	config.commentFont = 0;
+	config.commentSize = 0;
+	config.commentStyle = 0;
+	config.D7stageColorIsRGB = 0;
+	config.D7stageColorR = 0;
+	config.bitDepth = 32;
+	config.field17 = 0;
+	config.field18 = 0;
+	config.field19 = 0;
+	config.directorVersion = 1700;
+	config.field21 = 0;
+	config.field22 = 0;
+	config.field23 = 0;
+	config.field24 = 0;
+	config.field25 = 0;
+	config.field26 = 0;
+	config.frameRate = 30;
+	config.platform = 0;
+	config.protection = 23;
+	config.field29 = 0;
+	std::vector<uint8_t> remnants(config.len - 68);
+	config.remnants = Common::BufferView(remnants.data(), remnants.size());
+
+	std::vector<uint8_t> res(config.size());
+	Common::WriteStream stream(res.data(), res.size());
+	config.write(stream);
+	return res;
+}
+
+std::vector<uint8_t> MovieGenerator::makeKeyTable(const std::vector<KeyTableEntry> &entries) {
+	ByteWriter w(opts.endianness);
+	w.writeUint16(12);
+	w.writeUint16(12);
+	w.writeUint32(entries.size());
+	w.writeUint32(entries.size());
+	for (const auto &entry : entries) {
+		w.writeUint32(entry.sectionID);
+		w.writeUint32(entry.castID);
+		w.writeUint32(entry.fourCC);
+	}
+	return w.buf;
+}
+
+static const int32_t kFirstCastID = 1024;
+
+std::vector<uint8_t> MovieGenerator::makeCastList(uint16_t maxMember) {
+	std::vector<std::vector<uint8_t>> items(1 + 4 * opts.casts);
+	for (unsigned int i = 0; i < opts.casts; i++) {
+		ByteWriter name;
+		name.writePascalString((i == 0) ? "Internal" : "Cast " + std::to_string(i + 1));
+		items[4 * i + 1] = name.buf;
+		items[4 * i + 2] = { 0 };
+		ByteWriter preload;
+		preload.writeUint16(0);
+		items[4 * i + 3] = preload.buf;
+		ByteWriter range;
+		range.writeUint16(1);
+		range.writeUint16(maxMember);
+		range.writeUint32(kFirstCastID + i);
+		items[4 * i + 4] = range.buf;
+	}
+
+	ByteWriter w;
+	w.writeUint32(12); // dataOffset
+	w.writeUint16(0); // unk0
+	w.writeUint16(opts.casts); // castCount
+	w.writeUint16(4); // itemsPerCast
+	w.writeUint16(0); // unk1
+	w.writeUint16(items.size());
+	uint32_t offset = 0;
+	for (const auto &item : items) {
+		w.writeUint32(offset);
+		offset += item.size();
+	}
+	w.writeUint32(offset);
+	for (const auto &item : items) {
+		w.writeBytes(item);
+	}
+	return w.buf;
+}
+
+std::vector<uint8_t> MovieGenerator::makeCastMember(uint32_t type, uint32_t scriptId, const std::string &name, const std::vector<uint8_t> &specificData) {
+	ByteWriter info;
+	info.writeUint32(20); // dataOffset
+	info.writeUint32(0); // unk1
+	info.writeUint32(0); // unk2
+	info.writeUint32(0); // flags
+	info.writeUint32(scriptId);
+	info.writeUint16(2); // offsetTableLen
+	info.writeUint32(0);
+	info.writeUint32(0);
+	info.writeUint32(1 + name.size()); // itemsLen
+	info.writePascalString(name);
+
+	ByteWriter w;
+	w.writeUint32(type);
+	w.writeUint32(info.buf.size());
+	w.writeUint32(specificData.size());
+	w.writeBytes(info.buf);
+	w.writeBytes(specificData);
+	return w.buf;
+}
+
+static void emit(ByteWriter &w, OpCode opcode, int32_t obj = 0) {
+	if (opcode < 0x40) {
+		w.writeUint8(opcode);
+	} else if (opcode == kOpJmp || opcode == kOpJmpIfZ || opcode == kOpEndRepeat || opcode == kOpExtCall) {
+		w.writeUint8(0x80 + (opcode - 0x40));
+		w.writeUint16(obj);
+	} else {
+		w.writeUint8(opcode);
+		w.writeUint8(obj);
+	}
+}
+
+std::vector<uint8_t> MovieGenerator::makeHandlerBytecode(unsigned int index, int32_t literalID, std::vector<int16_t> &argNames, std::vector<int16_t> &localNames) {
+	// on handlerN a, b
+	//   x = a + <n>
+	//   -- repeated handlerBlocks times:
+	//   repeat with i = 1 to <m>
+	//     put "..." & i
+	//   end repeat
+	//   if x > <k> then
+	//     y = b * 2
+	//   else
+	//     y = 0
+	//   end if
+	//   -- end of repeated part
+	//   return x
+	// end
+	argNames = { nameID("a"), nameID("b") };
+	localNames = { nameID("x"), nameID("i"), nameID("y") };
+
+	ByteWriter w;
+	emit(w, kOpGetParam, 0);
+	emit(w, kOpPushInt8, 1 + random() % 100);
+	emit(w, kOpAdd);
+	emit(w, kOpSetLocal, 0);
+
+	for (unsigned int block = 0; block < opts.handlerBlocks; block++) {
+		emit(w, kOpPushInt8, 1);
+		emit(w, kOpSetLocal, 1);
+		size_t conditionPos = w.pos();
+		emit(w, kOpGetLocal, 1);
+		emit(w, kOpPushInt8, 2 + index % 50);
+		emit(w, kOpLtEq);
+		size_t jmpifzPos = w.pos();
+		emit(w, kOpJmpIfZ, 0);
+		emit(w, kOpPushCons, literalID);
+		emit(w, kOpGetLocal, 1);
+		emit(w, kOpJoinStr);
+		emit(w, kOpPushArgListNoRet, 1);
+		emit(w, kOpExtCall, nameID("put"));
+		emit(w, kOpPushInt8, 1);
+		emit(w, kOpGetLocal, 1);
+		emit(w, kOpAdd);
+		emit(w, kOpSetLocal, 1);
+		size_t endRepeatPos = w.pos();
+		emit(w, kOpEndRepeat, endRepeatPos - conditionPos);
+		size_t loopEndPos = w.pos();
+		boost::endian::store_big_u16(&w.buf[jmpifzPos + 1], loopEndPos - jmpifzPos);
+
+		emit(w, kOpGetLocal, 0);
+		emit(w, kOpPushInt8, random() % 100);
+		emit(w, kOpGt);
+		jmpifzPos = w.pos();
+		emit(w, kOpJmpIfZ, 0);
+		emit(w, kOpGetParam, 1);
+		emit(w, kOpPushInt8, 2);
+		emit(w, kOpMul);
+		emit(w, kOpSetLocal, 2);
+		size_t jmpPos = w.pos();
+		emit(w, kOpJmp, 0);
+		boost::endian::store_big_u16(&w.buf[jmpifzPos + 1], w.pos() - jmpifzPos);
+		emit(w, kOpPushZero);
+		emit(w, kOpSetLocal, 2);
+		boost::endian::store_big_u16(&w.buf[jmpPos + 1], w.pos() - jmpPos);
+	}
+
+	emit(w, kOpGetLocal, 0);
+	emit(w, kOpPushArgListNoRet, 1);
+	emit(w, kOpExtCall, nameID("return"));
+	emit(w, kOpRet);
+	return w.buf;
+}
+
+std::vector<uint8_t> MovieGenerator::makeScript(unsigned int scriptNum, int32_t castID) {
+	static const size_t kHeaderLength = 92;
+	static const size_t kHandlerRecordLength = 46;
+
+	uint16_t handlersCount = opts.handlers;
+	std::string literal = "script " + std::to_string(scriptNum) + " says hello";
+
+	std::vector<std::vector<uint8_t>> bytecode(handlersCount);
+	std::vector<std::vector<int16_t>> argNames(handlersCount);
+	std::vector<std::vector<int16_t>> localNames(handlersCount);
+	std::vector<int16_t> handlerNames(handlersCount);
+	for (uint16_t i = 0; i < handlersCount; i++) {
+		handlerNames[i] = nameID("handler" + std::to_string(i) + "_" + std::to_string(scriptNum % 16));
+		bytecode[i] = makeHandlerBytecode(i, 0, argNames[i], localNames[i]);
+	}
+
+	uint32_t handlersOffset = kHeaderLength;
+	uint32_t dataOffset = handlersOffset + handlersCount * kHandlerRecordLength;
+	std::vector<uint32_t> compiledOffsets(handlersCount);
+	std::vector<uint32_t> argOffsets(handlersCount);
+	std::vector<uint32_t> localOffsets(handlersCount);
+	for (uint16_t i = 0; i < handlersCount; i++) {
+		compiledOffsets[i] = dataOffset;
+		dataOffset += bytecode[i].size();
+		if (dataOffset % 2)
+			dataOffset++;
+		argOffsets[i] = dataOffset;
+		dataOffset += 2 * argNames[i].size();
+		localOffsets[i] = dataOffset;
+		dataOffset += 2 * localNames[i].size();
+	}
+	uint32_t literalsOffset = dataOffset;
+	uint32_t literalsDataOffset = literalsOffset + 8;
+	uint32_t totalLength = literalsDataOffset + 4 + literal.size() + 1;
+
+	ByteWriter w;
+	w.writeUint32(0);
+	w.writeUint32(0);
+	/*  8 */ w.writeUint32(totalLength);
+	/* 12 */ w.writeUint32(totalLength);
+	/* 16 */ w.writeUint16(kHeaderLength);
+	/* 18 */ w.writeUint16(scriptNum);
+	/* 20 */ w.writeUint16(0);
+	/* 22 */ w.writeUint16(0xffff);
+	w.writeBytes(std::vector<uint8_t>(14));
+	/* 38 */ w.writeUint32(0); // scriptFlags
+	/* 42 */ w.writeUint16(0);
+	/* 44 */ w.writeUint32(castID);
+	/* 48 */ w.writeUint16(0xffff); // factoryNameID
+	/* 50 */ w.writeUint16(0); // handlerVectorsCount
+	/* 52 */ w.writeUint32(0);
+	/* 56 */ w.writeUint32(0);
+	/* 60 */ w.writeUint16(0); // propertiesCount
+	/* 62 */ w.writeUint32(0);
+	/* 66 */ w.writeUint16(0); // globalsCount
+	/* 68 */ w.writeUint32(0);
+	/* 72 */ w.writeUint16(handlersCount);
+	/* 74 */ w.writeUint32(handlersOffset);
+	/* 78 */ w.writeUint16(1); // literalsCount
+	/* 80 */ w.writeUint32(literalsOffset);
+	/* 84 */ w.writeUint32(4 + literal.size() + 1);
+	/* 88 */ w.writeUint32(literalsDataOffset);
+
+	for (uint16_t i = 0; i < handlersCount; i++) {
+		w.writeUint16(handlerNames[i]);
+		w.writeUint16(0); // vectorPos
+		w.writeUint32(bytecode[i].size());
+		w.writeUint32(compiledOffsets[i]);
+		w.writeUint16(argNames[i].size());
+		w.writeUint32(argOffsets[i]);
+		w.writeUint16(localNames[i].size());
+		w.writeUint32(localOffsets[i]);
+		w.writeUint16(0); // globalsCount
+		w.writeUint32(0);
+		w.writeUint32(0); // unknown1
+		w.writeUint16(0); // unknown2
+		w.writeUint16(0); // lineCount
+		w.writeUint32(0);
+		w.writeUint32(8); // stackHeight
+	}
+	for (uint16_t i = 0; i < handlersCount; i++) {
+		w.writeBytes(bytecode[i]);
+		if (w.pos() % 2)
+			w.writeUint8(0);
+		for (auto id : argNames[i])
+			w.writeUint16(id);
+		for (auto id : localNames[i])
+			w.writeUint16(id);
+	}
+	w.writeUint32(kLiteralString);
+	w.writeUint32(0);
+	w.writeUint32(literal.size() + 1);
+	w.writeBytes(literal.c_str(), literal.size() + 1);
+	return w.buf;
+}
+
+std::vector<uint8_t> MovieGenerator::makeScriptContext(int32_t lnamID, const std::vector<int32_t> &scriptIDs) {
+	ByteWriter w;
+	w.writeUint32(0);
+	w.writeUint32(0);
+	w.writeUint32(scriptIDs.size()); // entryCount
+	w.writeUint32(scriptIDs.size()); // entryCount2
+	w.writeUint16(48); // entriesOffset
+	w.writeUint16(0);
+	w.writeUint32(0);
+	w.writeUint32(0);
+	w.writeUint32(0);
+	w.writeUint32(lnamID);
+	w.writeUint16(scriptIDs.size()); // validCount
+	w.writeUint16(0); // flags
+	w.writeUint16(0xffff); // freePointer
+	w.writeBytes(std::vector<uint8_t>(48 - w.pos()));
+	for (auto id : scriptIDs) {
+		w.writeUint32(0);
+		w.writeUint32(id);
+		w.writeUint16(4);
+		w.writeUint16(0);
+	}
+	return w.buf;
+}
+
+std::vector<uint8_t> MovieGenerator::makeScriptNames() {
+	ByteWriter body;
+	for (const auto &name : names) {
+		body.writePascalString(name);
+	}
+	ByteWriter w;
+	w.writeUint32(0);
+	w.writeUint32(0);
+	w.writeUint32(20 + body.buf.size());
+	w.writeUint32(20 + body.buf.size());
+	w.writeUint16(20); // namesOffset
+	w.writeUint16(names.size());
+	w.writeBytes(body.buf);
+	return w.buf;
+}
+
+void MovieGenerator::generate() {
+	uint16_t memberCount = opts.scripts + opts.bitmaps + opts.sounds;
+
+	// Reserve IDs for the fixed chunks so that they precede the members.
+	int32_t keyID = add(FOURCC('K', 'E', 'Y', '*'), {}, true, true);
+	add(FOURCC('D', 'R', 'C', 'F'), makeConfig(memberCount), true, true);
+	add(FOURCC('M', 'C', 's', 'L'), makeCastList(memberCount), true, true);
+	// All casts share one name table.
+	int32_t lnamID = add(FOURCC('L', 'n', 'a', 'm'), {}, true, true);
+
+	nameID("put");
+	nameID("return");
+
+	std::vector<KeyTableEntry> keys;
+	for (unsigned int i = 0; i < opts.casts; i++) {
+		generateCast(i, lnamID, keys);
+	}
+
+	resources[lnamID].data = makeScriptNames();
+	resources[keyID].data = makeKeyTable(keys);
+}
+
+void MovieGenerator::generateCast(unsigned int index, int32_t lnamID, std::vector<KeyTableEntry> &keys) {
+	const int32_t castID = kFirstCastID + index;
+	int32_t castChunkID = add(FOURCC('C', 'A', 'S', '*'), {}, true, true);
+	int32_t lctxID = add(FOURCC('L', 'c', 't', 'X'), {}, true, true);
+	keys.push_back({ castChunkID, castID, FOURCC('C', 'A', 'S', '*') });
+	keys.push_back({ lctxID, castID, FOURCC('L', 'c', 't', 'X') });
+
+	ByteWriter cast;
+	std::vector<int32_t> scriptIDs;
+	for (unsigned int i = 0; i < opts.scripts; i++) {
+		scriptIDs.push_back(add(FOURCC('L', 's', 'c', 'r'), makeScript(i + 1, castID)));
+		ByteWriter specific;
+		specific.writeUint16(3); // kMovieScript
+		int32_t memberID = add(FOURCC('C', 'A', 'S', 't'),
+			makeCastMember(11, i + 1, "Script " + std::to_string(i + 1), specific.buf));
+		cast.writeUint32(memberID);
+	}
+	for (unsigned int i = 0; i < opts.bitmaps; i++) {
+		std::vector<uint8_t> specific(28);
+		int32_t memberID = add(FOURCC('C', 'A', 'S', 't'),
+			makeCastMember(1, 0, "Bitmap " + std::to_string(i + 1), specific));
+		cast.writeUint32(memberID);
+
+		std::vector<uint8_t> pixels(opts.bitmapSize);
+		uint8_t run = 0;
+		for (size_t j = 0; j < pixels.size(); j++) {
+			if (j % 64 == 0)
+				run = random() & 0xff;
+			pixels[j] = run;
+		}
+		int32_t bitmapID = add(FOURCC('B', 'I', 'T', 'D'), std::move(pixels));
+		keys.push_back({ bitmapID, memberID, FOURCC('B', 'I', 'T', 'D') });
+	}
+
+	for (unsigned int i = 0; i < opts.sounds; i++) {
+		int32_t memberID = add(FOURCC('C', 'A', 'S', 't'),
+			makeCastMember(6, 0, "Sound " + std::to_string(i + 1), {}));
+		cast.writeUint32(memberID);
+
+		// 'snd ' format 1 with one bufferCmd and an extended header, as
+		// stored by Afterburner: the samples are replaced by MP3 data.
+		const uint32_t numSamples = opts.soundSize * 4;
+		ByteWriter snd;
+		snd.writeUint16(1); // format
+		snd.writeUint16(1); // data format count
+		snd.writeUint16(5); // sampledSynth
+		snd.writeUint32(0x80); // initMono
+		snd.writeUint16(1); // command count
+		snd.writeUint16(0x8051); // bufferCmd
+		snd.writeUint16(0);
+		snd.writeUint32(20);
+		snd.writeUint32(0); // samplePtr
+		snd.writeUint32(1); // channels
+		snd.writeUint16(22050); // sample rate
+		snd.writeUint16(0);
+		snd.writeUint32(0); // loop start
+		snd.writeUint32(0); // loop end
+		snd.writeUint8(0xFF); // extended header
+		snd.writeUint8(60); // base frequency
+		snd.writeUint32(numSamples);
+		for (int j = 0; j < 10; j++)
+			snd.writeUint8(0); // AIFF sample rate
+		snd.writeUint32(0); // marker chunk
+		snd.writeUint32(0); // instrument chunks
+		snd.writeUint32(0); // AES recording
+		snd.writeUint16(16); // sample size
+		snd.writeUint16(0);
+		snd.writeUint32(0);
+		snd.writeUint32(0);
+		snd.writeUint32(0);
+		uint32_t headerSize = snd.pos();
+		snd.writeUint32(0); // skip samples
+		for (unsigned int j = 0; j < opts.soundSize; j++)
+			snd.writeUint8((j % 417 == 0) ? 0xFF : (random() & 0xff));
+
+		int32_t soundID = add(FOURCC('s', 'n', 'd', ' '), snd.buf, false);
+		resources[soundID].sndUncompressedSize = headerSize + numSamples * 2;
+		keys.push_back({ soundID, memberID, FOURCC('s', 'n', 'd', ' ') });
+	}
+
+	resources[castChunkID].data = cast.buf;
+	resources[lctxID].data = makeScriptContext(lnamID, scriptIDs);
+}
+
+std::vector<uint8_t> MovieGenerator::writeRIFX() {
+	ByteWriter w(opts.endianness);
+	size_t mmapOffset = 12 + 8 + 24;
+	size_t mmapLen = 24 + 20 * resources.size();
+
+	// Lay out the chunks after the maps
+	std::vector<uint32_t> offsets(resources.size());
+	offsets[0] = 0;
+	offsets[1] = 12;
+	offsets[2] = mmapOffset;
+	size_t offset = mmapOffset + 8 + mmapLen;
+	for (size_t id = 3; id < resources.size(); id++) {
+		offsets[id] = offset;
+		offset += 8 + resources[id].data.size();
+		if (offset % 2)
+			offset++;
+	}
+
+	w.writeUint32(FOURCC('R', 'I', 'F', 'X'));
+	w.writeUint32(offset - 8);
+	w.writeUint32(opts.codec);
+
+	w.writeUint32(FOURCC('i', 'm', 'a', 'p'));
+	w.writeUint32(24);
+	w.writeUint32(1);
+	w.writeUint32(mmapOffset);
+	w.writeUint32(1700);
+	w.writeUint32(0);
+	w.writeUint32(0);
+	w.writeUint32(0);
+
+	w.writeUint32(FOURCC('m', 'm', 'a', 'p'));
+	w.writeUint32(mmapLen);
+	w.writeUint16(24);
+	w.writeUint16(20);
+	w.writeUint32(resources.size());
+	w.writeUint32(resources.size());
+	w.writeUint32(0xffffffff);
+	w.writeUint32(0xffffffff);
+	w.writeUint32(0xffffffff);
+	for (size_t id = 0; id < resources.size(); id++) {
+		uint32_t fourCC = resources[id].fourCC;
+		uint32_t len = resources[id].data.size();
+		if (id == 0) {
+			fourCC = FOURCC('R', 'I', 'F', 'X');
+			len = offset - 8;
+		} else if (id == 1) {
+			fourCC = FOURCC('i', 'm', 'a', 'p');
+			len = 24;
+		} else if (id == 2) {
+			fourCC = FOURCC('m', 'm', 'a', 'p');
+			len = mmapLen;
+		}
+		w.writeUint32(fourCC);
+		w.writeUint32(len);
+		w.writeUint32(offsets[id]);
+		w.writeUint16(0);
+		w.writeUint16(0);
+		w.writeUint32(0);
+	}
+
+	for (size_t id = 3; id < resources.size(); id++) {
+		w.writeUint32(resources[id].fourCC);
+		w.writeUint32(resources[id].data.size());
+		w.writeBytes(resources[id].data);
+		if (w.pos() % 2)
+			w.writeUint8(0);
+	}
+	return w.buf;
+}
+
+static void writeMoaID(ByteWriter &w, const MoaID &id) {
+	w.writeUint32(id.data1);
+	w.writeUint16(id.data2);
+	w.writeUint16(id.data3);
+	w.writeBytes(id.data4, 8);
+}
+
+std::vector<uint8_t> MovieGenerator::writeAfterburner() {
+	ByteWriter fcdr(opts.endianness);
+	fcdr.writeUint16(3);
+	writeMoaID(fcdr, ZLIB_COMPRESSION_GUID);
+	writeMoaID(fcdr, NULL_COMPRESSION_GUID);
+	writeMoaID(fcdr, SND_COMPRESSION_GUID);
+	fcdr.writeBytes("zlib", 5);
+	fcdr.writeBytes("none", 5);
+	fcdr.writeBytes("snd", 4);
+	std::vector<uint8_t> fcdrComp = compress(fcdr.buf);
+
+	// Initial load segment and body
+	ByteWriter ils(opts.endianness);
+	ByteWriter body;
+	struct Entry { int32_t id; uint32_t offset, compSize, uncompSize, compressionType, tag; };
+	std::vector<Entry> entries;
+	for (size_t id = 3; id < resources.size(); id++) {
+		const Resource &res = resources[id];
+		if (res.initialLoad) {
+			ils.writeVarInt(id);
+			ils.writeBytes(res.data);
+			entries.push_back({ (int32_t)id, 0, (uint32_t)res.data.size(), (uint32_t)res.data.size(), kCompressionNone, res.fourCC });
+		}
+	}
+	std::vector<uint8_t> ilsComp = compress(ils.buf);
+	uint32_t bodyOffset = ilsComp.size();
+	for (size_t id = 3; id < resources.size(); id++) {
+		const Resource &res = resources[id];
+		if (res.initialLoad)
+			continue;
+		std::vector<uint8_t> data = res.compress ? compress(res.data) : res.data;
+		uint32_t compression = res.compress ? kCompressionZlib : kCompressionNone;
+		uint32_t uncompSize = res.data.size();
+		if (res.sndUncompressedSize) {
+			compression = kCompressionSnd;
+			uncompSize = res.sndUncompressedSize;
+		}
+		entries.push_back({ (int32_t)id, bodyOffset + (uint32_t)body.pos(), (uint32_t)data.size(),
+			uncompSize, compression, res.fourCC });
+		body.writeBytes(data);
+	}
+	entries.insert(entries.begin(), { 2, 0, (uint32_t)ilsComp.size(), (uint32_t)ils.buf.size(), kCompressionZlib, FOURCC('I', 'L', 'S', ' ') });
+
+	ByteWriter abmp(opts.endianness);
+	abmp.writeVarInt(0);
+	abmp.writeVarInt(0);
+	abmp.writeVarInt(entries.size());
+	for (const auto &entry : entries) {
+		abmp.writeVarInt(entry.id);
+		abmp.writeVarInt(entry.offset);
+		abmp.writeVarInt(entry.compSize);
+		abmp.writeVarInt(entry.uncompSize);
+		abmp.writeVarInt(entry.compressionType);
+		abmp.writeUint32(entry.tag);
+	}
+	std::vector<uint8_t> abmpComp = compress(abmp.buf);
+	ByteWriter abmpHeader;
+	abmpHeader.writeVarInt(0);
+	abmpHeader.writeVarInt(abmp.buf.size());
+
+	ByteWriter w(opts.endianness);
+	w.writeUint32(FOURCC('R', 'I', 'F', 'X'));
+	size_t lenPos = w.pos();
+	w.writeUint32(0);
+	w.writeUint32(opts.codec);
+
+	std::string versionString = "8.5.1";
+	ByteWriter fver;
+	fver.writeVarInt(0x501);
+	fver.writeVarInt(0x1);
+	fver.writeVarInt(1700);
+	fver.writePascalString(versionString);
+	w.writeUint32(FOURCC('F', 'v', 'e', 'r'));
+	w.writeVarInt(fver.buf.size());
+	w.writeBytes(fver.buf);
+
+	w.writeUint32(FOURCC('F', 'c', 'd', 'r'));
+	w.writeVarInt(fcdrComp.size());
+	w.writeBytes(fcdrComp);
+
+	w.writeUint32(FOURCC('A', 'B', 'M', 'P'));
+	w.writeVarInt(abmpHeader.buf.size() + abmpComp.size());
+	w.writeBytes(abmpHeader.buf);
+	w.writeBytes(abmpComp);
+
+	w.writeUint32(FOURCC('F', 'G', 'E', 'I'));
+	w.writeVarInt(0);
+	w.writeBytes(ilsComp);
+	w.writeBytes(body.buf);
+
+	w.patchUint32(lenPos, w.pos() - 8);
+	return w.buf;
+}
+
+static void usage(const char *argv0) {
+	std::cerr << "Usage: " << argv0 << " [options] <output>\n"
+		<< "  --casts N          Number of casts (default 1)\n"
+		<< "  --scripts N        Script members per cast (default 50)\n"
+		<< "  --handlers N       Handlers per script (default 8)\n"
+		<< "  --handler-blocks N Loop/conditional blocks per handler (default 1)\n"
+		<< "  --bitmaps N        Bitmap members per cast (default 20)\n"
+		<< "  --bitmap-size N    Bytes per bitmap (default 65536)\n"
+		<< "  --sounds N         MP3 sound members per cast, Afterburner only (default 0)\n"
+		<< "  --sound-size N     Bytes of MP3 data per sound (default 32768)\n"
+		<< "  --codec C          MV93, MC95, FGDM or FGDC (default MV93)\n"
+		<< "  --little-endian    Write an XFIR file\n"
+		<< "  --seed N           Random seed (default 1)\n";
+}
+
+int main(int argc, char *argv[]) {
+	GenOptions opts;
+	std::filesystem::path output;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		auto next = [&]() -> std::string {
+			if (i + 1 >= argc) {
+				usage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			return argv[++i];
+		};
+		if (arg == "--casts") {
+			opts.casts = std::max(1ul, std::stoul(next()));
+		} else if (arg == "--scripts") {
+			opts.scripts = std::stoul(next());
+		} else if (arg == "--handlers") {
+			opts.handlers = std::stoul(next());
+		} else if (arg == "--handler-blocks") {
+			opts.handlerBlocks = std::stoul(next());
+		} else if (arg == "--bitmaps") {
+			opts.bitmaps = std::stoul(next());
+		} else if (arg == "--bitmap-size") {
+			opts.bitmapSize = std::stoul(next());
+		} else if (arg == "--sounds") {
+			opts.sounds = std::stoul(next());
+		} else if (arg == "--sound-size") {
+			opts.soundSize = std::stoul(next());
+		} else if (arg == "--codec") {
+			std::string codec = next();
+			if (codec.size() != 4) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			opts.codec = FOURCC(codec[0], codec[1], codec[2], codec[3]);
+		} else if (arg == "--little-endian") {
+			opts.endianness = Common::kLittleEndian;
+		} else if (arg == "--seed") {
+			opts.seed = std::stoul(next());
+		} else if (arg[0] == '-') {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		} else {
+			output = arg;
+		}
+	}
+	if (output.empty()) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	MovieGenerator gen(opts);
+	gen.generate();
+	bool afterburned = (opts.codec == FOURCC('F', 'G', 'D', 'M') || opts.codec == FOURCC('F', 'G', 'D', 'C'));
+	std::vector<uint8_t> data = afterburned ? gen.writeAfterburner() : gen.writeRIFX();
+	Common::writeFile(output, data.data(), data.size());
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,647 @@
+unsigned char fontmaps_fontmap_D10_txt[] = {
+  0x3b, 0x20, 0x43, 0x6f, 0x70, 0x79, 0x72, 0x69, 0x67, 0x68, 0x74, 0x20,
+  0x31, 0x39, 0x39, 0x34, 0x2d, 0x32, 0x30, 0x30, 0x34, 0x2c, 0x20, 0x4d,
+  0x61, 0x63, 0x72, 0x6f, 0x6d, 0x65, 0x64, 0x69, 0x61, 0x2c, 0x20, 0x49,
+  0x6e, 0x63, 0x2e, 0x20, 0x20, 0x41, 0x6c, 0x6c, 0x20, 0x52, 0x69, 0x67,
+  0x68, 0x74, 0x73, 0x20, 0x52, 0x65, 0x73, 0x65, 0x72, 0x76, 0x65, 0x64,
+  0x2e, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x44, 0x65, 0x66, 0x61, 0x75,
+  0x6c, 0x74, 0x20, 0x46, 0x6f, 0x6e, 0x74, 0x20, 0x4d, 0x61, 0x70, 0x70,
+  0x69, 0x6e, 0x67, 0x20, 0x54, 0x61, 0x62, 0x6c, 0x65, 0x20, 0x66, 0x6f,
+  0x72, 0x20, 0x44, 0x69, 0x72, 0x65, 0x63, 0x74, 0x6f, 0x72, 0x20, 0x4d,
+  0x58, 0x20, 0x32, 0x30, 0x30, 0x34, 0x20, 0x4d, 0x61, 0x63, 0x69, 0x6e,
+  0x74, 0x6f, 0x73, 0x68, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x57, 0x69, 0x6e,
+  0x64, 0x6f, 0x77, 0x73, 0x2e, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20,
+  0x54, 0x68, 0x69, 0x73, 0x20, 0x66, 0x69, 0x6c, 0x65, 0x20, 0x70, 0x72,
+  0x6f, 0x76, 0x69, 0x64, 0x65, 0x73, 0x20, 0x61, 0x20, 0x66, 0x6f, 0x6e,
+  0x74, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x20, 0x74, 0x61,
+  0x62, 0x6c, 0x65, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x44, 0x69, 0x72, 0x65,
+  0x63, 0x74, 0x6f, 0x72, 0x20, 0x4d, 0x58, 0x20, 0x32, 0x30, 0x30, 0x34,
+  0x20, 0x66, 0x6f, 0x72, 0x20, 0x57, 0x69, 0x6e, 0x64, 0x6f, 0x77, 0x73,
+  0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x4d, 0x61, 0x63,
+  0x69, 0x6e, 0x74, 0x6f, 0x73, 0x68, 0x2e, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a,
+  0x3b, 0x20, 0x49, 0x66, 0x20, 0x61, 0x20, 0x63, 0x6f, 0x70, 0x79, 0x20,
+  0x6f, 0x66, 0x20, 0x74, 0x68, 0x69, 0x73, 0x20, 0x66, 0x69, 0x6c, 0x65,
+  0x20, 0x69, 0x73, 0x20, 0x69, 0x6e, 0x20, 0x74, 0x68, 0x65, 0x20, 0x73,
+  0x61, 0x6d, 0x65, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x6f,
+  0x72, 0x20, 0x64, 0x69, 0x72, 0x65, 0x63, 0x74, 0x6f, 0x72, 0x79, 0x20,
+  0x61, 0x73, 0x20, 0x74, 0x68, 0x65, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x44,
+  0x69, 0x72, 0x65, 0x63, 0x74, 0x6f, 0x72, 0x20, 0x61, 0x70, 0x70, 0x6c,
+  0x69, 0x63, 0x61, 0x74, 0x69, 0x6f, 0x6e, 0x2c, 0x20, 0x44, 0x69, 0x72,
+  0x65, 0x63, 0x74, 0x6f, 0x72, 0x20, 0x77, 0x69, 0x6c, 0x6c, 0x20, 0x61,
+  0x75, 0x74, 0x6f, 0x6d, 0x61, 0x74, 0x69, 0x63, 0x61, 0x6c, 0x6c, 0x79,
+  0x20, 0x69, 0x6e, 0x63, 0x6c, 0x75, 0x64, 0x65, 0x20, 0x74, 0x68, 0x69,
+  0x73, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x6d,
+  0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x20, 0x74, 0x61, 0x62, 0x6c, 0x65,
+  0x20, 0x69, 0x6e, 0x20, 0x65, 0x76, 0x65, 0x72, 0x79, 0x20, 0x6e, 0x65,
+  0x77, 0x20, 0x6d, 0x6f, 0x76, 0x69, 0x65, 0x20, 0x79, 0x6f, 0x75, 0x20,
+  0x63, 0x72, 0x65, 0x61, 0x74, 0x65, 0x2e, 0x0d, 0x0a, 0x3b, 0x20, 0x0d,
+  0x0a, 0x3b, 0x20, 0x54, 0x6f, 0x20, 0x61, 0x64, 0x64, 0x20, 0x74, 0x68,
+  0x69, 0x73, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x20, 0x6d, 0x61, 0x70, 0x70,
+  0x69, 0x6e, 0x67, 0x20, 0x74, 0x61, 0x62, 0x6c, 0x65, 0x20, 0x74, 0x6f,
+  0x20, 0x61, 0x6e, 0x20, 0x65, 0x78, 0x69, 0x73, 0x74, 0x69, 0x6e, 0x67,
+  0x20, 0x6d, 0x6f, 0x76, 0x69, 0x65, 0x2c, 0x20, 0x63, 0x68, 0x6f, 0x6f,
+  0x73, 0x65, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x4d, 0x6f, 0x76, 0x69, 0x65,
+  0x3a, 0x50, 0x72, 0x6f, 0x70, 0x65, 0x72, 0x74, 0x69, 0x65, 0x73, 0x2e,
+  0x2e, 0x2e, 0x20, 0x66, 0x72, 0x6f, 0x6d, 0x20, 0x74, 0x68, 0x65, 0x20,
+  0x4d, 0x6f, 0x64, 0x69, 0x66, 0x79, 0x20, 0x6d, 0x65, 0x6e, 0x75, 0x2e,
+  0x20, 0x20, 0x54, 0x68, 0x65, 0x6e, 0x20, 0x63, 0x6c, 0x69, 0x63, 0x6b,
+  0x20, 0x4c, 0x6f, 0x61, 0x64, 0x20, 0x66, 0x72, 0x6f, 0x6d, 0x20, 0x46,
+  0x69, 0x6c, 0x65, 0x2e, 0x20, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x55, 0x73,
+  0x65, 0x20, 0x74, 0x68, 0x65, 0x20, 0x64, 0x69, 0x61, 0x6c, 0x6f, 0x67,
+  0x20, 0x62, 0x6f, 0x78, 0x20, 0x74, 0x68, 0x61, 0x74, 0x20, 0x61, 0x70,
+  0x70, 0x65, 0x61, 0x72, 0x73, 0x20, 0x74, 0x6f, 0x20, 0x6c, 0x6f, 0x63,
+  0x61, 0x74, 0x65, 0x20, 0x74, 0x68, 0x69, 0x73, 0x20, 0x66, 0x69, 0x6c,
+  0x65, 0x2e, 0x0d, 0x0a, 0x3b, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x4e, 0x6f,
+  0x74, 0x65, 0x3a, 0x20, 0x49, 0x6e, 0x20, 0x74, 0x68, 0x69, 0x73, 0x20,
+  0x66, 0x69, 0x6c, 0x65, 0x2c, 0x20, 0x61, 0x20, 0x73, 0x65, 0x6d, 0x69,
+  0x63, 0x6f, 0x6c, 0x6f, 0x6e, 0x20, 0x61, 0x74, 0x20, 0x74, 0x68, 0x65,
+  0x20, 0x62, 0x65, 0x67, 0x69, 0x6e, 0x6e, 0x69, 0x6e, 0x67, 0x20, 0x6f,
+  0x66, 0x20, 0x61, 0x20, 0x6c, 0x69, 0x6e, 0x65, 0x20, 0x69, 0x6e, 0x64,
+  0x69, 0x63, 0x61, 0x74, 0x65, 0x73, 0x0d, 0x0a, 0x3b, 0x20, 0x61, 0x20,
+  0x63, 0x6f, 0x6d, 0x6d, 0x65, 0x6e, 0x74, 0x2e, 0x0d, 0x0a, 0x3b, 0x0d,
+  0x0a, 0x3b, 0x20, 0x53, 0x70, 0x65, 0x63, 0x69, 0x61, 0x6c, 0x20, 0x4e,
+  0x6f, 0x74, 0x65, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x4d, 0x61, 0x63, 0x20,
+  0x4f, 0x53, 0x58, 0x20, 0x75, 0x73, 0x65, 0x72, 0x73, 0x3a, 0x20, 0x54,
+  0x68, 0x69, 0x73, 0x20, 0x66, 0x69, 0x6c, 0x65, 0x20, 0x69, 0x73, 0x20,
+  0x73, 0x61, 0x76, 0x65, 0x64, 0x20, 0x75, 0x73, 0x69, 0x6e, 0x67, 0x20,
+  0x74, 0x68, 0x65, 0x20, 0x27, 0x43, 0x6c, 0x61, 0x73, 0x73, 0x69, 0x63,
+  0x27, 0x20, 0x6c, 0x69, 0x6e, 0x65, 0x0d, 0x0a, 0x3b, 0x20, 0x65, 0x6e,
+  0x64, 0x69, 0x6e, 0x67, 0x20, 0x63, 0x68, 0x61, 0x72, 0x61, 0x63, 0x74,
+  0x65, 0x72, 0x20, 0x28, 0x43, 0x52, 0x29, 0x2e, 0x20, 0x20, 0x49, 0x66,
+  0x20, 0x79, 0x6f, 0x75, 0x20, 0x6e, 0x65, 0x65, 0x64, 0x20, 0x74, 0x6f,
+  0x20, 0x61, 0x6c, 0x74, 0x65, 0x72, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x73,
+  0x61, 0x76, 0x65, 0x20, 0x74, 0x68, 0x69, 0x73, 0x20, 0x66, 0x69, 0x6c,
+  0x65, 0x2c, 0x20, 0x6d, 0x61, 0x6b, 0x65, 0x20, 0x73, 0x75, 0x72, 0x65,
+  0x20, 0x74, 0x6f, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x70, 0x72, 0x65, 0x73,
+  0x65, 0x72, 0x76, 0x65, 0x20, 0x74, 0x68, 0x69, 0x73, 0x20, 0x2d, 0x20,
+  0x74, 0x68, 0x65, 0x20, 0x55, 0x4e, 0x49, 0x58, 0x20, 0x6c, 0x69, 0x6e,
+  0x65, 0x20, 0x65, 0x6e, 0x64, 0x69, 0x6e, 0x67, 0x20, 0x63, 0x68, 0x61,
+  0x72, 0x61, 0x63, 0x74, 0x65, 0x72, 0x20, 0x28, 0x4c, 0x46, 0x29, 0x20,
+  0x77, 0x69, 0x6c, 0x6c, 0x20, 0x6e, 0x6f, 0x74, 0x20, 0x77, 0x6f, 0x72,
+  0x6b, 0x20, 0x70, 0x72, 0x6f, 0x70, 0x65, 0x72, 0x6c, 0x79, 0x2e, 0x0d,
+  0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x0d, 0x0a,
+  0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x46, 0x4f, 0x4e, 0x54, 0x20, 0x4d, 0x41,
+  0x50, 0x50, 0x49, 0x4e, 0x47, 0x53, 0x20, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a,
+  0x3b, 0x20, 0x46, 0x6f, 0x6e, 0x74, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x69,
+  0x6e, 0x67, 0x73, 0x20, 0x73, 0x70, 0x65, 0x63, 0x69, 0x66, 0x79, 0x20,
+  0x77, 0x68, 0x69, 0x63, 0x68, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x20, 0x61,
+  0x6e, 0x64, 0x20, 0x73, 0x69, 0x7a, 0x65, 0x20, 0x73, 0x75, 0x62, 0x73,
+  0x74, 0x69, 0x74, 0x75, 0x74, 0x69, 0x6f, 0x6e, 0x73, 0x20, 0x74, 0x6f,
+  0x20, 0x6d, 0x61, 0x6b, 0x65, 0x20, 0x77, 0x68, 0x65, 0x6e, 0x0d, 0x0a,
+  0x3b, 0x20, 0x6d, 0x6f, 0x76, 0x69, 0x6e, 0x67, 0x20, 0x61, 0x20, 0x6d,
+  0x6f, 0x76, 0x69, 0x65, 0x20, 0x66, 0x72, 0x6f, 0x6d, 0x20, 0x6f, 0x6e,
+  0x65, 0x20, 0x70, 0x6c, 0x61, 0x74, 0x66, 0x6f, 0x72, 0x6d, 0x20, 0x74,
+  0x6f, 0x20, 0x61, 0x6e, 0x6f, 0x74, 0x68, 0x65, 0x72, 0x2e, 0x0d, 0x0a,
+  0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x54, 0x68, 0x65, 0x20, 0x66, 0x6f, 0x72,
+  0x6d, 0x61, 0x74, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x66, 0x6f, 0x6e, 0x74,
+  0x20, 0x6d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x20, 0x64, 0x65, 0x66,
+  0x69, 0x6e, 0x69, 0x74, 0x69, 0x6f, 0x6e, 0x73, 0x20, 0x69, 0x73, 0x3a,
+  0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x50, 0x6c, 0x61, 0x74, 0x66,
+  0x6f, 0x72, 0x6d, 0x3a, 0x46, 0x6f, 0x6e, 0x74, 0x4e, 0x61, 0x6d, 0x65,
+  0x20, 0x3d, 0x3e, 0x20, 0x50, 0x6c, 0x61, 0x74, 0x66, 0x6f, 0x72, 0x6d,
+  0x3a, 0x46, 0x6f, 0x6e, 0x74, 0x4e, 0x61, 0x6d, 0x65, 0x20, 0x5b, 0x4d,
+  0x41, 0x50, 0x20, 0x4e, 0x4f, 0x4e, 0x45, 0x5d, 0x20, 0x5b, 0x6f, 0x6c,
+  0x64, 0x53, 0x69, 0x7a, 0x65, 0x20, 0x3d, 0x3e, 0x20, 0x6e, 0x65, 0x77,
+  0x53, 0x69, 0x7a, 0x65, 0x5d, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20,
+  0x20, 0x20, 0x20, 0x53, 0x70, 0x65, 0x63, 0x69, 0x66, 0x79, 0x69, 0x6e,
+  0x67, 0x20, 0x4d, 0x41, 0x50, 0x20, 0x4e, 0x4f, 0x4e, 0x45, 0x20, 0x74,
+  0x75, 0x72, 0x6e, 0x73, 0x20, 0x6f, 0x66, 0x66, 0x20, 0x63, 0x68, 0x61,
+  0x72, 0x61, 0x63, 0x74, 0x65, 0x72, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x69,
+  0x6e, 0x67, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x74, 0x68, 0x69, 0x73, 0x20,
+  0x66, 0x6f, 0x6e, 0x74, 0x2e, 0x0d, 0x0a, 0x3b, 0x20, 0x20, 0x20, 0x20,
+  0x49, 0x66, 0x20, 0x79, 0x6f, 0x75, 0x20, 0x73, 0x70, 0x65, 0x63, 0x69,
+  0x66, 0x79, 0x20, 0x73, 0x69, 0x7a, 0x65, 0x20, 0x6d, 0x61, 0x70, 0x70,
+  0x69, 0x6e, 0x67, 0x73, 0x2c, 0x20, 0x74, 0x68, 0x65, 0x79, 0x20, 0x61,
+  0x70, 0x70, 0x6c, 0x79, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x54, 0x48, 0x41,
+  0x54, 0x20, 0x46, 0x4f, 0x4e, 0x54, 0x20, 0x4f, 0x4e, 0x4c, 0x59, 0x2e,
+  0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x48, 0x65, 0x72, 0x65, 0x20,
+  0x61, 0x72, 0x65, 0x20, 0x73, 0x6f, 0x6d, 0x65, 0x20, 0x74, 0x79, 0x70,
+  0x69, 0x63, 0x61, 0x6c, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67,
+  0x73, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x73, 0x74,
+  0x61, 0x6e, 0x64, 0x61, 0x72, 0x64, 0x20, 0x4d, 0x61, 0x63, 0x69, 0x6e,
+  0x74, 0x6f, 0x73, 0x68, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x73, 0x3a, 0x0d,
+  0x0a, 0x3b, 0x0d, 0x0a, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x43, 0x68,
+  0x69, 0x63, 0x61, 0x67, 0x6f, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x53, 0x79, 0x73, 0x74, 0x65,
+  0x6d, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x43, 0x6f, 0x75, 0x72, 0x69,
+  0x65, 0x72, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20,
+  0x57, 0x69, 0x6e, 0x3a, 0x22, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65, 0x72,
+  0x20, 0x4e, 0x65, 0x77, 0x22, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x47,
+  0x65, 0x6e, 0x65, 0x76, 0x61, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0x4d, 0x53, 0x20,
+  0x53, 0x61, 0x6e, 0x73, 0x20, 0x53, 0x65, 0x72, 0x69, 0x66, 0x22, 0x0d,
+  0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x48, 0x65, 0x6c, 0x76, 0x65, 0x74, 0x69,
+  0x63, 0x61, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69,
+  0x6e, 0x3a, 0x41, 0x72, 0x69, 0x61, 0x6c, 0x0d, 0x0a, 0x4d, 0x61, 0x63,
+  0x3a, 0x4d, 0x6f, 0x6e, 0x61, 0x63, 0x6f, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x54, 0x65,
+  0x72, 0x6d, 0x69, 0x6e, 0x61, 0x6c, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a,
+  0x22, 0x4e, 0x65, 0x77, 0x20, 0x59, 0x6f, 0x72, 0x6b, 0x22, 0x20, 0x20,
+  0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0x4d, 0x53,
+  0x20, 0x53, 0x65, 0x72, 0x69, 0x66, 0x22, 0x0d, 0x0a, 0x4d, 0x61, 0x63,
+  0x3a, 0x53, 0x79, 0x6d, 0x62, 0x6f, 0x6c, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x53, 0x79,
+  0x6d, 0x62, 0x6f, 0x6c, 0x20, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f,
+  0x6e, 0x65, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x54, 0x69, 0x6d, 0x65,
+  0x73, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e,
+  0x20, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0x54, 0x69, 0x6d, 0x65, 0x73, 0x20,
+  0x4e, 0x65, 0x77, 0x20, 0x52, 0x6f, 0x6d, 0x61, 0x6e, 0x22, 0x20, 0x31,
+  0x34, 0x3d, 0x3e, 0x31, 0x32, 0x20, 0x31, 0x38, 0x3d, 0x3e, 0x31, 0x34,
+  0x20, 0x32, 0x34, 0x3d, 0x3e, 0x31, 0x38, 0x20, 0x33, 0x30, 0x3d, 0x3e,
+  0x32, 0x34, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x50, 0x61, 0x6c, 0x61,
+  0x74, 0x69, 0x6e, 0x6f, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e,
+  0x20, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0x54, 0x69, 0x6d, 0x65, 0x73, 0x20,
+  0x4e, 0x65, 0x77, 0x20, 0x52, 0x6f, 0x6d, 0x61, 0x6e, 0x22, 0x0d, 0x0a,
+  0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x48, 0x65, 0x72, 0x65, 0x20,
+  0x61, 0x72, 0x65, 0x20, 0x73, 0x6f, 0x6d, 0x65, 0x20, 0x74, 0x79, 0x70,
+  0x69, 0x63, 0x61, 0x6c, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67,
+  0x73, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x73, 0x74,
+  0x61, 0x6e, 0x64, 0x61, 0x72, 0x64, 0x20, 0x57, 0x69, 0x6e, 0x64, 0x6f,
+  0x77, 0x73, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x73, 0x3a, 0x0d, 0x0a, 0x3b,
+  0x0d, 0x0a, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x41, 0x72, 0x69, 0x61,
+  0x6c, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x48, 0x65, 0x6c,
+  0x76, 0x65, 0x74, 0x69, 0x63, 0x61, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a,
+  0x22, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65, 0x72, 0x22, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63,
+  0x3a, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65, 0x72, 0x0d, 0x0a, 0x57, 0x69,
+  0x6e, 0x3a, 0x22, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65, 0x72, 0x20, 0x4e,
+  0x65, 0x77, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d,
+  0x61, 0x63, 0x3a, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65, 0x72, 0x0d, 0x0a,
+  0x57, 0x69, 0x6e, 0x3a, 0x22, 0x4d, 0x53, 0x20, 0x53, 0x65, 0x72, 0x69,
+  0x66, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e,
+  0x20, 0x4d, 0x61, 0x63, 0x3a, 0x22, 0x4e, 0x65, 0x77, 0x20, 0x59, 0x6f,
+  0x72, 0x6b, 0x22, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0x4d, 0x53,
+  0x20, 0x53, 0x61, 0x6e, 0x73, 0x20, 0x53, 0x65, 0x72, 0x69, 0x66, 0x22,
+  0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x47, 0x65,
+  0x6e, 0x65, 0x76, 0x61, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x53, 0x79,
+  0x6d, 0x62, 0x6f, 0x6c, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x53,
+  0x79, 0x6d, 0x62, 0x6f, 0x6c, 0x20, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e,
+  0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x53, 0x79, 0x73,
+  0x74, 0x65, 0x6d, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x43, 0x68,
+  0x69, 0x63, 0x61, 0x67, 0x6f, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x54,
+  0x65, 0x72, 0x6d, 0x69, 0x6e, 0x61, 0x6c, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a,
+  0x4d, 0x6f, 0x6e, 0x61, 0x63, 0x6f, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a,
+  0x22, 0x54, 0x69, 0x6d, 0x65, 0x73, 0x20, 0x4e, 0x65, 0x77, 0x20, 0x52,
+  0x6f, 0x6d, 0x61, 0x6e, 0x22, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63,
+  0x3a, 0x22, 0x54, 0x69, 0x6d, 0x65, 0x73, 0x22, 0x20, 0x31, 0x32, 0x3d,
+  0x3e, 0x31, 0x34, 0x20, 0x31, 0x34, 0x3d, 0x3e, 0x31, 0x38, 0x20, 0x31,
+  0x38, 0x3d, 0x3e, 0x32, 0x34, 0x20, 0x32, 0x34, 0x3d, 0x3e, 0x33, 0x30,
+  0x0d, 0x0a, 0x0d, 0x0a, 0x3b, 0x20, 0x4e, 0x6f, 0x74, 0x65, 0x3a, 0x20,
+  0x57, 0x68, 0x65, 0x6e, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67,
+  0x20, 0x66, 0x72, 0x6f, 0x6d, 0x20, 0x57, 0x69, 0x6e, 0x64, 0x6f, 0x77,
+  0x73, 0x20, 0x74, 0x6f, 0x20, 0x4d, 0x61, 0x63, 0x69, 0x6e, 0x74, 0x6f,
+  0x73, 0x68, 0x2c, 0x20, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65, 0x72, 0x20,
+  0x61, 0x6e, 0x64, 0x20, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65, 0x72, 0x20,
+  0x4e, 0x65, 0x77, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x6d, 0x61, 0x70, 0x20,
+  0x6f, 0x6e, 0x74, 0x6f, 0x20, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65, 0x72,
+  0x2e, 0x20, 0x20, 0x57, 0x68, 0x65, 0x6e, 0x20, 0x63, 0x6f, 0x6d, 0x69,
+  0x6e, 0x67, 0x20, 0x62, 0x61, 0x63, 0x6b, 0x20, 0x74, 0x6f, 0x20, 0x57,
+  0x69, 0x6e, 0x64, 0x6f, 0x77, 0x73, 0x20, 0x6f, 0x6e, 0x6c, 0x79, 0x20,
+  0x43, 0x6f, 0x75, 0x72, 0x69, 0x65, 0x72, 0x20, 0x4e, 0x65, 0x77, 0x0d,
+  0x0a, 0x3b, 0x20, 0x77, 0x69, 0x6c, 0x6c, 0x20, 0x62, 0x65, 0x20, 0x75,
+  0x73, 0x65, 0x64, 0x2e, 0x0d, 0x0a, 0x0d, 0x0a, 0x3b, 0x20, 0x4a, 0x61,
+  0x70, 0x61, 0x6e, 0x65, 0x73, 0x65, 0x20, 0x46, 0x6f, 0x6e, 0x74, 0x20,
+  0x4d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x73, 0x0d, 0x0a, 0x3b, 0x20,
+  0x0d, 0x0a, 0x3b, 0x20, 0x54, 0x68, 0x65, 0x20, 0x4d, 0x61, 0x63, 0x69,
+  0x6e, 0x74, 0x6f, 0x73, 0x68, 0x20, 0x4a, 0x61, 0x70, 0x61, 0x6e, 0x65,
+  0x73, 0x65, 0x20, 0x4f, 0x73, 0x61, 0x6b, 0x61, 0x20, 0x66, 0x6f, 0x6e,
+  0x74, 0x20, 0x69, 0x73, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x65, 0x64, 0x20,
+  0x74, 0x6f, 0x20, 0x61, 0x20, 0x57, 0x69, 0x6e, 0x64, 0x6f, 0x77, 0x73,
+  0x20, 0x66, 0x6f, 0x6e, 0x74, 0x2c, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x0d,
+  0x0a, 0x3b, 0x20, 0x61, 0x6c, 0x6c, 0x20, 0x57, 0x69, 0x6e, 0x64, 0x6f,
+  0x77, 0x73, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x73, 0x20, 0x61, 0x72, 0x65,
+  0x20, 0x6d, 0x61, 0x70, 0x70, 0x65, 0x64, 0x20, 0x74, 0x6f, 0x20, 0x4d,
+  0x61, 0x63, 0x69, 0x6e, 0x74, 0x6f, 0x73, 0x68, 0x27, 0x73, 0x20, 0x4f,
+  0x73, 0x61, 0x6b, 0x61, 0x2e, 0x20, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e,
+  0x6f, 0x6e, 0x65, 0x20, 0x69, 0x73, 0x20, 0x75, 0x73, 0x65, 0x64, 0x0d,
+  0x0a, 0x3b, 0x20, 0x62, 0x65, 0x63, 0x61, 0x75, 0x73, 0x65, 0x20, 0x6f,
+  0x6e, 0x6c, 0x79, 0x20, 0x52, 0x6f, 0x6d, 0x61, 0x6e, 0x20, 0x66, 0x6f,
+  0x6e, 0x74, 0x73, 0x20, 0x6e, 0x65, 0x65, 0x64, 0x20, 0x75, 0x70, 0x70,
+  0x65, 0x72, 0x2d, 0x41, 0x53, 0x43, 0x49, 0x49, 0x20, 0x63, 0x68, 0x61,
+  0x72, 0x61, 0x63, 0x74, 0x65, 0x72, 0x73, 0x20, 0x6d, 0x61, 0x70, 0x70,
+  0x65, 0x64, 0x2e, 0x20, 0x20, 0x54, 0x6f, 0x20, 0x70, 0x72, 0x65, 0x76,
+  0x65, 0x6e, 0x74, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x6d, 0x61, 0x70, 0x70,
+  0x69, 0x6e, 0x67, 0x20, 0x6f, 0x66, 0x20, 0x61, 0x6e, 0x79, 0x20, 0x61,
+  0x64, 0x64, 0x69, 0x74, 0x69, 0x6f, 0x6e, 0x61, 0x6c, 0x20, 0x4a, 0x61,
+  0x70, 0x61, 0x6e, 0x65, 0x73, 0x65, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x73,
+  0x2c, 0x20, 0x61, 0x64, 0x64, 0x20, 0x74, 0x68, 0x65, 0x6d, 0x20, 0x74,
+  0x6f, 0x20, 0x74, 0x68, 0x69, 0x73, 0x20, 0x6c, 0x69, 0x73, 0x74, 0x2e,
+  0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x4e, 0x6f, 0x74, 0x65, 0x3a,
+  0x20, 0x49, 0x66, 0x20, 0x79, 0x6f, 0x75, 0x20, 0x64, 0x6f, 0x20, 0x6e,
+  0x6f, 0x74, 0x20, 0x68, 0x61, 0x76, 0x65, 0x20, 0x61, 0x20, 0x4a, 0x61,
+  0x70, 0x61, 0x6e, 0x65, 0x73, 0x65, 0x20, 0x73, 0x79, 0x73, 0x74, 0x65,
+  0x6d, 0x2c, 0x20, 0x74, 0x68, 0x65, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x20,
+  0x6e, 0x61, 0x6d, 0x65, 0x73, 0x20, 0x62, 0x65, 0x6c, 0x6f, 0x77, 0x20,
+  0x0d, 0x0a, 0x3b, 0x20, 0x77, 0x69, 0x6c, 0x6c, 0x20, 0x61, 0x70, 0x70,
+  0x65, 0x61, 0x72, 0x20, 0x74, 0x6f, 0x20, 0x62, 0x65, 0x20, 0x75, 0x6e,
+  0x72, 0x65, 0x61, 0x64, 0x61, 0x62, 0x6c, 0x65, 0x2e, 0x0d, 0x0a, 0x0d,
+  0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x4f, 0x73, 0x61, 0x6b, 0x61, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20,
+  0x57, 0x69, 0x6e, 0x3a, 0x22, 0x82, 0x6c, 0x82, 0x72, 0x20, 0x83, 0x53,
+  0x83, 0x56, 0x83, 0x62, 0x83, 0x4e, 0x22, 0x20, 0x4d, 0x61, 0x70, 0x20,
+  0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a,
+  0x22, 0x82, 0x6c, 0x82, 0x72, 0x20, 0x83, 0x53, 0x83, 0x56, 0x83, 0x62,
+  0x83, 0x4e, 0x22, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x4f,
+  0x73, 0x61, 0x6b, 0x61, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e,
+  0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0x82, 0x6c, 0x82, 0x72,
+  0x20, 0x96, 0xbe, 0x92, 0xa9, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d,
+  0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x4f, 0x73, 0x61, 0x6b, 0x61, 0x20,
+  0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x57, 0x69,
+  0x6e, 0x3a, 0x22, 0x95, 0x57, 0x8f, 0x80, 0x83, 0x53, 0x83, 0x56, 0x83,
+  0x62, 0x83, 0x4e, 0x22, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63,
+  0x3a, 0x4f, 0x73, 0x61, 0x6b, 0x61, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e,
+  0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0x95, 0x57,
+  0x8f, 0x80, 0x96, 0xbe, 0x92, 0xa9, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x4f, 0x73, 0x61, 0x6b,
+  0x61, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a,
+  0x57, 0x69, 0x6e, 0x3a, 0x22, 0x96, 0xbe, 0x92, 0xa9, 0x22, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d,
+  0x61, 0x63, 0x3a, 0x4f, 0x73, 0x61, 0x6b, 0x61, 0x20, 0x4d, 0x61, 0x70,
+  0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x0d, 0x0a, 0x3b, 0x20, 0x4b,
+  0x6f, 0x72, 0x65, 0x61, 0x6e, 0x20, 0x46, 0x6f, 0x6e, 0x74, 0x20, 0x4d,
+  0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x73, 0x0d, 0x0a, 0x4d, 0x61, 0x63,
+  0x3a, 0x41, 0x70, 0x70, 0x6c, 0x65, 0x47, 0x6f, 0x74, 0x68, 0x69, 0x63,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a,
+  0x22, 0xb1, 0xbc, 0xb8, 0xb2, 0x22, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e,
+  0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x53, 0x65, 0x6f,
+  0x75, 0x6c, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xb1, 0xc3, 0xbc,
+  0xad, 0x22, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d,
+  0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x41, 0x70, 0x70, 0x6c, 0x65, 0x4d, 0x79,
+  0x75, 0x6e, 0x67, 0x69, 0x6f, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20,
+  0x57, 0x69, 0x6e, 0x3a, 0x22, 0xb5, 0xb8, 0xbf, 0xf2, 0x22, 0x20, 0x4d,
+  0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x4d, 0x61, 0x63,
+  0x3a, 0x22, 0xc7, 0xd1, 0xb0, 0xad, 0xc3, 0xbc, 0x22, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a,
+  0x22, 0xb9, 0xd9, 0xc5, 0xc1, 0x22, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e,
+  0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22,
+  0xb1, 0xbc, 0xb8, 0xb2, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x41, 0x70,
+  0x70, 0x6c, 0x65, 0x47, 0x6f, 0x74, 0x68, 0x69, 0x63, 0x20, 0x4d, 0x61,
+  0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a,
+  0x22, 0xb1, 0xbc, 0xb8, 0xb2, 0xc3, 0xbc, 0x22, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x41,
+  0x70, 0x70, 0x6c, 0x65, 0x47, 0x6f, 0x74, 0x68, 0x69, 0x63, 0x20, 0x4d,
+  0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e,
+  0x3a, 0x22, 0xb1, 0xc3, 0xbc, 0xad, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a,
+  0x53, 0x65, 0x6f, 0x75, 0x6c, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f,
+  0x6e, 0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xb1, 0xc3, 0xbc,
+  0xad, 0xc3, 0xbc, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x53, 0x65, 0x6f, 0x75, 0x6c,
+  0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x22, 0xb5, 0xb8, 0xbf, 0xf2, 0x22, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61,
+  0x63, 0x3a, 0x41, 0x70, 0x70, 0x6c, 0x65, 0x4d, 0x79, 0x75, 0x6e, 0x67,
+  0x69, 0x6f, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d,
+  0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xb5, 0xb8, 0xbf, 0xf2, 0xc3, 0xbc,
+  0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20,
+  0x4d, 0x61, 0x63, 0x3a, 0x41, 0x70, 0x70, 0x6c, 0x65, 0x4d, 0x79, 0x75,
+  0x6e, 0x67, 0x69, 0x6f, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e,
+  0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xb9, 0xd9, 0xc5, 0xc1,
+  0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d,
+  0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x22, 0xc7, 0xd1, 0xb0, 0xad, 0xc3,
+  0xbc, 0x22, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d,
+  0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xb9, 0xd9, 0xc5, 0xc1, 0xc3, 0xbc,
+  0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20,
+  0x4d, 0x61, 0x63, 0x3a, 0x22, 0xc7, 0xd1, 0xb0, 0xad, 0xc3, 0xbc, 0x22,
+  0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x0d,
+  0x0a, 0x3b, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a,
+  0x3b, 0x20, 0x43, 0x48, 0x41, 0x52, 0x41, 0x43, 0x54, 0x45, 0x52, 0x20,
+  0x4d, 0x41, 0x50, 0x50, 0x49, 0x4e, 0x47, 0x53, 0x0d, 0x0a, 0x3b, 0x0d,
+  0x0a, 0x3b, 0x20, 0x43, 0x68, 0x61, 0x72, 0x61, 0x63, 0x74, 0x65, 0x72,
+  0x20, 0x6d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x20, 0x65, 0x6e, 0x73,
+  0x75, 0x72, 0x65, 0x73, 0x20, 0x74, 0x68, 0x61, 0x74, 0x20, 0x63, 0x68,
+  0x61, 0x72, 0x61, 0x63, 0x74, 0x65, 0x72, 0x73, 0x20, 0x73, 0x75, 0x63,
+  0x68, 0x20, 0x61, 0x73, 0x20, 0x62, 0x75, 0x6c, 0x6c, 0x65, 0x74, 0x73,
+  0x2c, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x71, 0x75, 0x6f, 0x74, 0x65, 0x20,
+  0x6d, 0x61, 0x72, 0x6b, 0x73, 0x2c, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x61,
+  0x63, 0x63, 0x65, 0x6e, 0x74, 0x65, 0x64, 0x20, 0x63, 0x68, 0x61, 0x72,
+  0x61, 0x63, 0x74, 0x65, 0x72, 0x73, 0x20, 0x61, 0x6c, 0x77, 0x61, 0x79,
+  0x73, 0x20, 0x61, 0x70, 0x70, 0x65, 0x61, 0x72, 0x20, 0x63, 0x6f, 0x72,
+  0x72, 0x65, 0x63, 0x74, 0x6c, 0x79, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x77,
+  0x68, 0x65, 0x6e, 0x20, 0x74, 0x65, 0x78, 0x74, 0x20, 0x69, 0x73, 0x20,
+  0x6d, 0x6f, 0x76, 0x65, 0x64, 0x20, 0x66, 0x72, 0x6f, 0x6d, 0x20, 0x6f,
+  0x6e, 0x65, 0x20, 0x70, 0x6c, 0x61, 0x74, 0x66, 0x6f, 0x72, 0x6d, 0x20,
+  0x74, 0x6f, 0x20, 0x61, 0x6e, 0x6f, 0x74, 0x68, 0x65, 0x72, 0x2e, 0x20,
+  0x20, 0x57, 0x68, 0x65, 0x6e, 0x20, 0x61, 0x20, 0x0d, 0x0a, 0x3b, 0x20,
+  0x63, 0x68, 0x61, 0x72, 0x61, 0x63, 0x74, 0x65, 0x72, 0x20, 0x69, 0x73,
+  0x20, 0x6d, 0x61, 0x70, 0x70, 0x65, 0x64, 0x2c, 0x20, 0x61, 0x20, 0x64,
+  0x69, 0x66, 0x66, 0x65, 0x72, 0x65, 0x6e, 0x74, 0x20, 0x41, 0x53, 0x43,
+  0x49, 0x49, 0x20, 0x76, 0x61, 0x6c, 0x75, 0x65, 0x20, 0x69, 0x73, 0x20,
+  0x73, 0x75, 0x62, 0x73, 0x74, 0x69, 0x74, 0x75, 0x74, 0x65, 0x64, 0x20,
+  0x0d, 0x0a, 0x3b, 0x20, 0x69, 0x6e, 0x20, 0x6f, 0x72, 0x64, 0x65, 0x72,
+  0x20, 0x74, 0x6f, 0x20, 0x70, 0x72, 0x65, 0x73, 0x65, 0x72, 0x76, 0x65,
+  0x20, 0x74, 0x68, 0x65, 0x20, 0x61, 0x70, 0x70, 0x65, 0x61, 0x72, 0x61,
+  0x6e, 0x63, 0x65, 0x20, 0x6f, 0x66, 0x20, 0x74, 0x68, 0x65, 0x20, 0x63,
+  0x68, 0x61, 0x72, 0x61, 0x63, 0x74, 0x65, 0x72, 0x2e, 0x20, 0x20, 0x0d,
+  0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x43, 0x68, 0x61, 0x72, 0x61, 0x63,
+  0x74, 0x65, 0x72, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x73,
+  0x20, 0x61, 0x72, 0x65, 0x20, 0x75, 0x73, 0x65, 0x64, 0x20, 0x66, 0x6f,
+  0x72, 0x20, 0x61, 0x6c, 0x6c, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x73, 0x20,
+  0x45, 0x58, 0x43, 0x45, 0x50, 0x54, 0x20, 0x74, 0x68, 0x6f, 0x73, 0x65,
+  0x20, 0x64, 0x65, 0x63, 0x6c, 0x61, 0x72, 0x65, 0x64, 0x20, 0x0d, 0x0a,
+  0x3b, 0x20, 0x61, 0x62, 0x6f, 0x76, 0x65, 0x20, 0x61, 0x73, 0x20, 0x4d,
+  0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x2e, 0x20, 0x20, 0x0d, 0x0a,
+  0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x54, 0x68, 0x65, 0x20, 0x66, 0x6f, 0x72,
+  0x6d, 0x61, 0x74, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x63, 0x68, 0x61, 0x72,
+  0x61, 0x63, 0x74, 0x65, 0x72, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x69, 0x6e,
+  0x67, 0x73, 0x20, 0x69, 0x73, 0x3a, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b,
+  0x20, 0x50, 0x6c, 0x61, 0x74, 0x66, 0x6f, 0x72, 0x6d, 0x3a, 0x20, 0x3d,
+  0x3e, 0x20, 0x50, 0x6c, 0x61, 0x74, 0x66, 0x6f, 0x72, 0x6d, 0x3a, 0x20,
+  0x20, 0x6f, 0x6c, 0x64, 0x43, 0x68, 0x61, 0x72, 0x20, 0x3d, 0x3e, 0x20,
+  0x6f, 0x6c, 0x64, 0x43, 0x68, 0x61, 0x72, 0x20, 0x2e, 0x2e, 0x2e, 0x0d,
+  0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x54, 0x68, 0x65, 0x20, 0x66, 0x6f,
+  0x6c, 0x6c, 0x6f, 0x77, 0x69, 0x6e, 0x67, 0x20, 0x74, 0x61, 0x62, 0x6c,
+  0x65, 0x20, 0x70, 0x72, 0x6f, 0x76, 0x69, 0x64, 0x65, 0x73, 0x20, 0x61,
+  0x20, 0x66, 0x75, 0x6c, 0x6c, 0x20, 0x73, 0x65, 0x74, 0x20, 0x6f, 0x66,
+  0x20, 0x62, 0x69, 0x2d, 0x64, 0x69, 0x72, 0x65, 0x63, 0x74, 0x69, 0x6f,
+  0x6e, 0x61, 0x6c, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x6d, 0x61, 0x70, 0x70,
+  0x69, 0x6e, 0x67, 0x73, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x61, 0x6c, 0x6c,
+  0x20, 0x41, 0x53, 0x43, 0x49, 0x49, 0x20, 0x76, 0x61, 0x6c, 0x75, 0x65,
+  0x73, 0x20, 0x62, 0x65, 0x74, 0x77, 0x65, 0x65, 0x6e, 0x20, 0x31, 0x32,
+  0x38, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x32, 0x35, 0x35, 0x2e, 0x0d, 0x0a,
+  0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x4e, 0x6f, 0x74, 0x65, 0x3a, 0x20, 0x53,
+  0x6f, 0x6d, 0x65, 0x20, 0x63, 0x68, 0x61, 0x72, 0x61, 0x63, 0x74, 0x65,
+  0x72, 0x73, 0x20, 0x61, 0x72, 0x65, 0x20, 0x6e, 0x6f, 0x74, 0x20, 0x61,
+  0x76, 0x61, 0x69, 0x6c, 0x61, 0x62, 0x6c, 0x65, 0x20, 0x69, 0x6e, 0x20,
+  0x62, 0x6f, 0x74, 0x68, 0x20, 0x63, 0x68, 0x61, 0x72, 0x61, 0x63, 0x74,
+  0x65, 0x72, 0x20, 0x73, 0x65, 0x74, 0x73, 0x2e, 0x20, 0x0d, 0x0a, 0x3b,
+  0x20, 0x48, 0x6f, 0x77, 0x65, 0x76, 0x65, 0x72, 0x2c, 0x20, 0x74, 0x68,
+  0x65, 0x20, 0x62, 0x69, 0x2d, 0x64, 0x69, 0x72, 0x65, 0x63, 0x74, 0x69,
+  0x6f, 0x6e, 0x61, 0x6c, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67,
+  0x20, 0x74, 0x61, 0x62, 0x6c, 0x65, 0x20, 0x62, 0x65, 0x6c, 0x6f, 0x77,
+  0x20, 0x70, 0x72, 0x65, 0x73, 0x65, 0x72, 0x76, 0x65, 0x73, 0x20, 0x74,
+  0x68, 0x65, 0x73, 0x65, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x63, 0x68, 0x61,
+  0x72, 0x61, 0x63, 0x74, 0x65, 0x72, 0x73, 0x20, 0x65, 0x76, 0x65, 0x6e,
+  0x20, 0x69, 0x66, 0x20, 0x74, 0x68, 0x65, 0x79, 0x20, 0x61, 0x72, 0x65,
+  0x20, 0x6d, 0x61, 0x70, 0x70, 0x65, 0x64, 0x20, 0x74, 0x6f, 0x20, 0x61,
+  0x20, 0x64, 0x69, 0x66, 0x66, 0x65, 0x72, 0x65, 0x6e, 0x74, 0x20, 0x70,
+  0x6c, 0x61, 0x74, 0x66, 0x6f, 0x72, 0x6d, 0x20, 0x61, 0x6e, 0x64, 0x20,
+  0x0d, 0x0a, 0x3b, 0x20, 0x6c, 0x61, 0x74, 0x65, 0x72, 0x20, 0x72, 0x65,
+  0x2d, 0x6d, 0x61, 0x70, 0x70, 0x65, 0x64, 0x20, 0x62, 0x61, 0x63, 0x6b,
+  0x20, 0x74, 0x6f, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6f, 0x72, 0x69, 0x67,
+  0x69, 0x6e, 0x61, 0x6c, 0x20, 0x70, 0x6c, 0x61, 0x74, 0x66, 0x6f, 0x72,
+  0x6d, 0x2e, 0x0d, 0x0a, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d,
+  0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x31, 0x32, 0x38, 0x3d, 0x3e,
+  0x31, 0x39, 0x36, 0x20, 0x31, 0x32, 0x39, 0x3d, 0x3e, 0x31, 0x39, 0x37,
+  0x20, 0x31, 0x33, 0x30, 0x3d, 0x3e, 0x31, 0x39, 0x39, 0x20, 0x31, 0x33,
+  0x31, 0x3d, 0x3e, 0x32, 0x30, 0x31, 0x20, 0x31, 0x33, 0x32, 0x3d, 0x3e,
+  0x32, 0x30, 0x39, 0x20, 0x31, 0x33, 0x33, 0x3d, 0x3e, 0x32, 0x31, 0x34,
+  0x20, 0x31, 0x33, 0x34, 0x3d, 0x3e, 0x32, 0x32, 0x30, 0x20, 0x0d, 0x0a,
+  0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a,
+  0x20, 0x31, 0x33, 0x35, 0x3d, 0x3e, 0x32, 0x32, 0x35, 0x20, 0x31, 0x33,
+  0x36, 0x3d, 0x3e, 0x32, 0x32, 0x34, 0x20, 0x31, 0x33, 0x37, 0x3d, 0x3e,
+  0x32, 0x32, 0x36, 0x20, 0x31, 0x33, 0x38, 0x3d, 0x3e, 0x32, 0x32, 0x38,
+  0x20, 0x31, 0x33, 0x39, 0x3d, 0x3e, 0x32, 0x32, 0x37, 0x20, 0x31, 0x34,
+  0x30, 0x3d, 0x3e, 0x32, 0x32, 0x39, 0x20, 0x31, 0x34, 0x31, 0x3d, 0x3e,
+  0x32, 0x33, 0x31, 0x20, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d,
+  0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x31, 0x34, 0x32, 0x3d, 0x3e,
+  0x32, 0x33, 0x33, 0x20, 0x31, 0x34, 0x33, 0x3d, 0x3e, 0x32, 0x33, 0x32,
+  0x20, 0x31, 0x34, 0x34, 0x3d, 0x3e, 0x32, 0x33, 0x34, 0x20, 0x31, 0x34,
+  0x35, 0x3d, 0x3e, 0x32, 0x33, 0x35, 0x20, 0x31, 0x34, 0x36, 0x3d, 0x3e,
+  0x32, 0x33, 0x37, 0x20, 0x31, 0x34, 0x37, 0x3d, 0x3e, 0x32, 0x33, 0x36,
+  0x20, 0x31, 0x34, 0x38, 0x3d, 0x3e, 0x32, 0x33, 0x38, 0x20, 0x0d, 0x0a,
+  0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a,
+  0x20, 0x31, 0x34, 0x39, 0x3d, 0x3e, 0x32, 0x33, 0x39, 0x20, 0x31, 0x35,
+  0x30, 0x3d, 0x3e, 0x32, 0x34, 0x31, 0x20, 0x31, 0x35, 0x31, 0x3d, 0x3e,
+  0x32, 0x34, 0x33, 0x20, 0x31, 0x35, 0x32, 0x3d, 0x3e, 0x32, 0x34, 0x32,
+  0x20, 0x31, 0x35, 0x33, 0x3d, 0x3e, 0x32, 0x34, 0x34, 0x20, 0x31, 0x35,
+  0x34, 0x3d, 0x3e, 0x32, 0x34, 0x36, 0x20, 0x31, 0x35, 0x35, 0x3d, 0x3e,
+  0x32, 0x34, 0x35, 0x20, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d,
+  0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x31, 0x35, 0x36, 0x3d, 0x3e,
+  0x32, 0x35, 0x30, 0x20, 0x31, 0x35, 0x37, 0x3d, 0x3e, 0x32, 0x34, 0x39,
+  0x20, 0x31, 0x35, 0x38, 0x3d, 0x3e, 0x32, 0x35, 0x31, 0x20, 0x31, 0x35,
+  0x39, 0x3d, 0x3e, 0x32, 0x35, 0x32, 0x20, 0x31, 0x36, 0x30, 0x3d, 0x3e,
+  0x31, 0x33, 0x34, 0x20, 0x31, 0x36, 0x31, 0x3d, 0x3e, 0x31, 0x37, 0x36,
+  0x20, 0x31, 0x36, 0x32, 0x3d, 0x3e, 0x31, 0x36, 0x32, 0x20, 0x0d, 0x0a,
+  0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a,
+  0x20, 0x31, 0x36, 0x33, 0x3d, 0x3e, 0x31, 0x36, 0x33, 0x20, 0x31, 0x36,
+  0x34, 0x3d, 0x3e, 0x31, 0x36, 0x37, 0x20, 0x31, 0x36, 0x35, 0x3d, 0x3e,
+  0x31, 0x34, 0x39, 0x20, 0x31, 0x36, 0x36, 0x3d, 0x3e, 0x31, 0x38, 0x32,
+  0x20, 0x31, 0x36, 0x37, 0x3d, 0x3e, 0x32, 0x32, 0x33, 0x20, 0x31, 0x36,
+  0x38, 0x3d, 0x3e, 0x31, 0x37, 0x34, 0x20, 0x31, 0x36, 0x39, 0x3d, 0x3e,
+  0x31, 0x36, 0x39, 0x20, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d,
+  0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x31, 0x37, 0x30, 0x3d, 0x3e,
+  0x31, 0x35, 0x33, 0x20, 0x31, 0x37, 0x31, 0x3d, 0x3e, 0x31, 0x38, 0x30,
+  0x20, 0x31, 0x37, 0x32, 0x3d, 0x3e, 0x31, 0x36, 0x38, 0x20, 0x31, 0x37,
+  0x33, 0x3d, 0x3e, 0x31, 0x34, 0x31, 0x20, 0x31, 0x37, 0x34, 0x3d, 0x3e,
+  0x31, 0x39, 0x38, 0x20, 0x31, 0x37, 0x35, 0x3d, 0x3e, 0x32, 0x31, 0x36,
+  0x20, 0x31, 0x37, 0x36, 0x3d, 0x3e, 0x31, 0x34, 0x34, 0x20, 0x0d, 0x0a,
+  0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a,
+  0x20, 0x31, 0x37, 0x37, 0x3d, 0x3e, 0x31, 0x37, 0x37, 0x20, 0x31, 0x37,
+  0x38, 0x3d, 0x3e, 0x31, 0x34, 0x33, 0x20, 0x31, 0x37, 0x39, 0x3d, 0x3e,
+  0x31, 0x34, 0x32, 0x20, 0x31, 0x38, 0x30, 0x3d, 0x3e, 0x31, 0x36, 0x35,
+  0x20, 0x31, 0x38, 0x31, 0x3d, 0x3e, 0x31, 0x38, 0x31, 0x20, 0x31, 0x38,
+  0x32, 0x3d, 0x3e, 0x32, 0x34, 0x30, 0x20, 0x31, 0x38, 0x33, 0x3d, 0x3e,
+  0x32, 0x32, 0x31, 0x20, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d,
+  0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x31, 0x38, 0x34, 0x3d, 0x3e,
+  0x32, 0x32, 0x32, 0x20, 0x31, 0x38, 0x35, 0x3d, 0x3e, 0x32, 0x35, 0x34,
+  0x20, 0x31, 0x38, 0x36, 0x3d, 0x3e, 0x31, 0x33, 0x38, 0x20, 0x31, 0x38,
+  0x37, 0x3d, 0x3e, 0x31, 0x37, 0x30, 0x20, 0x31, 0x38, 0x38, 0x3d, 0x3e,
+  0x31, 0x38, 0x36, 0x20, 0x31, 0x38, 0x39, 0x3d, 0x3e, 0x32, 0x35, 0x33,
+  0x20, 0x31, 0x39, 0x30, 0x3d, 0x3e, 0x32, 0x33, 0x30, 0x20, 0x0d, 0x0a,
+  0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a,
+  0x20, 0x31, 0x39, 0x31, 0x3d, 0x3e, 0x32, 0x34, 0x38, 0x20, 0x31, 0x39,
+  0x32, 0x3d, 0x3e, 0x31, 0x39, 0x31, 0x20, 0x31, 0x39, 0x33, 0x3d, 0x3e,
+  0x31, 0x36, 0x31, 0x20, 0x31, 0x39, 0x34, 0x3d, 0x3e, 0x31, 0x37, 0x32,
+  0x20, 0x31, 0x39, 0x35, 0x3d, 0x3e, 0x31, 0x37, 0x35, 0x20, 0x31, 0x39,
+  0x36, 0x3d, 0x3e, 0x31, 0x33, 0x31, 0x20, 0x31, 0x39, 0x37, 0x3d, 0x3e,
+  0x31, 0x38, 0x38, 0x20, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d,
+  0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x31, 0x39, 0x38, 0x3d, 0x3e,
+  0x32, 0x30, 0x38, 0x20, 0x31, 0x39, 0x39, 0x3d, 0x3e, 0x31, 0x37, 0x31,
+  0x20, 0x32, 0x30, 0x30, 0x3d, 0x3e, 0x31, 0x38, 0x37, 0x20, 0x32, 0x30,
+  0x31, 0x3d, 0x3e, 0x31, 0x33, 0x33, 0x20, 0x32, 0x30, 0x32, 0x3d, 0x3e,
+  0x31, 0x36, 0x30, 0x20, 0x32, 0x30, 0x33, 0x3d, 0x3e, 0x31, 0x39, 0x32,
+  0x20, 0x32, 0x30, 0x34, 0x3d, 0x3e, 0x31, 0x39, 0x35, 0x20, 0x0d, 0x0a,
+  0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a,
+  0x20, 0x32, 0x30, 0x35, 0x3d, 0x3e, 0x32, 0x31, 0x33, 0x20, 0x32, 0x30,
+  0x36, 0x3d, 0x3e, 0x31, 0x34, 0x30, 0x20, 0x32, 0x30, 0x37, 0x3d, 0x3e,
+  0x31, 0x35, 0x36, 0x20, 0x32, 0x30, 0x38, 0x3d, 0x3e, 0x31, 0x37, 0x33,
+  0x20, 0x32, 0x30, 0x39, 0x3d, 0x3e, 0x31, 0x35, 0x31, 0x20, 0x32, 0x31,
+  0x30, 0x3d, 0x3e, 0x31, 0x34, 0x37, 0x20, 0x32, 0x31, 0x31, 0x3d, 0x3e,
+  0x31, 0x34, 0x38, 0x20, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d,
+  0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x32, 0x31, 0x32, 0x3d, 0x3e,
+  0x31, 0x34, 0x35, 0x20, 0x32, 0x31, 0x33, 0x3d, 0x3e, 0x31, 0x34, 0x36,
+  0x20, 0x32, 0x31, 0x34, 0x3d, 0x3e, 0x32, 0x34, 0x37, 0x20, 0x32, 0x31,
+  0x35, 0x3d, 0x3e, 0x32, 0x31, 0x35, 0x20, 0x32, 0x31, 0x36, 0x3d, 0x3e,
+  0x32, 0x35, 0x35, 0x20, 0x32, 0x31, 0x37, 0x3d, 0x3e, 0x31, 0x35, 0x39,
+  0x20, 0x32, 0x31, 0x38, 0x3d, 0x3e, 0x31, 0x35, 0x38, 0x20, 0x0d, 0x0a,
+  0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a,
+  0x20, 0x32, 0x31, 0x39, 0x3d, 0x3e, 0x31, 0x32, 0x38, 0x20, 0x32, 0x32,
+  0x30, 0x3d, 0x3e, 0x31, 0x33, 0x39, 0x20, 0x32, 0x32, 0x31, 0x3d, 0x3e,
+  0x31, 0x35, 0x35, 0x20, 0x32, 0x32, 0x32, 0x3d, 0x3e, 0x31, 0x32, 0x38,
+  0x20, 0x32, 0x32, 0x33, 0x3d, 0x3e, 0x31, 0x32, 0x39, 0x20, 0x32, 0x32,
+  0x34, 0x3d, 0x3e, 0x31, 0x33, 0x35, 0x20, 0x32, 0x32, 0x35, 0x3d, 0x3e,
+  0x31, 0x38, 0x33, 0x20, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d,
+  0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x32, 0x32, 0x36, 0x3d, 0x3e,
+  0x31, 0x33, 0x30, 0x20, 0x32, 0x32, 0x37, 0x3d, 0x3e, 0x31, 0x33, 0x32,
+  0x20, 0x32, 0x32, 0x38, 0x3d, 0x3e, 0x31, 0x33, 0x37, 0x20, 0x32, 0x32,
+  0x39, 0x3d, 0x3e, 0x31, 0x39, 0x34, 0x20, 0x32, 0x33, 0x30, 0x3d, 0x3e,
+  0x32, 0x30, 0x32, 0x20, 0x32, 0x33, 0x31, 0x3d, 0x3e, 0x31, 0x39, 0x33,
+  0x20, 0x32, 0x33, 0x32, 0x3d, 0x3e, 0x32, 0x30, 0x33, 0x20, 0x0d, 0x0a,
+  0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a,
+  0x20, 0x32, 0x33, 0x33, 0x3d, 0x3e, 0x32, 0x30, 0x30, 0x20, 0x32, 0x33,
+  0x34, 0x3d, 0x3e, 0x32, 0x30, 0x35, 0x20, 0x32, 0x33, 0x35, 0x3d, 0x3e,
+  0x32, 0x30, 0x36, 0x20, 0x32, 0x33, 0x36, 0x3d, 0x3e, 0x32, 0x30, 0x37,
+  0x20, 0x32, 0x33, 0x37, 0x3d, 0x3e, 0x32, 0x30, 0x34, 0x20, 0x32, 0x33,
+  0x38, 0x3d, 0x3e, 0x32, 0x31, 0x31, 0x20, 0x32, 0x33, 0x39, 0x3d, 0x3e,
+  0x32, 0x31, 0x32, 0x20, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d,
+  0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x32, 0x34, 0x30, 0x3d, 0x3e,
+  0x31, 0x35, 0x37, 0x20, 0x32, 0x34, 0x31, 0x3d, 0x3e, 0x32, 0x31, 0x30,
+  0x20, 0x32, 0x34, 0x32, 0x3d, 0x3e, 0x32, 0x31, 0x38, 0x20, 0x32, 0x34,
+  0x33, 0x3d, 0x3e, 0x32, 0x31, 0x39, 0x20, 0x32, 0x34, 0x34, 0x3d, 0x3e,
+  0x32, 0x31, 0x37, 0x20, 0x32, 0x34, 0x35, 0x3d, 0x3e, 0x31, 0x36, 0x36,
+  0x20, 0x32, 0x34, 0x36, 0x3d, 0x3e, 0x31, 0x33, 0x36, 0x20, 0x0d, 0x0a,
+  0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a,
+  0x20, 0x32, 0x34, 0x37, 0x3d, 0x3e, 0x31, 0x35, 0x32, 0x20, 0x32, 0x34,
+  0x38, 0x3d, 0x3e, 0x31, 0x35, 0x30, 0x20, 0x32, 0x34, 0x39, 0x3d, 0x3e,
+  0x31, 0x35, 0x34, 0x20, 0x32, 0x35, 0x30, 0x3d, 0x3e, 0x31, 0x37, 0x38,
+  0x20, 0x32, 0x35, 0x31, 0x3d, 0x3e, 0x31, 0x39, 0x30, 0x20, 0x32, 0x35,
+  0x32, 0x3d, 0x3e, 0x31, 0x38, 0x34, 0x20, 0x32, 0x35, 0x33, 0x3d, 0x3e,
+  0x31, 0x38, 0x39, 0x20, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x3d,
+  0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x32, 0x35, 0x34, 0x3d, 0x3e,
+  0x31, 0x37, 0x39, 0x20, 0x32, 0x35, 0x35, 0x3d, 0x3e, 0x31, 0x38, 0x35,
+  0x20, 0x0d, 0x0a, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e,
+  0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x31, 0x32, 0x38, 0x3d, 0x3e, 0x32,
+  0x31, 0x39, 0x20, 0x31, 0x32, 0x39, 0x3d, 0x3e, 0x32, 0x32, 0x33, 0x20,
+  0x31, 0x33, 0x30, 0x3d, 0x3e, 0x32, 0x32, 0x36, 0x20, 0x31, 0x33, 0x31,
+  0x3d, 0x3e, 0x31, 0x39, 0x36, 0x20, 0x31, 0x33, 0x32, 0x3d, 0x3e, 0x32,
+  0x32, 0x37, 0x20, 0x31, 0x33, 0x33, 0x3d, 0x3e, 0x32, 0x30, 0x31, 0x20,
+  0x31, 0x33, 0x34, 0x3d, 0x3e, 0x31, 0x36, 0x30, 0x20, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20,
+  0x31, 0x33, 0x35, 0x3d, 0x3e, 0x32, 0x32, 0x34, 0x20, 0x31, 0x33, 0x36,
+  0x3d, 0x3e, 0x32, 0x34, 0x36, 0x20, 0x31, 0x33, 0x37, 0x3d, 0x3e, 0x32,
+  0x32, 0x38, 0x20, 0x31, 0x33, 0x38, 0x3d, 0x3e, 0x31, 0x38, 0x36, 0x20,
+  0x31, 0x33, 0x39, 0x3d, 0x3e, 0x32, 0x32, 0x30, 0x20, 0x31, 0x34, 0x30,
+  0x3d, 0x3e, 0x32, 0x30, 0x36, 0x20, 0x31, 0x34, 0x31, 0x3d, 0x3e, 0x31,
+  0x37, 0x33, 0x20, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e,
+  0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x31, 0x34, 0x32, 0x3d, 0x3e, 0x31,
+  0x37, 0x39, 0x20, 0x31, 0x34, 0x33, 0x3d, 0x3e, 0x31, 0x37, 0x38, 0x20,
+  0x31, 0x34, 0x34, 0x3d, 0x3e, 0x31, 0x37, 0x36, 0x20, 0x31, 0x34, 0x35,
+  0x3d, 0x3e, 0x32, 0x31, 0x32, 0x20, 0x31, 0x34, 0x36, 0x3d, 0x3e, 0x32,
+  0x31, 0x33, 0x20, 0x31, 0x34, 0x37, 0x3d, 0x3e, 0x32, 0x31, 0x30, 0x20,
+  0x31, 0x34, 0x38, 0x3d, 0x3e, 0x32, 0x31, 0x31, 0x20, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20,
+  0x31, 0x34, 0x39, 0x3d, 0x3e, 0x31, 0x36, 0x35, 0x20, 0x31, 0x35, 0x30,
+  0x3d, 0x3e, 0x32, 0x34, 0x38, 0x20, 0x31, 0x35, 0x31, 0x3d, 0x3e, 0x32,
+  0x30, 0x39, 0x20, 0x31, 0x35, 0x32, 0x3d, 0x3e, 0x32, 0x34, 0x37, 0x20,
+  0x31, 0x35, 0x33, 0x3d, 0x3e, 0x31, 0x37, 0x30, 0x20, 0x31, 0x35, 0x34,
+  0x3d, 0x3e, 0x32, 0x34, 0x39, 0x20, 0x31, 0x35, 0x35, 0x3d, 0x3e, 0x32,
+  0x32, 0x31, 0x20, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e,
+  0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x31, 0x35, 0x36, 0x3d, 0x3e, 0x32,
+  0x30, 0x37, 0x20, 0x31, 0x35, 0x37, 0x3d, 0x3e, 0x32, 0x34, 0x30, 0x20,
+  0x31, 0x35, 0x38, 0x3d, 0x3e, 0x32, 0x31, 0x38, 0x20, 0x31, 0x35, 0x39,
+  0x3d, 0x3e, 0x32, 0x31, 0x37, 0x20, 0x31, 0x36, 0x30, 0x3d, 0x3e, 0x32,
+  0x30, 0x32, 0x20, 0x31, 0x36, 0x31, 0x3d, 0x3e, 0x31, 0x39, 0x33, 0x20,
+  0x31, 0x36, 0x32, 0x3d, 0x3e, 0x31, 0x36, 0x32, 0x20, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20,
+  0x31, 0x36, 0x33, 0x3d, 0x3e, 0x31, 0x36, 0x33, 0x20, 0x31, 0x36, 0x34,
+  0x3d, 0x3e, 0x32, 0x31, 0x39, 0x20, 0x31, 0x36, 0x35, 0x3d, 0x3e, 0x31,
+  0x38, 0x30, 0x20, 0x31, 0x36, 0x36, 0x3d, 0x3e, 0x32, 0x34, 0x35, 0x20,
+  0x31, 0x36, 0x37, 0x3d, 0x3e, 0x31, 0x36, 0x34, 0x20, 0x31, 0x36, 0x38,
+  0x3d, 0x3e, 0x31, 0x37, 0x32, 0x20, 0x31, 0x36, 0x39, 0x3d, 0x3e, 0x31,
+  0x36, 0x39, 0x20, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e,
+  0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x31, 0x37, 0x30, 0x3d, 0x3e, 0x31,
+  0x38, 0x37, 0x20, 0x31, 0x37, 0x31, 0x3d, 0x3e, 0x31, 0x39, 0x39, 0x20,
+  0x31, 0x37, 0x32, 0x3d, 0x3e, 0x31, 0x39, 0x34, 0x20, 0x31, 0x37, 0x33,
+  0x3d, 0x3e, 0x32, 0x30, 0x38, 0x20, 0x31, 0x37, 0x34, 0x3d, 0x3e, 0x31,
+  0x36, 0x38, 0x20, 0x31, 0x37, 0x35, 0x3d, 0x3e, 0x31, 0x39, 0x35, 0x20,
+  0x31, 0x37, 0x36, 0x3d, 0x3e, 0x31, 0x36, 0x31, 0x20, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20,
+  0x31, 0x37, 0x37, 0x3d, 0x3e, 0x31, 0x37, 0x37, 0x20, 0x31, 0x37, 0x38,
+  0x3d, 0x3e, 0x32, 0x35, 0x30, 0x20, 0x31, 0x37, 0x39, 0x3d, 0x3e, 0x32,
+  0x35, 0x34, 0x20, 0x31, 0x38, 0x30, 0x3d, 0x3e, 0x31, 0x37, 0x31, 0x20,
+  0x31, 0x38, 0x31, 0x3d, 0x3e, 0x31, 0x38, 0x31, 0x20, 0x31, 0x38, 0x32,
+  0x3d, 0x3e, 0x31, 0x36, 0x36, 0x20, 0x31, 0x38, 0x33, 0x3d, 0x3e, 0x32,
+  0x32, 0x35, 0x20, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e,
+  0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x31, 0x38, 0x34, 0x3d, 0x3e, 0x32,
+  0x35, 0x32, 0x20, 0x31, 0x38, 0x35, 0x3d, 0x3e, 0x32, 0x35, 0x35, 0x20,
+  0x31, 0x38, 0x36, 0x3d, 0x3e, 0x31, 0x38, 0x38, 0x20, 0x31, 0x38, 0x37,
+  0x3d, 0x3e, 0x32, 0x30, 0x30, 0x20, 0x31, 0x38, 0x38, 0x3d, 0x3e, 0x31,
+  0x39, 0x37, 0x20, 0x31, 0x38, 0x39, 0x3d, 0x3e, 0x32, 0x35, 0x33, 0x20,
+  0x31, 0x39, 0x30, 0x3d, 0x3e, 0x32, 0x35, 0x31, 0x20, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20,
+  0x31, 0x39, 0x31, 0x3d, 0x3e, 0x31, 0x39, 0x32, 0x20, 0x31, 0x39, 0x32,
+  0x3d, 0x3e, 0x32, 0x30, 0x33, 0x20, 0x31, 0x39, 0x33, 0x3d, 0x3e, 0x32,
+  0x33, 0x31, 0x20, 0x31, 0x39, 0x34, 0x3d, 0x3e, 0x32, 0x32, 0x39, 0x20,
+  0x31, 0x39, 0x35, 0x3d, 0x3e, 0x32, 0x30, 0x34, 0x20, 0x31, 0x39, 0x36,
+  0x3d, 0x3e, 0x31, 0x32, 0x38, 0x20, 0x31, 0x39, 0x37, 0x3d, 0x3e, 0x31,
+  0x32, 0x39, 0x20, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e,
+  0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x31, 0x39, 0x38, 0x3d, 0x3e, 0x31,
+  0x37, 0x34, 0x20, 0x31, 0x39, 0x39, 0x3d, 0x3e, 0x31, 0x33, 0x30, 0x20,
+  0x32, 0x30, 0x30, 0x3d, 0x3e, 0x32, 0x33, 0x33, 0x20, 0x32, 0x30, 0x31,
+  0x3d, 0x3e, 0x31, 0x33, 0x31, 0x20, 0x32, 0x30, 0x32, 0x3d, 0x3e, 0x32,
+  0x33, 0x30, 0x20, 0x32, 0x30, 0x33, 0x3d, 0x3e, 0x32, 0x33, 0x32, 0x20,
+  0x32, 0x30, 0x34, 0x3d, 0x3e, 0x32, 0x33, 0x37, 0x20, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20,
+  0x32, 0x30, 0x35, 0x3d, 0x3e, 0x32, 0x33, 0x34, 0x20, 0x32, 0x30, 0x36,
+  0x3d, 0x3e, 0x32, 0x33, 0x35, 0x20, 0x32, 0x30, 0x37, 0x3d, 0x3e, 0x32,
+  0x33, 0x36, 0x20, 0x32, 0x30, 0x38, 0x3d, 0x3e, 0x31, 0x39, 0x38, 0x20,
+  0x32, 0x30, 0x39, 0x3d, 0x3e, 0x31, 0x33, 0x32, 0x20, 0x32, 0x31, 0x30,
+  0x3d, 0x3e, 0x32, 0x34, 0x31, 0x20, 0x32, 0x31, 0x31, 0x3d, 0x3e, 0x32,
+  0x33, 0x38, 0x20, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e,
+  0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x32, 0x31, 0x32, 0x3d, 0x3e, 0x32,
+  0x33, 0x39, 0x20, 0x32, 0x31, 0x33, 0x3d, 0x3e, 0x32, 0x30, 0x35, 0x20,
+  0x32, 0x31, 0x34, 0x3d, 0x3e, 0x31, 0x33, 0x33, 0x20, 0x32, 0x31, 0x35,
+  0x3d, 0x3e, 0x32, 0x31, 0x35, 0x20, 0x32, 0x31, 0x36, 0x3d, 0x3e, 0x31,
+  0x37, 0x35, 0x20, 0x32, 0x31, 0x37, 0x3d, 0x3e, 0x32, 0x34, 0x34, 0x20,
+  0x32, 0x31, 0x38, 0x3d, 0x3e, 0x32, 0x34, 0x32, 0x20, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20,
+  0x32, 0x31, 0x39, 0x3d, 0x3e, 0x32, 0x34, 0x33, 0x20, 0x32, 0x32, 0x30,
+  0x3d, 0x3e, 0x31, 0x33, 0x34, 0x20, 0x32, 0x32, 0x31, 0x3d, 0x3e, 0x31,
+  0x38, 0x33, 0x20, 0x32, 0x32, 0x32, 0x3d, 0x3e, 0x31, 0x38, 0x34, 0x20,
+  0x32, 0x32, 0x33, 0x3d, 0x3e, 0x31, 0x36, 0x37, 0x20, 0x32, 0x32, 0x34,
+  0x3d, 0x3e, 0x31, 0x33, 0x36, 0x20, 0x32, 0x32, 0x35, 0x3d, 0x3e, 0x31,
+  0x33, 0x35, 0x20, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e,
+  0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x32, 0x32, 0x36, 0x3d, 0x3e, 0x31,
+  0x33, 0x37, 0x20, 0x32, 0x32, 0x37, 0x3d, 0x3e, 0x31, 0x33, 0x39, 0x20,
+  0x32, 0x32, 0x38, 0x3d, 0x3e, 0x31, 0x33, 0x38, 0x20, 0x32, 0x32, 0x39,
+  0x3d, 0x3e, 0x31, 0x34, 0x30, 0x20, 0x32, 0x33, 0x30, 0x3d, 0x3e, 0x31,
+  0x39, 0x30, 0x20, 0x32, 0x33, 0x31, 0x3d, 0x3e, 0x31, 0x34, 0x31, 0x20,
+  0x32, 0x33, 0x32, 0x3d, 0x3e, 0x31, 0x34, 0x33, 0x20, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20,
+  0x32, 0x33, 0x33, 0x3d, 0x3e, 0x31, 0x34, 0x32, 0x20, 0x32, 0x33, 0x34,
+  0x3d, 0x3e, 0x31, 0x34, 0x34, 0x20, 0x32, 0x33, 0x35, 0x3d, 0x3e, 0x31,
+  0x34, 0x35, 0x20, 0x32, 0x33, 0x36, 0x3d, 0x3e, 0x31, 0x34, 0x37, 0x20,
+  0x32, 0x33, 0x37, 0x3d, 0x3e, 0x31, 0x34, 0x36, 0x20, 0x32, 0x33, 0x38,
+  0x3d, 0x3e, 0x31, 0x34, 0x38, 0x20, 0x32, 0x33, 0x39, 0x3d, 0x3e, 0x31,
+  0x34, 0x39, 0x20, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e,
+  0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x32, 0x34, 0x30, 0x3d, 0x3e, 0x31,
+  0x38, 0x32, 0x20, 0x32, 0x34, 0x31, 0x3d, 0x3e, 0x31, 0x35, 0x30, 0x20,
+  0x32, 0x34, 0x32, 0x3d, 0x3e, 0x31, 0x35, 0x32, 0x20, 0x32, 0x34, 0x33,
+  0x3d, 0x3e, 0x31, 0x35, 0x31, 0x20, 0x32, 0x34, 0x34, 0x3d, 0x3e, 0x31,
+  0x35, 0x33, 0x20, 0x32, 0x34, 0x35, 0x3d, 0x3e, 0x31, 0x35, 0x35, 0x20,
+  0x32, 0x34, 0x36, 0x3d, 0x3e, 0x31, 0x35, 0x34, 0x20, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20,
+  0x32, 0x34, 0x37, 0x3d, 0x3e, 0x32, 0x31, 0x34, 0x20, 0x32, 0x34, 0x38,
+  0x3d, 0x3e, 0x31, 0x39, 0x31, 0x20, 0x32, 0x34, 0x39, 0x3d, 0x3e, 0x31,
+  0x35, 0x37, 0x20, 0x32, 0x35, 0x30, 0x3d, 0x3e, 0x31, 0x35, 0x36, 0x20,
+  0x32, 0x35, 0x31, 0x3d, 0x3e, 0x31, 0x35, 0x38, 0x20, 0x32, 0x35, 0x32,
+  0x3d, 0x3e, 0x31, 0x35, 0x39, 0x20, 0x32, 0x35, 0x33, 0x3d, 0x3e, 0x31,
+  0x38, 0x39, 0x20, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x20, 0x3d, 0x3e,
+  0x20, 0x4d, 0x61, 0x63, 0x3a, 0x20, 0x32, 0x35, 0x34, 0x3d, 0x3e, 0x31,
+  0x38, 0x35, 0x20, 0x32, 0x35, 0x35, 0x3d, 0x3e, 0x32, 0x31, 0x36, 0x20,
+  0x0d, 0x0a, 0x0d, 0x0a
+};
+unsigned int fontmaps_fontmap_D10_txt_len = 7720;
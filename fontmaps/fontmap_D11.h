@@ -0,0 +1,331 @@
+unsigned char fontmaps_fontmap_D11_txt[] = {
+  0xef, 0xbb, 0xbf, 0x3b, 0x20, 0x43, 0x6f, 0x70, 0x79, 0x72, 0x69, 0x67,
+  0x68, 0x74, 0x20, 0x31, 0x39, 0x39, 0x34, 0x2d, 0x32, 0x30, 0x30, 0x34,
+  0x2c, 0x20, 0x4d, 0x61, 0x63, 0x72, 0x6f, 0x6d, 0x65, 0x64, 0x69, 0x61,
+  0x2c, 0x20, 0x49, 0x6e, 0x63, 0x2e, 0x20, 0x20, 0x41, 0x6c, 0x6c, 0x20,
+  0x52, 0x69, 0x67, 0x68, 0x74, 0x73, 0x20, 0x52, 0x65, 0x73, 0x65, 0x72,
+  0x76, 0x65, 0x64, 0x2e, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x44, 0x65,
+  0x66, 0x61, 0x75, 0x6c, 0x74, 0x20, 0x46, 0x6f, 0x6e, 0x74, 0x20, 0x4d,
+  0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x20, 0x54, 0x61, 0x62, 0x6c, 0x65,
+  0x20, 0x66, 0x6f, 0x72, 0x20, 0x44, 0x69, 0x72, 0x65, 0x63, 0x74, 0x6f,
+  0x72, 0x20, 0x4d, 0x58, 0x20, 0x32, 0x30, 0x30, 0x34, 0x20, 0x4d, 0x61,
+  0x63, 0x69, 0x6e, 0x74, 0x6f, 0x73, 0x68, 0x20, 0x61, 0x6e, 0x64, 0x20,
+  0x57, 0x69, 0x6e, 0x64, 0x6f, 0x77, 0x73, 0x2e, 0x0d, 0x0a, 0x3b, 0x0d,
+  0x0a, 0x3b, 0x20, 0x54, 0x68, 0x69, 0x73, 0x20, 0x66, 0x69, 0x6c, 0x65,
+  0x20, 0x70, 0x72, 0x6f, 0x76, 0x69, 0x64, 0x65, 0x73, 0x20, 0x61, 0x20,
+  0x66, 0x6f, 0x6e, 0x74, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67,
+  0x20, 0x74, 0x61, 0x62, 0x6c, 0x65, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x44,
+  0x69, 0x72, 0x65, 0x63, 0x74, 0x6f, 0x72, 0x20, 0x4d, 0x58, 0x20, 0x32,
+  0x30, 0x30, 0x34, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x57, 0x69, 0x6e, 0x64,
+  0x6f, 0x77, 0x73, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x61, 0x6e, 0x64, 0x20,
+  0x4d, 0x61, 0x63, 0x69, 0x6e, 0x74, 0x6f, 0x73, 0x68, 0x2e, 0x0d, 0x0a,
+  0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x49, 0x66, 0x20, 0x61, 0x20, 0x63, 0x6f,
+  0x70, 0x79, 0x20, 0x6f, 0x66, 0x20, 0x74, 0x68, 0x69, 0x73, 0x20, 0x66,
+  0x69, 0x6c, 0x65, 0x20, 0x69, 0x73, 0x20, 0x69, 0x6e, 0x20, 0x74, 0x68,
+  0x65, 0x20, 0x73, 0x61, 0x6d, 0x65, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65,
+  0x72, 0x20, 0x6f, 0x72, 0x20, 0x64, 0x69, 0x72, 0x65, 0x63, 0x74, 0x6f,
+  0x72, 0x79, 0x20, 0x61, 0x73, 0x20, 0x74, 0x68, 0x65, 0x20, 0x0d, 0x0a,
+  0x3b, 0x20, 0x44, 0x69, 0x72, 0x65, 0x63, 0x74, 0x6f, 0x72, 0x20, 0x61,
+  0x70, 0x70, 0x6c, 0x69, 0x63, 0x61, 0x74, 0x69, 0x6f, 0x6e, 0x2c, 0x20,
+  0x44, 0x69, 0x72, 0x65, 0x63, 0x74, 0x6f, 0x72, 0x20, 0x77, 0x69, 0x6c,
+  0x6c, 0x20, 0x61, 0x75, 0x74, 0x6f, 0x6d, 0x61, 0x74, 0x69, 0x63, 0x61,
+  0x6c, 0x6c, 0x79, 0x20, 0x69, 0x6e, 0x63, 0x6c, 0x75, 0x64, 0x65, 0x20,
+  0x74, 0x68, 0x69, 0x73, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x20, 0x0d, 0x0a,
+  0x3b, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x20, 0x74, 0x61,
+  0x62, 0x6c, 0x65, 0x20, 0x69, 0x6e, 0x20, 0x65, 0x76, 0x65, 0x72, 0x79,
+  0x20, 0x6e, 0x65, 0x77, 0x20, 0x6d, 0x6f, 0x76, 0x69, 0x65, 0x20, 0x79,
+  0x6f, 0x75, 0x20, 0x63, 0x72, 0x65, 0x61, 0x74, 0x65, 0x2e, 0x0d, 0x0a,
+  0x3b, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x54, 0x6f, 0x20, 0x61, 0x64, 0x64,
+  0x20, 0x74, 0x68, 0x69, 0x73, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x20, 0x6d,
+  0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x20, 0x74, 0x61, 0x62, 0x6c, 0x65,
+  0x20, 0x74, 0x6f, 0x20, 0x61, 0x6e, 0x20, 0x65, 0x78, 0x69, 0x73, 0x74,
+  0x69, 0x6e, 0x67, 0x20, 0x6d, 0x6f, 0x76, 0x69, 0x65, 0x2c, 0x20, 0x63,
+  0x68, 0x6f, 0x6f, 0x73, 0x65, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x4d, 0x6f,
+  0x76, 0x69, 0x65, 0x3a, 0x50, 0x72, 0x6f, 0x70, 0x65, 0x72, 0x74, 0x69,
+  0x65, 0x73, 0x2e, 0x2e, 0x2e, 0x20, 0x66, 0x72, 0x6f, 0x6d, 0x20, 0x74,
+  0x68, 0x65, 0x20, 0x4d, 0x6f, 0x64, 0x69, 0x66, 0x79, 0x20, 0x6d, 0x65,
+  0x6e, 0x75, 0x2e, 0x20, 0x20, 0x54, 0x68, 0x65, 0x6e, 0x20, 0x63, 0x6c,
+  0x69, 0x63, 0x6b, 0x20, 0x4c, 0x6f, 0x61, 0x64, 0x20, 0x66, 0x72, 0x6f,
+  0x6d, 0x20, 0x46, 0x69, 0x6c, 0x65, 0x2e, 0x20, 0x20, 0x0d, 0x0a, 0x3b,
+  0x20, 0x55, 0x73, 0x65, 0x20, 0x74, 0x68, 0x65, 0x20, 0x64, 0x69, 0x61,
+  0x6c, 0x6f, 0x67, 0x20, 0x62, 0x6f, 0x78, 0x20, 0x74, 0x68, 0x61, 0x74,
+  0x20, 0x61, 0x70, 0x70, 0x65, 0x61, 0x72, 0x73, 0x20, 0x74, 0x6f, 0x20,
+  0x6c, 0x6f, 0x63, 0x61, 0x74, 0x65, 0x20, 0x74, 0x68, 0x69, 0x73, 0x20,
+  0x66, 0x69, 0x6c, 0x65, 0x2e, 0x0d, 0x0a, 0x3b, 0x20, 0x0d, 0x0a, 0x3b,
+  0x20, 0x4e, 0x6f, 0x74, 0x65, 0x3a, 0x20, 0x49, 0x6e, 0x20, 0x74, 0x68,
+  0x69, 0x73, 0x20, 0x66, 0x69, 0x6c, 0x65, 0x2c, 0x20, 0x61, 0x20, 0x73,
+  0x65, 0x6d, 0x69, 0x63, 0x6f, 0x6c, 0x6f, 0x6e, 0x20, 0x61, 0x74, 0x20,
+  0x74, 0x68, 0x65, 0x20, 0x62, 0x65, 0x67, 0x69, 0x6e, 0x6e, 0x69, 0x6e,
+  0x67, 0x20, 0x6f, 0x66, 0x20, 0x61, 0x20, 0x6c, 0x69, 0x6e, 0x65, 0x20,
+  0x69, 0x6e, 0x64, 0x69, 0x63, 0x61, 0x74, 0x65, 0x73, 0x0d, 0x0a, 0x3b,
+  0x20, 0x61, 0x20, 0x63, 0x6f, 0x6d, 0x6d, 0x65, 0x6e, 0x74, 0x2e, 0x0d,
+  0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x53, 0x70, 0x65, 0x63, 0x69, 0x61,
+  0x6c, 0x20, 0x4e, 0x6f, 0x74, 0x65, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x4d,
+  0x61, 0x63, 0x20, 0x4f, 0x53, 0x58, 0x20, 0x75, 0x73, 0x65, 0x72, 0x73,
+  0x3a, 0x20, 0x54, 0x68, 0x69, 0x73, 0x20, 0x66, 0x69, 0x6c, 0x65, 0x20,
+  0x69, 0x73, 0x20, 0x73, 0x61, 0x76, 0x65, 0x64, 0x20, 0x75, 0x73, 0x69,
+  0x6e, 0x67, 0x20, 0x74, 0x68, 0x65, 0x20, 0x27, 0x43, 0x6c, 0x61, 0x73,
+  0x73, 0x69, 0x63, 0x27, 0x20, 0x6c, 0x69, 0x6e, 0x65, 0x0d, 0x0a, 0x3b,
+  0x20, 0x65, 0x6e, 0x64, 0x69, 0x6e, 0x67, 0x20, 0x63, 0x68, 0x61, 0x72,
+  0x61, 0x63, 0x74, 0x65, 0x72, 0x20, 0x28, 0x43, 0x52, 0x29, 0x2e, 0x20,
+  0x20, 0x49, 0x66, 0x20, 0x79, 0x6f, 0x75, 0x20, 0x6e, 0x65, 0x65, 0x64,
+  0x20, 0x74, 0x6f, 0x20, 0x61, 0x6c, 0x74, 0x65, 0x72, 0x20, 0x61, 0x6e,
+  0x64, 0x20, 0x73, 0x61, 0x76, 0x65, 0x20, 0x74, 0x68, 0x69, 0x73, 0x20,
+  0x66, 0x69, 0x6c, 0x65, 0x2c, 0x20, 0x6d, 0x61, 0x6b, 0x65, 0x20, 0x73,
+  0x75, 0x72, 0x65, 0x20, 0x74, 0x6f, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x70,
+  0x72, 0x65, 0x73, 0x65, 0x72, 0x76, 0x65, 0x20, 0x74, 0x68, 0x69, 0x73,
+  0x20, 0x2d, 0x20, 0x74, 0x68, 0x65, 0x20, 0x55, 0x4e, 0x49, 0x58, 0x20,
+  0x6c, 0x69, 0x6e, 0x65, 0x20, 0x65, 0x6e, 0x64, 0x69, 0x6e, 0x67, 0x20,
+  0x63, 0x68, 0x61, 0x72, 0x61, 0x63, 0x74, 0x65, 0x72, 0x20, 0x28, 0x4c,
+  0x46, 0x29, 0x20, 0x77, 0x69, 0x6c, 0x6c, 0x20, 0x6e, 0x6f, 0x74, 0x20,
+  0x77, 0x6f, 0x72, 0x6b, 0x20, 0x70, 0x72, 0x6f, 0x70, 0x65, 0x72, 0x6c,
+  0x79, 0x2e, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d, 0x3d,
+  0x3d, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x46, 0x4f, 0x4e, 0x54,
+  0x20, 0x4d, 0x41, 0x50, 0x50, 0x49, 0x4e, 0x47, 0x53, 0x20, 0x0d, 0x0a,
+  0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x46, 0x6f, 0x6e, 0x74, 0x20, 0x6d, 0x61,
+  0x70, 0x70, 0x69, 0x6e, 0x67, 0x73, 0x20, 0x73, 0x70, 0x65, 0x63, 0x69,
+  0x66, 0x79, 0x20, 0x77, 0x68, 0x69, 0x63, 0x68, 0x20, 0x66, 0x6f, 0x6e,
+  0x74, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x73, 0x69, 0x7a, 0x65, 0x20, 0x73,
+  0x75, 0x62, 0x73, 0x74, 0x69, 0x74, 0x75, 0x74, 0x69, 0x6f, 0x6e, 0x73,
+  0x20, 0x74, 0x6f, 0x20, 0x6d, 0x61, 0x6b, 0x65, 0x20, 0x77, 0x68, 0x65,
+  0x6e, 0x0d, 0x0a, 0x3b, 0x20, 0x6d, 0x6f, 0x76, 0x69, 0x6e, 0x67, 0x20,
+  0x61, 0x20, 0x6d, 0x6f, 0x76, 0x69, 0x65, 0x20, 0x66, 0x72, 0x6f, 0x6d,
+  0x20, 0x6f, 0x6e, 0x65, 0x20, 0x70, 0x6c, 0x61, 0x74, 0x66, 0x6f, 0x72,
+  0x6d, 0x20, 0x74, 0x6f, 0x20, 0x61, 0x6e, 0x6f, 0x74, 0x68, 0x65, 0x72,
+  0x2e, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x54, 0x68, 0x65, 0x20,
+  0x66, 0x6f, 0x72, 0x6d, 0x61, 0x74, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x66,
+  0x6f, 0x6e, 0x74, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x20,
+  0x64, 0x65, 0x66, 0x69, 0x6e, 0x69, 0x74, 0x69, 0x6f, 0x6e, 0x73, 0x20,
+  0x69, 0x73, 0x3a, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x50, 0x6c,
+  0x61, 0x74, 0x66, 0x6f, 0x72, 0x6d, 0x3a, 0x46, 0x6f, 0x6e, 0x74, 0x4e,
+  0x61, 0x6d, 0x65, 0x20, 0x3d, 0x3e, 0x20, 0x50, 0x6c, 0x61, 0x74, 0x66,
+  0x6f, 0x72, 0x6d, 0x3a, 0x46, 0x6f, 0x6e, 0x74, 0x4e, 0x61, 0x6d, 0x65,
+  0x20, 0x5b, 0x4d, 0x41, 0x50, 0x20, 0x4e, 0x4f, 0x4e, 0x45, 0x5d, 0x20,
+  0x5b, 0x6f, 0x6c, 0x64, 0x53, 0x69, 0x7a, 0x65, 0x20, 0x3d, 0x3e, 0x20,
+  0x6e, 0x65, 0x77, 0x53, 0x69, 0x7a, 0x65, 0x5d, 0x0d, 0x0a, 0x3b, 0x0d,
+  0x0a, 0x3b, 0x20, 0x20, 0x20, 0x20, 0x53, 0x70, 0x65, 0x63, 0x69, 0x66,
+  0x79, 0x69, 0x6e, 0x67, 0x20, 0x4d, 0x41, 0x50, 0x20, 0x4e, 0x4f, 0x4e,
+  0x45, 0x20, 0x74, 0x75, 0x72, 0x6e, 0x73, 0x20, 0x6f, 0x66, 0x66, 0x20,
+  0x63, 0x68, 0x61, 0x72, 0x61, 0x63, 0x74, 0x65, 0x72, 0x20, 0x6d, 0x61,
+  0x70, 0x70, 0x69, 0x6e, 0x67, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x74, 0x68,
+  0x69, 0x73, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x2e, 0x0d, 0x0a, 0x3b, 0x20,
+  0x20, 0x20, 0x20, 0x49, 0x66, 0x20, 0x79, 0x6f, 0x75, 0x20, 0x73, 0x70,
+  0x65, 0x63, 0x69, 0x66, 0x79, 0x20, 0x73, 0x69, 0x7a, 0x65, 0x20, 0x6d,
+  0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x73, 0x2c, 0x20, 0x74, 0x68, 0x65,
+  0x79, 0x20, 0x61, 0x70, 0x70, 0x6c, 0x79, 0x20, 0x66, 0x6f, 0x72, 0x20,
+  0x54, 0x48, 0x41, 0x54, 0x20, 0x46, 0x4f, 0x4e, 0x54, 0x20, 0x4f, 0x4e,
+  0x4c, 0x59, 0x2e, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x48, 0x65,
+  0x72, 0x65, 0x20, 0x61, 0x72, 0x65, 0x20, 0x73, 0x6f, 0x6d, 0x65, 0x20,
+  0x74, 0x79, 0x70, 0x69, 0x63, 0x61, 0x6c, 0x20, 0x6d, 0x61, 0x70, 0x70,
+  0x69, 0x6e, 0x67, 0x73, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x74, 0x68, 0x65,
+  0x20, 0x73, 0x74, 0x61, 0x6e, 0x64, 0x61, 0x72, 0x64, 0x20, 0x4d, 0x61,
+  0x63, 0x69, 0x6e, 0x74, 0x6f, 0x73, 0x68, 0x20, 0x66, 0x6f, 0x6e, 0x74,
+  0x73, 0x3a, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x0d, 0x0a, 0x4d, 0x61, 0x63,
+  0x3a, 0x43, 0x68, 0x69, 0x63, 0x61, 0x67, 0x6f, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x53, 0x79,
+  0x73, 0x74, 0x65, 0x6d, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x43, 0x6f,
+  0x75, 0x72, 0x69, 0x65, 0x72, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0x43, 0x6f, 0x75, 0x72,
+  0x69, 0x65, 0x72, 0x20, 0x4e, 0x65, 0x77, 0x22, 0x0d, 0x0a, 0x4d, 0x61,
+  0x63, 0x3a, 0x47, 0x65, 0x6e, 0x65, 0x76, 0x61, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x22,
+  0x4d, 0x53, 0x20, 0x53, 0x61, 0x6e, 0x73, 0x20, 0x53, 0x65, 0x72, 0x69,
+  0x66, 0x22, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x48, 0x65, 0x6c, 0x76,
+  0x65, 0x74, 0x69, 0x63, 0x61, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e,
+  0x20, 0x57, 0x69, 0x6e, 0x3a, 0x41, 0x72, 0x69, 0x61, 0x6c, 0x0d, 0x0a,
+  0x4d, 0x61, 0x63, 0x3a, 0x4d, 0x6f, 0x6e, 0x61, 0x63, 0x6f, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e,
+  0x3a, 0x54, 0x65, 0x72, 0x6d, 0x69, 0x6e, 0x61, 0x6c, 0x0d, 0x0a, 0x4d,
+  0x61, 0x63, 0x3a, 0x22, 0x4e, 0x65, 0x77, 0x20, 0x59, 0x6f, 0x72, 0x6b,
+  0x22, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a,
+  0x22, 0x4d, 0x53, 0x20, 0x53, 0x65, 0x72, 0x69, 0x66, 0x22, 0x0d, 0x0a,
+  0x4d, 0x61, 0x63, 0x3a, 0x53, 0x79, 0x6d, 0x62, 0x6f, 0x6c, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e,
+  0x3a, 0x53, 0x79, 0x6d, 0x62, 0x6f, 0x6c, 0x20, 0x20, 0x4d, 0x61, 0x70,
+  0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x54,
+  0x69, 0x6d, 0x65, 0x73, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0x54, 0x69, 0x6d,
+  0x65, 0x73, 0x20, 0x4e, 0x65, 0x77, 0x20, 0x52, 0x6f, 0x6d, 0x61, 0x6e,
+  0x22, 0x20, 0x31, 0x34, 0x3d, 0x3e, 0x31, 0x32, 0x20, 0x31, 0x38, 0x3d,
+  0x3e, 0x31, 0x34, 0x20, 0x32, 0x34, 0x3d, 0x3e, 0x31, 0x38, 0x20, 0x33,
+  0x30, 0x3d, 0x3e, 0x32, 0x34, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x50,
+  0x61, 0x6c, 0x61, 0x74, 0x69, 0x6e, 0x6f, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0x54, 0x69, 0x6d,
+  0x65, 0x73, 0x20, 0x4e, 0x65, 0x77, 0x20, 0x52, 0x6f, 0x6d, 0x61, 0x6e,
+  0x22, 0x0d, 0x0a, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x48, 0x65,
+  0x72, 0x65, 0x20, 0x61, 0x72, 0x65, 0x20, 0x73, 0x6f, 0x6d, 0x65, 0x20,
+  0x74, 0x79, 0x70, 0x69, 0x63, 0x61, 0x6c, 0x20, 0x6d, 0x61, 0x70, 0x70,
+  0x69, 0x6e, 0x67, 0x73, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x74, 0x68, 0x65,
+  0x20, 0x73, 0x74, 0x61, 0x6e, 0x64, 0x61, 0x72, 0x64, 0x20, 0x57, 0x69,
+  0x6e, 0x64, 0x6f, 0x77, 0x73, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x73, 0x3a,
+  0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x41,
+  0x72, 0x69, 0x61, 0x6c, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a,
+  0x48, 0x65, 0x6c, 0x76, 0x65, 0x74, 0x69, 0x63, 0x61, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x22, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65, 0x72, 0x22,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20,
+  0x4d, 0x61, 0x63, 0x3a, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65, 0x72, 0x0d,
+  0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65,
+  0x72, 0x20, 0x4e, 0x65, 0x77, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d,
+  0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65,
+  0x72, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0x4d, 0x53, 0x20, 0x53,
+  0x65, 0x72, 0x69, 0x66, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x22, 0x4e, 0x65, 0x77,
+  0x20, 0x59, 0x6f, 0x72, 0x6b, 0x22, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a,
+  0x22, 0x4d, 0x53, 0x20, 0x53, 0x61, 0x6e, 0x73, 0x20, 0x53, 0x65, 0x72,
+  0x69, 0x66, 0x22, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63,
+  0x3a, 0x47, 0x65, 0x6e, 0x65, 0x76, 0x61, 0x0d, 0x0a, 0x57, 0x69, 0x6e,
+  0x3a, 0x53, 0x79, 0x6d, 0x62, 0x6f, 0x6c, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61,
+  0x63, 0x3a, 0x53, 0x79, 0x6d, 0x62, 0x6f, 0x6c, 0x20, 0x20, 0x4d, 0x61,
+  0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a,
+  0x53, 0x79, 0x73, 0x74, 0x65, 0x6d, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63,
+  0x3a, 0x43, 0x68, 0x69, 0x63, 0x61, 0x67, 0x6f, 0x0d, 0x0a, 0x57, 0x69,
+  0x6e, 0x3a, 0x54, 0x65, 0x72, 0x6d, 0x69, 0x6e, 0x61, 0x6c, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d,
+  0x61, 0x63, 0x3a, 0x4d, 0x6f, 0x6e, 0x61, 0x63, 0x6f, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x22, 0x54, 0x69, 0x6d, 0x65, 0x73, 0x20, 0x4e, 0x65,
+  0x77, 0x20, 0x52, 0x6f, 0x6d, 0x61, 0x6e, 0x22, 0x20, 0x3d, 0x3e, 0x20,
+  0x4d, 0x61, 0x63, 0x3a, 0x22, 0x54, 0x69, 0x6d, 0x65, 0x73, 0x22, 0x20,
+  0x31, 0x32, 0x3d, 0x3e, 0x31, 0x34, 0x20, 0x31, 0x34, 0x3d, 0x3e, 0x31,
+  0x38, 0x20, 0x31, 0x38, 0x3d, 0x3e, 0x32, 0x34, 0x20, 0x32, 0x34, 0x3d,
+  0x3e, 0x33, 0x30, 0x0d, 0x0a, 0x0d, 0x0a, 0x3b, 0x20, 0x4e, 0x6f, 0x74,
+  0x65, 0x3a, 0x20, 0x57, 0x68, 0x65, 0x6e, 0x20, 0x6d, 0x61, 0x70, 0x70,
+  0x69, 0x6e, 0x67, 0x20, 0x66, 0x72, 0x6f, 0x6d, 0x20, 0x57, 0x69, 0x6e,
+  0x64, 0x6f, 0x77, 0x73, 0x20, 0x74, 0x6f, 0x20, 0x4d, 0x61, 0x63, 0x69,
+  0x6e, 0x74, 0x6f, 0x73, 0x68, 0x2c, 0x20, 0x43, 0x6f, 0x75, 0x72, 0x69,
+  0x65, 0x72, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x43, 0x6f, 0x75, 0x72, 0x69,
+  0x65, 0x72, 0x20, 0x4e, 0x65, 0x77, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x6d,
+  0x61, 0x70, 0x20, 0x6f, 0x6e, 0x74, 0x6f, 0x20, 0x43, 0x6f, 0x75, 0x72,
+  0x69, 0x65, 0x72, 0x2e, 0x20, 0x20, 0x57, 0x68, 0x65, 0x6e, 0x20, 0x63,
+  0x6f, 0x6d, 0x69, 0x6e, 0x67, 0x20, 0x62, 0x61, 0x63, 0x6b, 0x20, 0x74,
+  0x6f, 0x20, 0x57, 0x69, 0x6e, 0x64, 0x6f, 0x77, 0x73, 0x20, 0x6f, 0x6e,
+  0x6c, 0x79, 0x20, 0x43, 0x6f, 0x75, 0x72, 0x69, 0x65, 0x72, 0x20, 0x4e,
+  0x65, 0x77, 0x0d, 0x0a, 0x3b, 0x20, 0x77, 0x69, 0x6c, 0x6c, 0x20, 0x62,
+  0x65, 0x20, 0x75, 0x73, 0x65, 0x64, 0x2e, 0x0d, 0x0a, 0x0d, 0x0a, 0x3b,
+  0x20, 0x4a, 0x61, 0x70, 0x61, 0x6e, 0x65, 0x73, 0x65, 0x20, 0x46, 0x6f,
+  0x6e, 0x74, 0x20, 0x4d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x73, 0x0d,
+  0x0a, 0x3b, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x54, 0x68, 0x65, 0x20, 0x4d,
+  0x61, 0x63, 0x69, 0x6e, 0x74, 0x6f, 0x73, 0x68, 0x20, 0x4a, 0x61, 0x70,
+  0x61, 0x6e, 0x65, 0x73, 0x65, 0x20, 0x4f, 0x73, 0x61, 0x6b, 0x61, 0x20,
+  0x66, 0x6f, 0x6e, 0x74, 0x20, 0x69, 0x73, 0x20, 0x6d, 0x61, 0x70, 0x70,
+  0x65, 0x64, 0x20, 0x74, 0x6f, 0x20, 0x61, 0x20, 0x57, 0x69, 0x6e, 0x64,
+  0x6f, 0x77, 0x73, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x2c, 0x20, 0x61, 0x6e,
+  0x64, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x61, 0x6c, 0x6c, 0x20, 0x57, 0x69,
+  0x6e, 0x64, 0x6f, 0x77, 0x73, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x73, 0x20,
+  0x61, 0x72, 0x65, 0x20, 0x6d, 0x61, 0x70, 0x70, 0x65, 0x64, 0x20, 0x74,
+  0x6f, 0x20, 0x4d, 0x61, 0x63, 0x69, 0x6e, 0x74, 0x6f, 0x73, 0x68, 0x27,
+  0x73, 0x20, 0x4f, 0x73, 0x61, 0x6b, 0x61, 0x2e, 0x20, 0x20, 0x4d, 0x61,
+  0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x20, 0x69, 0x73, 0x20, 0x75, 0x73,
+  0x65, 0x64, 0x0d, 0x0a, 0x3b, 0x20, 0x62, 0x65, 0x63, 0x61, 0x75, 0x73,
+  0x65, 0x20, 0x6f, 0x6e, 0x6c, 0x79, 0x20, 0x52, 0x6f, 0x6d, 0x61, 0x6e,
+  0x20, 0x66, 0x6f, 0x6e, 0x74, 0x73, 0x20, 0x6e, 0x65, 0x65, 0x64, 0x20,
+  0x75, 0x70, 0x70, 0x65, 0x72, 0x2d, 0x41, 0x53, 0x43, 0x49, 0x49, 0x20,
+  0x63, 0x68, 0x61, 0x72, 0x61, 0x63, 0x74, 0x65, 0x72, 0x73, 0x20, 0x6d,
+  0x61, 0x70, 0x70, 0x65, 0x64, 0x2e, 0x20, 0x20, 0x54, 0x6f, 0x20, 0x70,
+  0x72, 0x65, 0x76, 0x65, 0x6e, 0x74, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x6d,
+  0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x20, 0x6f, 0x66, 0x20, 0x61, 0x6e,
+  0x79, 0x20, 0x61, 0x64, 0x64, 0x69, 0x74, 0x69, 0x6f, 0x6e, 0x61, 0x6c,
+  0x20, 0x4a, 0x61, 0x70, 0x61, 0x6e, 0x65, 0x73, 0x65, 0x20, 0x66, 0x6f,
+  0x6e, 0x74, 0x73, 0x2c, 0x20, 0x61, 0x64, 0x64, 0x20, 0x74, 0x68, 0x65,
+  0x6d, 0x20, 0x74, 0x6f, 0x20, 0x74, 0x68, 0x69, 0x73, 0x20, 0x6c, 0x69,
+  0x73, 0x74, 0x2e, 0x0d, 0x0a, 0x3b, 0x0d, 0x0a, 0x3b, 0x20, 0x4e, 0x6f,
+  0x74, 0x65, 0x3a, 0x20, 0x49, 0x66, 0x20, 0x79, 0x6f, 0x75, 0x20, 0x64,
+  0x6f, 0x20, 0x6e, 0x6f, 0x74, 0x20, 0x68, 0x61, 0x76, 0x65, 0x20, 0x61,
+  0x20, 0x4a, 0x61, 0x70, 0x61, 0x6e, 0x65, 0x73, 0x65, 0x20, 0x73, 0x79,
+  0x73, 0x74, 0x65, 0x6d, 0x2c, 0x20, 0x74, 0x68, 0x65, 0x20, 0x66, 0x6f,
+  0x6e, 0x74, 0x20, 0x6e, 0x61, 0x6d, 0x65, 0x73, 0x20, 0x62, 0x65, 0x6c,
+  0x6f, 0x77, 0x20, 0x0d, 0x0a, 0x3b, 0x20, 0x77, 0x69, 0x6c, 0x6c, 0x20,
+  0x61, 0x70, 0x70, 0x65, 0x61, 0x72, 0x20, 0x74, 0x6f, 0x20, 0x62, 0x65,
+  0x20, 0x75, 0x6e, 0x72, 0x65, 0x61, 0x64, 0x61, 0x62, 0x6c, 0x65, 0x2e,
+  0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x4f, 0x73, 0x61, 0x6b, 0x61, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e,
+  0x20, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xef, 0xbc, 0xad, 0xef, 0xbc, 0xb3,
+  0x20, 0xe3, 0x82, 0xb4, 0xe3, 0x82, 0xb7, 0xe3, 0x83, 0x83, 0xe3, 0x82,
+  0xaf, 0x22, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d,
+  0x0a, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xef, 0xbc, 0xad, 0xef,
+  0xbc, 0xb3, 0x20, 0xe3, 0x82, 0xb4, 0xe3, 0x82, 0xb7, 0xe3, 0x83, 0x83,
+  0xe3, 0x82, 0xaf, 0x22, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a,
+  0x4f, 0x73, 0x61, 0x6b, 0x61, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f,
+  0x6e, 0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xef, 0xbc, 0xad,
+  0xef, 0xbc, 0xb3, 0x20, 0xe6, 0x98, 0x8e, 0xe6, 0x9c, 0x9d, 0x22, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x4f,
+  0x73, 0x61, 0x6b, 0x61, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e,
+  0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xe6, 0xa8, 0x99, 0xe6,
+  0xba, 0x96, 0xe3, 0x82, 0xb4, 0xe3, 0x82, 0xb7, 0xe3, 0x83, 0x83, 0xe3,
+  0x82, 0xaf, 0x22, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a,
+  0x4f, 0x73, 0x61, 0x6b, 0x61, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f,
+  0x6e, 0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xe6, 0xa8, 0x99,
+  0xe6, 0xba, 0x96, 0xe6, 0x98, 0x8e, 0xe6, 0x9c, 0x9d, 0x22, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x4f,
+  0x73, 0x61, 0x6b, 0x61, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e,
+  0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xe6, 0x98, 0x8e, 0xe6,
+  0x9c, 0x9d, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x4f, 0x73, 0x61, 0x6b,
+  0x61, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a,
+  0x0d, 0x0a, 0x3b, 0x20, 0x4b, 0x6f, 0x72, 0x65, 0x61, 0x6e, 0x20, 0x46,
+  0x6f, 0x6e, 0x74, 0x20, 0x4d, 0x61, 0x70, 0x70, 0x69, 0x6e, 0x67, 0x73,
+  0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a, 0x41, 0x70, 0x70, 0x6c, 0x65, 0x47,
+  0x6f, 0x74, 0x68, 0x69, 0x63, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e,
+  0x20, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xea, 0xb5, 0xb4, 0xeb, 0xa6, 0xbc,
+  0x22, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a,
+  0x4d, 0x61, 0x63, 0x3a, 0x53, 0x65, 0x6f, 0x75, 0x6c, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57,
+  0x69, 0x6e, 0x3a, 0x22, 0xea, 0xb6, 0x81, 0xec, 0x84, 0x9c, 0x22, 0x20,
+  0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x4d, 0x61,
+  0x63, 0x3a, 0x41, 0x70, 0x70, 0x6c, 0x65, 0x4d, 0x79, 0x75, 0x6e, 0x67,
+  0x69, 0x6f, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69, 0x6e,
+  0x3a, 0x22, 0xeb, 0x8f, 0x8b, 0xec, 0x9b, 0x80, 0x22, 0x20, 0x4d, 0x61,
+  0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x4d, 0x61, 0x63, 0x3a,
+  0x22, 0xed, 0x95, 0x9c, 0xea, 0xb0, 0x95, 0xec, 0xb2, 0xb4, 0x22, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x57, 0x69,
+  0x6e, 0x3a, 0x22, 0xeb, 0xb0, 0x94, 0xed, 0x83, 0x95, 0x22, 0x20, 0x4d,
+  0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x0d, 0x0a, 0x57,
+  0x69, 0x6e, 0x3a, 0x22, 0xea, 0xb5, 0xb4, 0xeb, 0xa6, 0xbc, 0x22, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20,
+  0x4d, 0x61, 0x63, 0x3a, 0x41, 0x70, 0x70, 0x6c, 0x65, 0x47, 0x6f, 0x74,
+  0x68, 0x69, 0x63, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65,
+  0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xea, 0xb5, 0xb4, 0xeb, 0xa6,
+  0xbc, 0xec, 0xb2, 0xb4, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x41, 0x70, 0x70, 0x6c,
+  0x65, 0x47, 0x6f, 0x74, 0x68, 0x69, 0x63, 0x20, 0x4d, 0x61, 0x70, 0x20,
+  0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xea,
+  0xb6, 0x81, 0xec, 0x84, 0x9c, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x53,
+  0x65, 0x6f, 0x75, 0x6c, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e,
+  0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xea, 0xb6, 0x81, 0xec,
+  0x84, 0x9c, 0xec, 0xb2, 0xb4, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x53, 0x65, 0x6f,
+  0x75, 0x6c, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d,
+  0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xeb, 0x8f, 0x8b, 0xec, 0x9b, 0x80,
+  0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d,
+  0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x41, 0x70, 0x70, 0x6c, 0x65, 0x4d,
+  0x79, 0x75, 0x6e, 0x67, 0x69, 0x6f, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e,
+  0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xeb, 0x8f,
+  0x8b, 0xec, 0x9b, 0x80, 0xec, 0xb2, 0xb4, 0x22, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x41,
+  0x70, 0x70, 0x6c, 0x65, 0x4d, 0x79, 0x75, 0x6e, 0x67, 0x69, 0x6f, 0x20,
+  0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d, 0x0a, 0x57, 0x69,
+  0x6e, 0x3a, 0x22, 0xeb, 0xb0, 0x94, 0xed, 0x83, 0x95, 0x22, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x3e, 0x20, 0x4d,
+  0x61, 0x63, 0x3a, 0x22, 0xed, 0x95, 0x9c, 0xea, 0xb0, 0x95, 0xec, 0xb2,
+  0xb4, 0x22, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e, 0x6f, 0x6e, 0x65, 0x0d,
+  0x0a, 0x57, 0x69, 0x6e, 0x3a, 0x22, 0xeb, 0xb0, 0x94, 0xed, 0x83, 0x95,
+  0xec, 0xb2, 0xb4, 0x22, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x3d, 0x3e, 0x20, 0x4d, 0x61, 0x63, 0x3a, 0x22, 0xed, 0x95, 0x9c, 0xea,
+  0xb0, 0x95, 0xec, 0xb2, 0xb4, 0x22, 0x20, 0x4d, 0x61, 0x70, 0x20, 0x4e,
+  0x6f, 0x6e, 0x65, 0x0d, 0x0a
+};
+unsigned int fontmaps_fontmap_D11_txt_len = 3929;
@@ -0,0 +1,51 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include <algorithm>
+
+#include "common/arena.h"
+
+namespace Common {
+
+/* Arena */
+
+Arena::Arena()
+	: _current(nullptr), _remaining(0), _nextBlockSize(kInitialBlockSize), _objectCount(0) {}
+
+Arena::~Arena() {
+	clear();
+}
+
+void *Arena::allocate(size_t size, size_t alignment) {
+	size_t padding = -(uintptr_t)_current & (alignment - 1);
+	if (_current == nullptr || padding + size > _remaining) {
+		size_t blockSize = std::max(_nextBlockSize, size + alignment);
+		_nextBlockSize = std::min(_nextBlockSize * 2, kMaxBlockSize);
+		_blocks.emplace_back(new uint8_t[blockSize]);
+		_current = _blocks.back().get();
+		_remaining = blockSize;
+		padding = -(uintptr_t)_current & (alignment - 1);
+	}
+
+	void *memory = _current + padding;
+	_current += padding + size;
+	_remaining -= padding + size;
+	return memory;
+}
+
+void Arena::clear() {
+	for (auto it = _destructors.rbegin(); it != _destructors.rend(); ++it) {
+		it->destroy(it->object);
+	}
+	_destructors.clear();
+	_blocks.clear();
+	_current = nullptr;
+	_remaining = 0;
+	_nextBlockSize = kInitialBlockSize;
+	_objectCount = 0;
+}
+
+} // namespace Common
@@ -0,0 +1,69 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COMMON_ARENA_H
+#define COMMON_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Common {
+
+/* Arena */
+
+// Bump allocator for objects that all live and die together. Objects are
+// carved out of blocks that double in size as the arena grows, and are
+// destroyed in reverse order of creation when the arena is cleared or
+// destroyed. Pointers into the arena are never invalidated by later
+// allocations.
+class Arena {
+private:
+	struct Destructor {
+		void (*destroy)(void *);
+		void *object;
+	};
+
+	std::vector<std::unique_ptr<uint8_t[]>> _blocks;
+	std::vector<Destructor> _destructors;
+	uint8_t *_current;
+	size_t _remaining;
+	size_t _nextBlockSize;
+	size_t _objectCount;
+
+	void *allocate(size_t size, size_t alignment);
+
+public:
+	static constexpr size_t kInitialBlockSize = 1024;
+	static constexpr size_t kMaxBlockSize = 64 * 1024;
+
+	Arena();
+	~Arena();
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+	template <typename T, typename... Args>
+	T *make(Args &&...args) {
+		void *memory = allocate(sizeof(T), alignof(T));
+		T *object = new (memory) T(std::forward<Args>(args)...);
+		_objectCount++;
+		if constexpr (!std::is_trivially_destructible_v<T>) {
+			_destructors.push_back({ [](void *o) { static_cast<T *>(o)->~T(); }, object });
+		}
+		return object;
+	}
+
+	void clear();
+	size_t objectCount() const { return _objectCount; }
+};
+
+} // namespace Common
+
+#endif // COMMON_ARENA_H
@@ -4,44 +4,65 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include <charconv>
+#include <utility>
+
 #include "common/codewriter.h"
 
 namespace Common {
 
-void CodeWriter::write(std::string str) {
+void CodeWriter::write(std::string_view str) {
 	if (str.empty())
 		return;
 
 	writeIndentation();
-	_stream << str;
+	_buffer.append(str);
 	_lineWidth += str.size();
-	_size += str.size();
 }
 
 void CodeWriter::write(char ch) {
 	writeIndentation();
-	_stream << ch;
+	_buffer += ch;
 	_lineWidth += 1;
-	_size += 1;
 }
 
-void CodeWriter::writeLine(std::string str) {
-	if (str.empty()) {
-		_stream << _lineEnding;
-	} else {
+template <typename T>
+void CodeWriter::writeInt(T val) {
+	char str[24];
+	auto res = std::to_chars(str, str + sizeof(str), val);
+	write(std::string_view(str, res.ptr - str));
+}
+
+void CodeWriter::write(int32_t val) {
+	writeInt(val);
+}
+
+void CodeWriter::write(uint32_t val) {
+	writeInt(val);
+}
+
+void CodeWriter::write(int64_t val) {
+	writeInt(val);
+}
+
+void CodeWriter::write(uint64_t val) {
+	writeInt(val);
+}
+
+void CodeWriter::writeLine(std::string_view str) {
+	if (!str.empty()) {
 		writeIndentation();
-		_stream << str << _lineEnding;
+		_buffer.append(str);
 	}
+	_buffer.append(_lineEnding);
 	_indentationWritten = false;
 	_lineWidth = 0;
-	_size += str.size() + _lineEnding.size();
 }
 
 void CodeWriter::writeLine() {
-	_stream << _lineEnding;
+	_buffer.append(_lineEnding);
 	_indentationWritten = false;
 	_lineWidth = 0;
-	_size += _lineEnding.size();
 }
 
 void CodeWriter::indent() {
@@ -54,8 +75,17 @@ void CodeWriter::unindent() {
 	}
 }
 
-std::string CodeWriter::str() const {
-	return _stream.str();
+void CodeWriter::clear() {
+	_buffer.clear();
+	_indentationLevel = 0;
+	_indentationWritten = false;
+	_lineWidth = 0;
+}
+
+std::string CodeWriter::take() {
+	std::string res = std::move(_buffer);
+	clear();
+	return res;
 }
 
 void CodeWriter::writeIndentation() {
@@ -63,12 +93,11 @@ void CodeWriter::writeIndentation() {
 		return;
 
 	for (int i = 0; i < _indentationLevel; i++) {
-		_stream << _indentation;
+		_buffer.append(_indentation);
 	}
 
 	_indentationWritten = true;
 	_lineWidth = _indentationLevel * _indentation.size();
-	_size += _lineWidth;
 }
 
 } // namespace Common
@@ -7,8 +7,9 @@
 #ifndef COMMON_CODEWRITER_H
 #define COMMON_CODEWRITER_H
 
+#include <cstdint>
 #include <string>
-#include <sstream>
+#include <string_view>
 
 namespace Common {
 
@@ -18,9 +19,12 @@ static const char *kPlatformLineEnding = "\r\n";
 static const char *kPlatformLineEnding = "\n";
 #endif
 
+// Output is appended to a single buffer. clear() keeps its capacity, so one
+// writer can be reused for many pieces of text, and take() moves the text out
+// without copying it.
 class CodeWriter {
 protected:
-	std::stringstream _stream;
+	std::string _buffer;
 
 	std::string _lineEnding;
 	std::string _indentation;
@@ -28,7 +32,6 @@ protected:
 	int _indentationLevel = 0;
 	bool _indentationWritten = false;
 	size_t _lineWidth = 0;
-	size_t _size = 0;
 
 public:
 	bool doIndentation = true;
@@ -37,19 +40,30 @@ public:
 	CodeWriter(std::string lineEnding = kPlatformLineEnding, std::string indentation = "  ")
 		: _lineEnding(lineEnding), _indentation(indentation) {}
 
-	void write(std::string str);
+	void write(std::string_view str);
 	void write(char ch);
-	void writeLine(std::string str);
+	void write(int32_t val);
+	void write(uint32_t val);
+	void write(int64_t val);
+	void write(uint64_t val);
+	void writeLine(std::string_view str);
 	void writeLine();
 
 	void indent();
 	void unindent();
 
-	std::string str() const;
+	void reserve(size_t size) { _buffer.reserve(size); }
+	void clear();
+	std::string take();
+
+	const std::string &str() const { return _buffer; }
+	const std::string &lineEnding() const { return _lineEnding; }
 	size_t lineWidth() const { return _lineWidth; }
-	size_t size() const { return _size; }
+	size_t size() const { return _buffer.size(); }
 
 protected:
+	template <typename T>
+	void writeInt(T val);
 	void writeIndentation();
 };
 
@@ -4,14 +4,349 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "common/fileio.h"
 #include "common/stream.h"
 
 namespace Common {
 
+/* MappedFile */
+
+MappedFile::MappedFile() : _data(nullptr), _size(0), _mapped(false), _fd(-1) {}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const std::filesystem::path &path) {
+	close();
+	_path = path;
+
+#ifndef _WIN32
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr != MAP_FAILED) {
+			_data = static_cast<uint8_t *>(addr);
+			_size = st.st_size;
+			_mapped = true;
+		}
+	}
+
+	// Keep the descriptor around so that FileWriter can copy from it.
+	if (_mapped) {
+		_fd = fd;
+		return true;
+	}
+	::close(fd);
+#endif
+
+	// Fall back to reading the whole file (empty files, pipes, Windows...)
+	if (!readFile(path, _buf))
+		return false;
+
+	_data = _buf.data();
+	_size = _buf.size();
+	return true;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+	if (_mapped)
+		munmap(_data, _size);
+	if (_fd != -1)
+		::close(_fd);
+#endif
+	_fd = -1;
+	_data = nullptr;
+	_size = 0;
+	_mapped = false;
+	_path.clear();
+	_buf.clear();
+	_buf.shrink_to_fit();
+}
+
+void MappedFile::advise(AccessPattern pattern) {
+	advise(0, _size, pattern);
+}
+
+void MappedFile::advise(size_t offset, size_t len, AccessPattern pattern) {
+#ifndef _WIN32
+	if (!_mapped || offset >= _size)
+		return;
+
+	// madvise requires a page-aligned address
+	size_t pageSize = sysconf(_SC_PAGESIZE);
+	size_t start = offset - (offset % pageSize);
+	len = std::min(len, _size - offset) + (offset - start);
+
+	int advice;
+	switch (pattern) {
+	case kAccessRandom:
+		advice = MADV_RANDOM;
+		break;
+	case kAccessSequential:
+		advice = MADV_SEQUENTIAL;
+		break;
+	case kAccessWillNeed:
+		advice = MADV_WILLNEED;
+		break;
+	default:
+		advice = MADV_NORMAL;
+		break;
+	}
+	madvise(_data + start, len, advice);
+#else
+	(void)offset;
+	(void)len;
+	(void)pattern;
+#endif
+}
+
+uint8_t *MappedFile::data() const {
+	return _data;
+}
+
+size_t MappedFile::size() const {
+	return _size;
+}
+
+bool MappedFile::mapped() const {
+	return _mapped;
+}
+
+int MappedFile::fd() const {
+	return _fd;
+}
+
+const std::filesystem::path &MappedFile::path() const {
+	return _path;
+}
+
+BufferView MappedFile::view() const {
+	return BufferView(_data, _size);
+}
+
+bool MappedFile::contains(const BufferView &view) const {
+	return _data && view.data() >= _data && view.data() + view.size() <= _data + _size;
+}
+
+/* OutputWriter */
+
+void OutputWriter::write(size_t offset, const BufferView &view) {
+	write(offset, view.data(), view.size());
+}
+
+void OutputWriter::copy(const MappedFile &source, size_t sourceOffset, size_t offset, size_t len) {
+	write(offset, source.data() + sourceOffset, len);
+}
+
+/* FileWriter */
+
+FileWriter::FileWriter() :
+#ifndef _WIN32
+	_fd(-1),
+#endif
+	_copySource(nullptr), _copySourceOffset(0), _copyOffset(0), _copyLen(0) {}
+
+FileWriter::~FileWriter() {
+	try {
+		close();
+	} catch (const std::exception &) {}
+}
+
+bool FileWriter::open(const std::filesystem::path &path, bool truncate) {
+	close();
+
+	_path = path;
+#ifndef _WIN32
+	_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | (truncate ? O_TRUNC : 0), 0666);
+	return _fd != -1;
+#else
+	if (truncate) {
+		_stream.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	} else {
+		_stream.open(path, std::ios::in | std::ios::out | std::ios::binary);
+	}
+	return !_stream.fail();
+#endif
+}
+
+void FileWriter::close() {
+#ifndef _WIN32
+	if (_fd == -1)
+		return;
+
+	flush();
+	int fd = _fd;
+	_fd = -1;
+	if (::close(fd) == -1) {
+		throw std::runtime_error("Could not write " + _path.string() + ": " + strerror(errno));
+	}
+#else
+	if (!_stream.is_open())
+		return;
+
+	flush();
+	_stream.close();
+	if (_stream.fail()) {
+		throw std::runtime_error("Could not write " + _path.string());
+	}
+#endif
+}
+
+void FileWriter::write(size_t offset, const uint8_t *data, size_t len) {
+#ifndef _WIN32
+	while (len > 0) {
+		ssize_t written = pwrite(_fd, data, len, offset);
+		if (written == -1) {
+			if (errno == EINTR)
+				continue;
+			throw std::runtime_error("Could not write " + _path.string() + ": " + strerror(errno));
+		}
+		data += written;
+		offset += written;
+		len -= written;
+	}
+#else
+	std::lock_guard<std::mutex> lock(_mutex);
+	_stream.seekp(offset);
+	_stream.write((const char *)data, len);
+	if (_stream.fail()) {
+		throw std::runtime_error("Could not write " + _path.string());
+	}
+#endif
+}
+
+void FileWriter::copy(const MappedFile &source, size_t sourceOffset, size_t offset, size_t len) {
+	if (_copySource == &source
+			&& _copySourceOffset + _copyLen == sourceOffset
+			&& _copyOffset + _copyLen == offset) {
+		_copyLen += len;
+		return;
+	}
+
+	flush();
+	_copySource = &source;
+	_copySourceOffset = sourceOffset;
+	_copyOffset = offset;
+	_copyLen = len;
+}
+
+void FileWriter::flush() {
+	if (!_copySource || _copyLen == 0)
+		return;
+
+	const MappedFile &source = *_copySource;
+	size_t sourceOffset = _copySourceOffset;
+	size_t offset = _copyOffset;
+	size_t len = _copyLen;
+	_copySource = nullptr;
+	_copyLen = 0;
+
+#ifdef __linux__
+	// Let the kernel move the data. This can fail for reasons that don't
+	// affect an ordinary write (old kernels, copying between filesystems),
+	// in which case whatever's left is written from the mapping below.
+	if (source.fd() != -1) {
+		loff_t in = sourceOffset;
+		loff_t out = offset;
+		while (len > 0) {
+			ssize_t copied = copy_file_range(source.fd(), &in, _fd, &out, len, 0);
+			if (copied == -1 && errno == EINTR)
+				continue;
+			if (copied <= 0)
+				break;
+			len -= copied;
+		}
+		sourceOffset = in;
+		offset = out;
+	}
+#endif
+	if (len > 0) {
+		write(offset, source.data() + sourceOffset, len);
+	}
+}
+
+void FileWriter::sync() {
+	flush();
+#ifndef _WIN32
+	if (fsync(_fd) == -1) {
+		throw std::runtime_error("Could not write " + _path.string() + ": " + strerror(errno));
+	}
+#else
+	std::lock_guard<std::mutex> lock(_mutex);
+	_stream.flush();
+	if (_stream.fail()) {
+		throw std::runtime_error("Could not write " + _path.string());
+	}
+#endif
+}
+
+/* BufferWriter */
+
+BufferWriter::BufferWriter(uint8_t *data, size_t size) : _data(data), _size(size) {}
+
+void BufferWriter::write(size_t offset, const uint8_t *data, size_t len) {
+	if (offset > _size || len > _size - offset) {
+		throw std::runtime_error("Write past end of output buffer");
+	}
+	memcpy(_data + offset, data, len);
+}
+
+/* FileSink */
+
+bool FileSink::open(const std::filesystem::path &path) {
+	_path = path;
+	_stream.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	return !_stream.fail();
+}
+
+void FileSink::close() {
+	if (!_stream.is_open())
+		return;
+
+	_stream.close();
+	if (_stream.fail())
+		throw std::runtime_error("Could not write " + _path.string());
+}
+
+void FileSink::write(const char *data, size_t len) {
+	_stream.write(data, len);
+	if (_stream.fail())
+		throw std::runtime_error("Could not write " + _path.string());
+}
+
+void FileSink::flush() {
+	_stream.flush();
+	if (_stream.fail())
+		throw std::runtime_error("Could not write " + _path.string());
+}
+
+/* StringSink */
+
+void StringSink::write(const char *data, size_t len) {
+	_str.append(data, len);
+}
+
 bool readFile(const std::filesystem::path &path, std::vector<uint8_t> &buf) {
 	std::ifstream f;
 	f.open(path, std::ios::in | std::ios::binary);
@@ -21,6 +356,13 @@ bool readFile(const std::filesystem::path &path, std::vector<uint8_t> &buf) {
 
 	f.seekg(0, std::ios::end);
 	auto fileSize = f.tellg();
+	if (fileSize == -1) {
+		// Not seekable (e.g. a pipe), so read until EOF
+		f.clear();
+		buf.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+		f.close();
+		return true;
+	}
 	f.seekg(0, std::ios::beg);
 	buf.resize(fileSize);
 	f.read((char *)buf.data(), fileSize);
@@ -29,7 +371,7 @@ bool readFile(const std::filesystem::path &path, std::vector<uint8_t> &buf) {
 	return true;
 }
 
-void writeFile(const std::filesystem::path &path, const std::string &contents) {
+void writeFile(const std::filesystem::path &path, std::string_view contents) {
 	std::ofstream f;
 	f.open(path, std::ios::out | std::ios::binary);
 	f << contents;
@@ -9,16 +9,171 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <fstream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace Common {
 
 class BufferView;
 
+enum AccessPattern {
+	kAccessNormal,
+	kAccessRandom,
+	kAccessSequential,
+	kAccessWillNeed
+};
+
+/* MappedFile */
+
+// Read-only view of a file on disk. Where the platform supports it, the file
+// is mapped into memory rather than copied, so pages are only read in as the
+// data is touched. Otherwise, the whole file is read into a buffer.
+class MappedFile {
+private:
+	uint8_t *_data;
+	size_t _size;
+	bool _mapped;
+	int _fd;
+	std::filesystem::path _path;
+	std::vector<uint8_t> _buf;
+
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	bool open(const std::filesystem::path &path);
+	void close();
+	void advise(AccessPattern pattern);
+	void advise(size_t offset, size_t len, AccessPattern pattern);
+
+	uint8_t *data() const;
+	size_t size() const;
+	bool mapped() const;
+	int fd() const;
+	const std::filesystem::path &path() const;
+	BufferView view() const;
+	bool contains(const BufferView &view) const;
+};
+
+/* OutputWriter */
+
+// Destination written at explicit offsets, so that separate regions can be
+// filled in any order and from several threads at once. Throws
+// std::runtime_error if a write fails.
+class OutputWriter {
+public:
+	virtual ~OutputWriter() = default;
+
+	virtual void write(size_t offset, const uint8_t *data, size_t len) = 0;
+	void write(size_t offset, const BufferView &view);
+	// Writes may be held back until flush(). Not thread-safe, unlike write().
+	virtual void copy(const MappedFile &source, size_t sourceOffset, size_t offset, size_t len);
+	virtual void flush() {}
+};
+
+/* FileWriter */
+
+// Output file on disk. Ranges of a MappedFile can be copied in without
+// passing through user space where the platform allows it.
+class FileWriter : public OutputWriter {
+private:
+#ifndef _WIN32
+	int _fd;
+#else
+	std::fstream _stream;
+	std::mutex _mutex;
+#endif
+	std::filesystem::path _path;
+
+	// Adjacent copies are merged into one before being issued.
+	const MappedFile *_copySource;
+	size_t _copySourceOffset;
+	size_t _copyOffset;
+	size_t _copyLen;
+
+public:
+	FileWriter();
+	~FileWriter();
+	FileWriter(const FileWriter &) = delete;
+	FileWriter &operator=(const FileWriter &) = delete;
+
+	// Unless truncate is false, existing contents are discarded.
+	bool open(const std::filesystem::path &path, bool truncate = true);
+	void close();
+
+	using OutputWriter::write;
+	void write(size_t offset, const uint8_t *data, size_t len) override;
+	// Copies are held back until flush() or close() so that adjacent ones
+	// can be merged.
+	void copy(const MappedFile &source, size_t sourceOffset, size_t offset, size_t len) override;
+	void flush() override;
+	// Flushes, then waits until everything written so far is on disk.
+	void sync();
+};
+
+/* BufferWriter */
+
+// Output into a fixed-size buffer owned by the caller.
+class BufferWriter : public OutputWriter {
+private:
+	uint8_t *_data;
+	size_t _size;
+
+public:
+	BufferWriter(uint8_t *data, size_t size);
+
+	using OutputWriter::write;
+	void write(size_t offset, const uint8_t *data, size_t len) override;
+};
+
+/* OutputSink */
+
+// Destination for output produced front to back, such as a serialized
+// document. Throws std::runtime_error if a write fails.
+class OutputSink {
+public:
+	virtual ~OutputSink() = default;
+
+	virtual void write(const char *data, size_t len) = 0;
+	virtual void flush() {}
+};
+
+/* FileSink */
+
+class FileSink : public OutputSink {
+private:
+	std::ofstream _stream;
+	std::filesystem::path _path;
+
+public:
+	bool open(const std::filesystem::path &path);
+	void close();
+
+	void write(const char *data, size_t len) override;
+	void flush() override;
+};
+
+/* StringSink */
+
+// Output appended to a string owned by the caller.
+class StringSink : public OutputSink {
+private:
+	std::string &_str;
+
+public:
+	StringSink(std::string &str) : _str(str) {}
+
+	void write(const char *data, size_t len) override;
+};
+
 bool readFile(const std::filesystem::path &path, std::vector<uint8_t> &buf);
-void writeFile(const std::filesystem::path &path, const std::string &contents);
+void writeFile(const std::filesystem::path &path, std::string_view contents);
 void writeFile(const std::filesystem::path &path, const uint8_t *contents, size_t size);
 void writeFile(const std::filesystem::path &path, const BufferView &view);
 
@@ -0,0 +1,91 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstring>
+
+#include <boost/format.hpp>
+
+#include "common/hash.h"
+#include "common/stream.h"
+
+namespace Common {
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k) {
+	k ^= k >> 33;
+	k *= 0xff51afd7ed558ccdULL;
+	k ^= k >> 33;
+	k *= 0xc4ceb9fe1a85ec53ULL;
+	k ^= k >> 33;
+	return k;
+}
+
+// Blocks are read as little endian regardless of the host so that digests
+// stored on disk are portable.
+static inline uint64_t readLE64(const uint8_t *p) {
+	uint64_t res = 0;
+	for (int i = 7; i >= 0; i--) {
+		res = (res << 8) | p[i];
+	}
+	return res;
+}
+
+/* Hash128 */
+
+std::string Hash128::toString() const {
+	return boost::str(boost::format("%016x%016x") % h1 % h2);
+}
+
+Hash128 hash128(const void *data, size_t len, uint64_t seed) {
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+	const size_t blockCount = len / 16;
+	const uint64_t c1 = 0x87c37b91114253d5ULL;
+	const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+	uint64_t h1 = seed;
+	uint64_t h2 = seed;
+
+	for (size_t i = 0; i < blockCount; i++) {
+		uint64_t k1 = readLE64(bytes + i * 16);
+		uint64_t k2 = readLE64(bytes + i * 16 + 8);
+
+		k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+		h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+		k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+		h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+	}
+
+	const uint8_t *tail = bytes + blockCount * 16;
+	uint8_t padded[16] = {};
+	memcpy(padded, tail, len & 15);
+	uint64_t k1 = readLE64(padded);
+	uint64_t k2 = readLE64(padded + 8);
+	if (len & 15) {
+		k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+		k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+	}
+
+	h1 ^= len;
+	h2 ^= len;
+	h1 += h2;
+	h2 += h1;
+	h1 = fmix64(h1);
+	h2 = fmix64(h2);
+	h1 += h2;
+	h2 += h1;
+
+	return Hash128(h1, h2);
+}
+
+Hash128 hash128(const BufferView &view, uint64_t seed) {
+	return hash128(view.data(), view.size(), seed);
+}
+
+} // namespace Common
@@ -0,0 +1,40 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COMMON_HASH_H
+#define COMMON_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Common {
+
+class BufferView;
+
+/* Hash128 */
+
+// 128-bit MurmurHash3 (x64 variant) digest. Not cryptographic, but wide
+// enough to address content by its hash.
+struct Hash128 {
+	uint64_t h1;
+	uint64_t h2;
+
+	Hash128() : h1(0), h2(0) {}
+	Hash128(uint64_t a, uint64_t b) : h1(a), h2(b) {}
+
+	bool operator==(const Hash128 &other) const { return h1 == other.h1 && h2 == other.h2; }
+	bool operator!=(const Hash128 &other) const { return !(*this == other); }
+
+	std::string toString() const;
+};
+
+Hash128 hash128(const void *data, size_t len, uint64_t seed = 0);
+Hash128 hash128(const BufferView &view, uint64_t seed = 0);
+
+} // namespace Common
+
+#endif // COMMON_HASH_H
@@ -4,18 +4,54 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
 #include "common/json.h"
 #include "common/util.h"
 
 namespace Common {
 
-void JSONWriter::writeString(std::string str) {
-	write("\"");
-	write(escapeString(str));
-	write("\"");
+void JSONWriter::write(std::string_view str) {
+	writeIndentation();
+	_buffer.append(str);
+}
+
+void JSONWriter::writeLine() {
+	_buffer.append(_lineEnding);
+	_indentationWritten = false;
+}
+
+void JSONWriter::writeIndentation() {
+	if (_indentationWritten)
+		return;
+
+	for (int i = 0; i < _indentationLevel; i++) {
+		_buffer.append(_indentation);
+	}
+	_indentationWritten = true;
+}
+
+template <typename T>
+void JSONWriter::writeInt(T val) {
+	char str[24];
+	auto res = std::to_chars(str, str + sizeof(str), val);
+	write(std::string_view(str, res.ptr - str));
+}
+
+void JSONWriter::writeString(std::string_view str) {
+	writeIndentation();
+	_buffer += '"';
+	appendEscapedString(_buffer, str);
+	_buffer += '"';
 }
 
 void JSONWriter::writeValuePrefix() {
+	if (_sink && _buffer.size() >= kFlushSize) {
+		flush();
+	}
 	if (_context == kContextValue) {
 		write(",");
 	}
@@ -39,11 +75,11 @@ void JSONWriter::writeCloseBracePrefix() {
 void JSONWriter::startObject() {
 	writeValuePrefix();
 	write("{");
-	indent();
+	_indentationLevel++;
 	_context = kContextOpenBrace;
 }
 
-void JSONWriter::writeKey(std::string key) {
+void JSONWriter::writeKey(std::string_view key) {
 	writeValuePrefix();
 	writeString(key);
 	write(": ");
@@ -52,7 +88,9 @@ void JSONWriter::writeKey(std::string key) {
 
 void JSONWriter::endObject() {
 	writeCloseBracePrefix();
-	unindent();
+	if (_indentationLevel > 0) {
+		_indentationLevel--;
+	}
 	write("}");
 	_context = kContextValue;
 	writeValueSuffix();
@@ -61,13 +99,15 @@ void JSONWriter::endObject() {
 void JSONWriter::startArray() {
 	writeValuePrefix();
 	write("[");
-	indent();
+	_indentationLevel++;
 	_context = kContextOpenBrace;
 }
 
 void JSONWriter::endArray() {
 	writeCloseBracePrefix();
-	unindent();
+	if (_indentationLevel > 0) {
+		_indentationLevel--;
+	}
 	write("]");
 	_context = kContextValue;
 	writeValueSuffix();
@@ -75,14 +115,21 @@ void JSONWriter::endArray() {
 
 void JSONWriter::writeVal(unsigned int val) {
 	writeValuePrefix();
-	write(std::to_string(val));
+	writeInt(val);
 	_context = kContextValue;
 	writeValueSuffix();
 }
 
 void JSONWriter::writeVal(int val) {
 	writeValuePrefix();
-	write(std::to_string(val));
+	writeInt(val);
+	_context = kContextValue;
+	writeValueSuffix();
+}
+
+void JSONWriter::writeVal(uint64_t val) {
+	writeValuePrefix();
+	writeInt(val);
 	_context = kContextValue;
 	writeValueSuffix();
 }
@@ -94,13 +141,20 @@ void JSONWriter::writeVal(double val) {
 	writeValueSuffix();
 }
 
-void JSONWriter::writeVal(std::string val) {
+void JSONWriter::writeVal(std::string_view val) {
 	writeValuePrefix();
 	writeString(val);
 	_context = kContextValue;
 	writeValueSuffix();
 }
 
+void JSONWriter::writeBool(bool val) {
+	writeValuePrefix();
+	write(val ? "true" : "false");
+	_context = kContextValue;
+	writeValueSuffix();
+}
+
 void JSONWriter::writeNull() {
 	writeValuePrefix();
 	write("null");
@@ -117,8 +171,241 @@ void JSONWriter::writeFourCC(uint32_t val) {
 	writeValueSuffix();
 }
 
-std::string JSONWriter::str() const {
-	return CodeWriter::str();
+void JSONWriter::flush() {
+	if (!_sink || _buffer.empty())
+		return;
+
+	_sink->write(_buffer.data(), _buffer.size());
+	_buffer.clear();
+}
+
+/* JSONValue */
+
+const JSONValue *JSONValue::get(const std::string &key) const {
+	for (const auto &[name, value] : objectVal) {
+		if (name == key)
+			return &value;
+	}
+	return nullptr;
+}
+
+// Recursive descent parser. Errors are thrown as std::runtime_error and
+// caught by parseJSON.
+class JSONReader {
+private:
+	const std::string &_text;
+	size_t _pos;
+	int _depth;
+
+	static const int kMaxDepth = 64;
+
+	[[noreturn]] void fail(const std::string &msg) {
+		throw std::runtime_error(msg + " at offset " + std::to_string(_pos));
+	}
+
+	void skipWhitespace() {
+		while (_pos < _text.size() && (_text[_pos] == ' ' || _text[_pos] == '\t'
+				|| _text[_pos] == '\n' || _text[_pos] == '\r')) {
+			_pos++;
+		}
+	}
+
+	char peek() {
+		skipWhitespace();
+		if (_pos >= _text.size())
+			fail("Unexpected end of input");
+		return _text[_pos];
+	}
+
+	void expect(char ch) {
+		if (peek() != ch)
+			fail(std::string("Expected '") + ch + "'");
+		_pos++;
+	}
+
+	void expectWord(const char *word) {
+		for (const char *p = word; *p; p++, _pos++) {
+			if (_pos >= _text.size() || _text[_pos] != *p)
+				fail(std::string("Expected ") + word);
+		}
+	}
+
+	unsigned int readHex(size_t digits) {
+		if (_pos + digits > _text.size())
+			fail("Truncated escape sequence");
+		std::string hex = _text.substr(_pos, digits);
+		char *end;
+		unsigned long res = strtoul(hex.c_str(), &end, 16);
+		if (end != hex.c_str() + digits)
+			fail("Invalid escape sequence");
+		_pos += digits;
+		return res;
+	}
+
+	static void appendUTF8(std::string &res, unsigned int cp) {
+		if (cp < 0x80) {
+			res += (char)cp;
+		} else if (cp < 0x800) {
+			res += (char)(0xC0 | (cp >> 6));
+			res += (char)(0x80 | (cp & 0x3F));
+		} else if (cp < 0x10000) {
+			res += (char)(0xE0 | (cp >> 12));
+			res += (char)(0x80 | ((cp >> 6) & 0x3F));
+			res += (char)(0x80 | (cp & 0x3F));
+		} else {
+			res += (char)(0xF0 | (cp >> 18));
+			res += (char)(0x80 | ((cp >> 12) & 0x3F));
+			res += (char)(0x80 | ((cp >> 6) & 0x3F));
+			res += (char)(0x80 | (cp & 0x3F));
+		}
+	}
+
+	std::string readString() {
+		expect('"');
+		std::string res;
+		while (true) {
+			if (_pos >= _text.size())
+				fail("Unterminated string");
+			char ch = _text[_pos++];
+			if (ch == '"')
+				break;
+			if (ch != '\\') {
+				res += ch;
+				continue;
+			}
+			if (_pos >= _text.size())
+				fail("Unterminated string");
+			char esc = _text[_pos++];
+			switch (esc) {
+			case '"': res += '"'; break;
+			case '\\': res += '\\'; break;
+			case '/': res += '/'; break;
+			case 'b': res += '\b'; break;
+			case 'f': res += '\f'; break;
+			case 'n': res += '\n'; break;
+			case 'r': res += '\r'; break;
+			case 't': res += '\t'; break;
+			case 'v': res += '\v'; break;
+			case 'x': res += (char)readHex(2); break;
+			case 'u':
+				{
+					unsigned int cp = readHex(4);
+					if (cp >= 0xD800 && cp < 0xDC00 && _text.compare(_pos, 2, "\\u") == 0) {
+						_pos += 2;
+						unsigned int low = readHex(4);
+						cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+					}
+					appendUTF8(res, cp);
+				}
+				break;
+			default:
+				fail(std::string("Invalid escape sequence \\") + esc);
+			}
+		}
+		return res;
+	}
+
+	double readNumber() {
+		const char *start = _text.c_str() + _pos;
+		char *end;
+		double res = strtod(start, &end);
+		// strtod also accepts inf and nan, which JSON doesn't have.
+		if (end == start || !std::isfinite(res))
+			fail("Invalid number");
+		_pos += end - start;
+		return res;
+	}
+
+public:
+	JSONReader(const std::string &text) : _text(text), _pos(0), _depth(0) {}
+
+	void readValue(JSONValue &value) {
+		if (++_depth > kMaxDepth)
+			fail("Nesting too deep");
+
+		char ch = peek();
+		switch (ch) {
+		case '{':
+			value.type = JSONValue::kJSONObject;
+			_pos++;
+			if (peek() == '}') {
+				_pos++;
+				break;
+			}
+			while (true) {
+				std::string key = readString();
+				expect(':');
+				value.objectVal.emplace_back(std::move(key), JSONValue());
+				readValue(value.objectVal.back().second);
+				if (peek() == '}') {
+					_pos++;
+					break;
+				}
+				expect(',');
+			}
+			break;
+		case '[':
+			value.type = JSONValue::kJSONArray;
+			_pos++;
+			if (peek() == ']') {
+				_pos++;
+				break;
+			}
+			while (true) {
+				value.arrayVal.emplace_back();
+				readValue(value.arrayVal.back());
+				if (peek() == ']') {
+					_pos++;
+					break;
+				}
+				expect(',');
+			}
+			break;
+		case '"':
+			value.type = JSONValue::kJSONString;
+			value.stringVal = readString();
+			break;
+		case 't':
+			expectWord("true");
+			value.type = JSONValue::kJSONBool;
+			value.boolVal = true;
+			break;
+		case 'f':
+			expectWord("false");
+			value.type = JSONValue::kJSONBool;
+			value.boolVal = false;
+			break;
+		case 'n':
+			expectWord("null");
+			value.type = JSONValue::kJSONNull;
+			break;
+		default:
+			value.type = JSONValue::kJSONNumber;
+			value.numberVal = readNumber();
+			break;
+		}
+
+		_depth--;
+	}
+
+	void readEnd() {
+		skipWhitespace();
+		if (_pos != _text.size())
+			fail("Trailing characters");
+	}
+};
+
+bool parseJSON(const std::string &text, JSONValue &value, std::string &error) {
+	value = JSONValue();
+	try {
+		JSONReader reader(text);
+		reader.readValue(value);
+		reader.readEnd();
+	} catch (const std::runtime_error &e) {
+		error = e.what();
+		return false;
+	}
+	return true;
 }
 
 } // namespace Common
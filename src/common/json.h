@@ -7,7 +7,13 @@
 #ifndef COMMON_JSON_H
 #define COMMON_JSON_H
 
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 #include "common/codewriter.h"
+#include "common/fileio.h"
 #include "common/util.h"
 
 namespace Common {
@@ -24,7 +30,7 @@ namespace Common {
  * - The non-standard hex code escape sequence \xXX
  */
 
-class JSONWriter : protected CodeWriter {
+class JSONWriter {
 protected:
 	enum Context {
 		kContextStart,
@@ -33,11 +39,31 @@ protected:
 		kContextValue
 	};
 
+	// Output is collected here and handed to the sink in blocks of at least
+	// this size.
+	static const size_t kFlushSize = 64 * 1024;
+
+	OutputSink *_sink = nullptr;
+	std::string _buffer;
+
+	std::string _lineEnding;
+	std::string _indentation;
+	int _indentationLevel = 0;
+	bool _indentationWritten = false;
+
 	Context _context = kContextStart;
 
 public:
+	// Without a sink, the whole document is kept in memory for str().
+	// A writer with an empty line ending and indentation writes everything
+	// on one line, as in JSON Lines.
+	JSONWriter(std::string lineEnding = kPlatformLineEnding, std::string indentation = "  ")
+		: _lineEnding(lineEnding), _indentation(indentation) {}
+	JSONWriter(OutputSink &sink, std::string lineEnding = kPlatformLineEnding, std::string indentation = "  ")
+		: _sink(&sink), _lineEnding(lineEnding), _indentation(indentation) {}
+
 	void startObject();
-	void writeKey(std::string key);
+	void writeKey(std::string_view key);
 	void endObject();
 
 	void startArray();
@@ -45,20 +71,58 @@ public:
 
 	void writeVal(unsigned int val);
 	void writeVal(int val);
+	void writeVal(uint64_t val);
 	void writeVal(double val);
-	void writeVal(std::string val);
+	void writeVal(std::string_view val);
+	void writeBool(bool val);
 	void writeNull();
 	void writeFourCC(uint32_t val);
 
-	std::string str() const;
+	// Hands anything still buffered to the sink. Must be called once the
+	// document is complete.
+	void flush();
+	const std::string &str() const { return _buffer; }
 
 protected:
-	void writeString(std::string str);
+	void write(std::string_view str);
+	void writeLine();
+	void writeIndentation();
+	template <typename T>
+	void writeInt(T val);
+	void writeString(std::string_view str);
 	void writeValuePrefix();
 	void writeValueSuffix();
 	void writeCloseBracePrefix();
 };
 
+/* JSONValue */
+
+// A parsed JSON value. parseJSON accepts standard JSON as well as the variant
+// that JSONWriter writes. \uXXXX escapes are decoded to UTF-8.
+struct JSONValue {
+	enum Type {
+		kJSONNull,
+		kJSONBool,
+		kJSONNumber,
+		kJSONString,
+		kJSONArray,
+		kJSONObject
+	};
+
+	Type type = kJSONNull;
+	bool boolVal = false;
+	double numberVal = 0;
+	std::string stringVal;
+	std::vector<JSONValue> arrayVal;
+	// Members are kept in the order they were written.
+	std::vector<std::pair<std::string, JSONValue>> objectVal;
+
+	const JSONValue *get(const std::string &key) const;
+	bool isString() const { return type == kJSONString; }
+};
+
+bool parseJSON(const std::string &text, JSONValue &value, std::string &error);
+
 #define JSON_WRITE_FIELD(field) \
 	do { \
 		json.writeKey(#field); \
@@ -4,38 +4,196 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 #include "common/log.h"
 
 namespace Common {
 
-bool g_verbose = false;
+LogLevel g_logLevel = kLogLevelInfo;
+
+/* LogSink */
+
+// Writes messages to stdout and stderr on a thread of its own, so logging
+// only costs a queue push. Messages come out in the order they were queued,
+// and a batch queued in one go comes out in one piece.
+class LogSink {
+private:
+	std::mutex _mutex;
+	std::condition_variable _queued;
+	std::condition_variable _written;
+	std::vector<LogMessage> _queue;
+	bool _writing;
+	bool _stopping;
+	std::thread _thread;
+
+	void run();
+
+public:
+	LogSink();
+	~LogSink();
+
+	void push(const LogMessage *messages, size_t count);
+	void flush();
+};
+
+LogSink::LogSink() : _writing(false), _stopping(false) {}
+
+LogSink::~LogSink() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_queued.notify_one();
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+}
+
+void LogSink::push(const LogMessage *messages, size_t count) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_thread.joinable()) {
+			_thread = std::thread(&LogSink::run, this);
+		}
+		_queue.insert(_queue.end(), messages, messages + count);
+	}
+	_queued.notify_one();
+}
+
+void LogSink::flush() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	_written.wait(lock, [this] { return _queue.empty() && !_writing; });
+}
+
+void LogSink::run() {
+	std::vector<LogMessage> batch;
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_queued.wait(lock, [this] { return !_queue.empty() || _stopping; });
+		if (_queue.empty())
+			break;
+
+		batch.swap(_queue);
+		_writing = true;
+		lock.unlock();
+
+		for (const auto &message : batch) {
+			if (message.isWarning) {
+				std::cerr << message.text << "\n";
+			} else {
+				std::cout << message.text << "\n";
+			}
+		}
+		std::cout.flush();
+		batch.clear();
+
+		lock.lock();
+		_writing = false;
+		_written.notify_all();
+	}
+}
+
+static LogSink &sink() {
+	static LogSink s;
+	return s;
+}
+
+static thread_local LogCapture *t_capture = nullptr;
+
+static void output(bool isWarning, const std::string &msg) {
+	if (t_capture) {
+		t_capture->append(isWarning, msg);
+		return;
+	}
+
+	LogMessage message = { isWarning, msg };
+	sink().push(&message, 1);
+}
 
 void log(const std::string &msg) {
-	std::cout << msg << "\n";
+	if (logLevelEnabled(kLogLevelInfo))
+		output(false, msg);
 }
 
 void log(const boost::format &msg) {
-	std::cout << msg << "\n";
+	if (logLevelEnabled(kLogLevelInfo))
+		output(false, msg.str());
 }
 
 void debug(const std::string &msg) {
-	if (g_verbose)
+	if (logLevelEnabled(kLogLevelDebug))
 		log(msg);
 }
 
 void debug(const boost::format &msg) {
-	if (g_verbose)
+	if (logLevelEnabled(kLogLevelDebug))
 		log(msg);
 }
 
 void warning(const std::string &msg) {
-	std::cerr << msg << "\n";
+	if (logLevelEnabled(kLogLevelWarning))
+		output(true, msg);
 }
 
 void warning(const boost::format &msg) {
-	std::cerr << msg << "\n";
+	if (logLevelEnabled(kLogLevelWarning))
+		output(true, msg.str());
+}
+
+void replay(const std::vector<LogMessage> &messages) {
+	if (t_capture) {
+		for (const auto &message : messages) {
+			t_capture->append(message.isWarning, message.text);
+		}
+		return;
+	}
+
+	sink().push(messages.data(), messages.size());
+}
+
+void flushLog() {
+	sink().flush();
+}
+
+/* LogCapture */
+
+LogCapture::LogCapture() : _prev(t_capture) {
+	t_capture = this;
+}
+
+LogCapture::~LogCapture() {
+	flush();
+	t_capture = _prev;
+}
+
+void LogCapture::append(bool isWarning, const std::string &text) {
+	_messages.push_back({ isWarning, text });
+}
+
+void LogCapture::flush() {
+	if (_messages.empty())
+		return;
+
+	if (_prev) {
+		for (const auto &message : _messages) {
+			_prev->append(message.isWarning, message.text);
+		}
+		_messages.clear();
+		return;
+	}
+
+	sink().push(_messages.data(), _messages.size());
+	_messages.clear();
+}
+
+std::vector<LogMessage> LogCapture::take() {
+	std::vector<LogMessage> messages;
+	messages.swap(_messages);
+	return messages;
 }
 
 } // namespace Common
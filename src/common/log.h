@@ -8,11 +8,22 @@
 #define COMMON_LOG_H
 
 #include <string>
+#include <vector>
 #include <boost/format.hpp>
 
 namespace Common {
 
-extern bool g_verbose;
+enum LogLevel {
+	kLogLevelDebug,
+	kLogLevelInfo,
+	kLogLevelWarning
+};
+
+extern LogLevel g_logLevel;
+
+inline bool logLevelEnabled(LogLevel level) {
+	return level >= g_logLevel;
+}
 
 void log(const std::string &msg);
 void log(const boost::format &msg);
@@ -21,6 +32,47 @@ void debug(const boost::format &msg);
 void warning(const std::string &msg);
 void warning(const boost::format &msg);
 
+struct LogMessage {
+	bool isWarning;
+	std::string text;
+};
+
+// Logs previously captured messages as if they had just been logged.
+void replay(const std::vector<LogMessage> &messages);
+
+// Messages are written out by a background thread. This blocks until
+// everything logged so far has been written.
+void flushLog();
+
+/* LogCapture */
+
+// While a LogCapture is alive, messages logged on the thread that created it
+// are held back and written out in one piece when it's flushed or destroyed,
+// so output from files processed concurrently doesn't interleave.
+class LogCapture {
+private:
+	std::vector<LogMessage> _messages;
+	LogCapture *_prev;
+
+public:
+	LogCapture();
+	~LogCapture();
+	LogCapture(const LogCapture &) = delete;
+	LogCapture &operator=(const LogCapture &) = delete;
+
+	void append(bool isWarning, const std::string &text);
+	void flush();
+	std::vector<LogMessage> take();
+};
+
 } // namespace Common
 
+// Only evaluates the message when debug output is enabled, so that disabled
+// debug logging costs a single branch and formats nothing.
+#define LOG_DEBUG(...) \
+	do { \
+		if (Common::logLevelEnabled(Common::kLogLevelDebug)) \
+			Common::debug(__VA_ARGS__); \
+	} while (0)
+
 #endif // COMMON_LOG_H
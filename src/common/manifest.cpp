@@ -0,0 +1,211 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include <exception>
+#include <fstream>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "common/fileio.h"
+#include "common/log.h"
+#include "common/manifest.h"
+#include "common/stream.h"
+#include "common/util.h"
+
+namespace fs = std::filesystem;
+
+namespace Common {
+
+static const uint32_t kManifestMagic = FOURCC('P', 'R', 'M', 'F');
+static const uint16_t kManifestFormatVersion = 1;
+
+static uint64_t readUint64(ReadStream &stream) {
+	uint64_t high = stream.readUint32();
+	return (high << 32) | stream.readUint32();
+}
+
+static void writeUint64(WriteStream &stream, uint64_t value) {
+	stream.writeUint32(value >> 32);
+	stream.writeUint32(value & 0xFFFFFFFF);
+}
+
+static std::string readLongString(ReadStream &stream) {
+	uint32_t len = stream.readUint32();
+	return stream.readString(len);
+}
+
+static void writeLongString(WriteStream &stream, const std::string &value) {
+	stream.writeUint32(value.size());
+	stream.writeString(value);
+}
+
+/* Manifest */
+
+Manifest::Manifest(const fs::path &path, const std::string &fingerprint)
+	: _path(path), _fingerprint(fingerprint), _dirty(false) {}
+
+std::string Manifest::key(const fs::path &input) {
+	std::error_code ec;
+	fs::path absolute = fs::absolute(input, ec);
+	return (ec ? input : absolute).lexically_normal().string();
+}
+
+bool Manifest::stat(const fs::path &path, FileState &state) {
+	std::error_code ec;
+	state.size = fs::file_size(path, ec);
+	if (ec)
+		return false;
+	state.mtime = fs::last_write_time(path, ec).time_since_epoch().count();
+	return !ec;
+}
+
+bool Manifest::hashFile(const fs::path &path, Hash128 &hash) {
+	MappedFile file;
+	if (!file.open(path))
+		return false;
+	file.advise(kAccessSequential);
+	hash = hash128(file.view());
+	return true;
+}
+
+void Manifest::load() {
+	std::vector<uint8_t> buf;
+	if (!readFile(_path, buf))
+		return;
+
+	try {
+		ReadStream stream(buf.data(), buf.size());
+		if (stream.readUint32() != kManifestMagic || stream.readUint16() != kManifestFormatVersion)
+			return;
+		if (readLongString(stream) != _fingerprint) {
+			log("Tool version or options changed, processing all files");
+			return;
+		}
+
+		uint32_t count = stream.readUint32();
+		_entries.reserve(count);
+		for (uint32_t i = 0; i < count; i++) {
+			std::string input = readLongString(stream);
+			Entry entry;
+			entry.input.size = readUint64(stream);
+			entry.input.mtime = readUint64(stream);
+			entry.hash.h1 = readUint64(stream);
+			entry.hash.h2 = readUint64(stream);
+			entry.output = readLongString(stream);
+			entry.outputState.size = readUint64(stream);
+			entry.outputState.mtime = readUint64(stream);
+			_entries.emplace(std::move(input), std::move(entry));
+		}
+	} catch (const std::exception &) {
+		warning(boost::format("Ignoring damaged manifest %s") % _path.string());
+		_entries.clear();
+	}
+}
+
+bool Manifest::save() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_dirty)
+		return true;
+
+	size_t size = 4 + 2 + 4 + _fingerprint.size() + 4;
+	for (const auto &[input, entry] : _entries) {
+		size += 4 + input.size() + 4 * 8 + 4 + entry.output.size() + 2 * 8;
+	}
+
+	std::vector<uint8_t> buf(size);
+	WriteStream stream(buf.data(), buf.size());
+	stream.writeUint32(kManifestMagic);
+	stream.writeUint16(kManifestFormatVersion);
+	writeLongString(stream, _fingerprint);
+	stream.writeUint32(_entries.size());
+	for (const auto &[input, entry] : _entries) {
+		writeLongString(stream, input);
+		writeUint64(stream, entry.input.size);
+		writeUint64(stream, entry.input.mtime);
+		writeUint64(stream, entry.hash.h1);
+		writeUint64(stream, entry.hash.h2);
+		writeLongString(stream, entry.output);
+		writeUint64(stream, entry.outputState.size);
+		writeUint64(stream, entry.outputState.mtime);
+	}
+
+	// Replace the old manifest in one step so that an interrupted run
+	// leaves it intact.
+	fs::path tempPath = _path;
+	tempPath += ".tmp";
+	std::ofstream f(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	f.write((const char *)buf.data(), buf.size());
+	f.close();
+	std::error_code ec;
+	if (!f.fail()) {
+		fs::rename(tempPath, _path, ec);
+	}
+	if (f.fail() || ec) {
+		warning(boost::format("Could not write manifest %s") % _path.string());
+		fs::remove(tempPath, ec);
+		return false;
+	}
+	_dirty = false;
+	return true;
+}
+
+bool Manifest::upToDate(const fs::path &input) {
+	std::string inputKey = key(input);
+	Entry entry;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _entries.find(inputKey);
+		if (it == _entries.end())
+			return false;
+		entry = it->second;
+	}
+
+	FileState inputState, outputState;
+	if (!stat(input, inputState) || inputState.size != entry.input.size)
+		return false;
+	if (!stat(entry.output, outputState) || outputState.size != entry.outputState.size
+			|| outputState.mtime != entry.outputState.mtime)
+		return false;
+	if (inputState.mtime == entry.input.mtime)
+		return true;
+
+	// Touched, but maybe not changed.
+	Hash128 hash;
+	if (!hashFile(input, hash) || hash != entry.hash)
+		return false;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_entries[inputKey].input.mtime = inputState.mtime;
+	_dirty = true;
+	return true;
+}
+
+void Manifest::update(const fs::path &input, const fs::path &output) {
+	Entry entry;
+	if (!stat(input, entry.input) || !hashFile(input, entry.hash)) {
+		remove(input);
+		return;
+	}
+	entry.output = key(output);
+	if (!stat(entry.output, entry.outputState)) {
+		remove(input);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_entries[key(input)] = std::move(entry);
+	_dirty = true;
+}
+
+void Manifest::remove(const fs::path &input) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_entries.erase(key(input)) > 0) {
+		_dirty = true;
+	}
+}
+
+} // namespace Common
@@ -0,0 +1,66 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COMMON_MANIFEST_H
+#define COMMON_MANIFEST_H
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/hash.h"
+
+namespace Common {
+
+/* Manifest */
+
+// Record of the inputs a previous run processed and the outputs it wrote,
+// used to skip inputs that haven't changed since. An input is unchanged if
+// its size and modification time match, or failing that, if its contents
+// hash the same. Its output must also still be there as it was written.
+// The whole manifest is thrown away when the fingerprint of the tool
+// version and options that affect the output changes. Safe to use from
+// several threads at once.
+class Manifest {
+private:
+	struct FileState {
+		uint64_t size;
+		int64_t mtime;
+	};
+
+	struct Entry {
+		FileState input;
+		Hash128 hash;
+		std::string output;
+		FileState outputState;
+	};
+
+	std::filesystem::path _path;
+	std::string _fingerprint;
+	std::unordered_map<std::string, Entry> _entries;
+	std::mutex _mutex;
+	bool _dirty;
+
+	static std::string key(const std::filesystem::path &input);
+	static bool stat(const std::filesystem::path &path, FileState &state);
+	static bool hashFile(const std::filesystem::path &path, Hash128 &hash);
+
+public:
+	Manifest(const std::filesystem::path &path, const std::string &fingerprint);
+
+	void load();
+	bool save();
+
+	bool upToDate(const std::filesystem::path &input);
+	void update(const std::filesystem::path &input, const std::filesystem::path &output);
+	void remove(const std::filesystem::path &input);
+};
+
+} // namespace Common
+
+#endif // COMMON_MANIFEST_H
@@ -16,7 +16,24 @@ namespace Common {
 Options::Options() {
 	addCommand(kCmdDecompile, "decompile", "Unprotect a movie, cast, or directory thereof, and decompile its scripts.");
 	addStringOption(false, kCmdDecompile, "output", "Output path. Default is chosen based on the input path.", "path", 'o');
-	addOption(false, kCmdAll, "dump-scripts", "Dump scripts.");
+	std::vector<EnumOptionInfo> soundModes = {
+		{ "decode",				kSoundModeDecode,			"Decode to uncompressed sound data, which Director can play" },
+		{ "keep-unplayable",	kSoundModeKeepUnplayable,	"Copy the MP3 data through as is. Lossy: the output stays small, but Director can't play these sounds" },
+		{ "extract-silent",		kSoundModeExtractSilent,	"Write the MP3 data to files in a \"_sounds\" directory next to the output, named after their cast members. Lossy: the sounds in the movie are left empty and don't link to the extracted files" }
+	};
+	addEnumOption(false, kCmdDecompile, "sound", "How to handle MP3-compressed sounds in Shockwave files. Options are:", "mode", soundModes, '\0', "decode");
+	addOption(false, kCmdDecompile, "patch", "Patch movies and casts that aren't Shockwave files instead of rewriting them, leaving the chunks that didn't change where they are. Use with --output set to the input path to modify the input in place, writing only what changed.");
+	addStringOption(false, kCmdDecompile, "manifest", "When processing a directory or list of files, record what was done in this file and skip inputs that haven't changed since the last run with the same options.", "path");
+	addStringOption(false, kCmdDecompile, "script-cache", "Directory in which to cache decompiled scripts, so that scripts shared between movies are only decompiled once, even across runs.", "dir");
+	addOption(false, kCmdDecompile | kCmdVersion, "dump-scripts", "Dump scripts.");
+	addOption(false, kCmdDecompile | kCmdVersion, "recursive", "Include subdirectories when the input is a directory.", 'r');
+	addStringOption(false, kCmdDecompile | kCmdVersion, "files-from", "Read input paths from a file, one per line, instead of taking an input path. Use - to read from standard input.", "list");
+	std::vector<EnumOptionInfo> profileFormats = {
+		{ "table",	kProfileFormatTable,	"Human-readable table" },
+		{ "json",	kProfileFormatJSON,		"One JSON object per file, each on its own line" }
+	};
+	addEnumOption(false, kCmdDecompile | kCmdVersion, "profile", "Print the time spent in each phase and counts of the work done, for each file and in total when processing multiple files. Formats are:", "format", profileFormats, '\0', "table", true);
+	addStringOption(false, kCmdAll, "jobs", "Number of threads to use. Several inputs are processed in parallel, and a single input has its chunks decompressed and its scripts parsed in parallel. 0 means one per CPU core.", "n", 'j', "1");
 
 	addCommand(kCmdVersion, "version", "Print the Director version with which the file was created.");
 	std::vector<EnumOptionInfo> versionStyles = {
@@ -27,6 +44,9 @@ Options::Options() {
 	};
 	addEnumOption(false, kCmdVersion, "style", "Style in which to print the version. Options are:", "name", versionStyles, '\0', "long");
 
+	addCommand(kCmdServe, "serve", "Keep running and process requests read as JSON Lines from standard input or a socket, writing a JSON response line for each. Takes no input path.");
+	addStringOption(false, kCmdServe, "socket", "Listen on a Unix domain socket at this path instead of reading standard input.", "path");
+
 	addOption(true, kCmdAll, "verbose", "Verbose logging", 'v');
 	addOption(true, kCmdAll, "dump-chunks", "Dump chunk data.");
 	addOption(true, kCmdAll, "dump-json", "Dump JSONified chunk data.");
@@ -82,7 +102,7 @@ void Options::addStringOption(bool debug, unsigned int cmd, const char *longName
 	_optionInfo.push_back(opt);
 }
 
-void Options::addEnumOption(bool debug, unsigned int cmd, const char *longName, const char *desc, const char *argName, std::vector<EnumOptionInfo> enumInfo, char shortName, const char *def) {
+void Options::addEnumOption(bool debug, unsigned int cmd, const char *longName, const char *desc, const char *argName, std::vector<EnumOptionInfo> enumInfo, char shortName, const char *def, bool argOptional) {
 	OptionInfo opt;
 	opt.debug = debug;
 	opt.cmd = cmd;
@@ -92,6 +112,7 @@ void Options::addEnumOption(bool debug, unsigned int cmd, const char *longName,
 	opt.enumInfo = enumInfo;
 	opt.shortName = shortName;
 	opt.def = def;
+	opt.argOptional = argOptional;
 	_optionInfo.push_back(opt);
 }
 
@@ -112,6 +133,15 @@ const Options::OptionInfo *Options::getOptionInfo(char shortName) {
 	return nullptr;
 }
 
+void Options::parse(const std::vector<std::string> &args) {
+	std::vector<char *> argv;
+	for (const std::string &arg : args) {
+		argv.push_back(const_cast<char *>(arg.c_str()));
+	}
+	argv.push_back(nullptr);
+	parse(args.size(), argv.data());
+}
+
 void Options::parse(int argc, char *argv[]) {
 	_valid = false;
 
@@ -201,7 +231,20 @@ void Options::parse(int argc, char *argv[]) {
 				}
 			} 
 			if (info->argName) {
-				if (!optionArgFound) {
+				if (!optionArgFound && info->argOptional) {
+					// Only take the next argument if it's one of the values,
+					// so that it can still be the input path.
+					optionArg = info->def;
+					if (i < argc - 1) {
+						for (const EnumOptionInfo &enumInfo : info->enumInfo) {
+							if (argv[i + 1] == std::string(enumInfo.name)) {
+								optionArg = argv[i + 1];
+								i++;
+								break;
+							}
+						}
+					}
+				} else if (!optionArgFound) {
 					if (i < argc - 1) {
 						optionArg = argv[i + 1];
 						i++;
@@ -247,7 +290,21 @@ void Options::parse(int argc, char *argv[]) {
 		}
 	}
 
-	if (!inputFileFound) {
+	if (_cmd == kCmdServe) {
+		if (inputFileFound) {
+			Common::warning("serve does not take an input path\n");
+			printUsage();
+			return;
+		}
+		_valid = true;
+		return;
+	}
+	if (inputFileFound && _stringOptions.count("files-from")) {
+		Common::warning("Input file cannot be used with --files-from\n");
+		printUsage();
+		return;
+	}
+	if (!inputFileFound && !_stringOptions.count("files-from")) {
 		Common::warning("Input file not specified\n");
 		printUsage();
 		return;
@@ -257,6 +314,12 @@ void Options::parse(int argc, char *argv[]) {
 };
 
 void Options::printUsage(FILE *fh) {
+	if (!_printUsage)
+		return;
+
+	// Let queued messages, such as the error that led here, come out first.
+	Common::flushLog();
+
 	fprintf(fh, "Usage: %s <command> <input path> [<option>...]\n\n", _programName.c_str());
 
 	if (_cmd == kCmdNone || _cmd == kCmdAll) {
@@ -309,7 +372,11 @@ void Options::printUsage(FILE *fh) {
 std::vector<std::pair<std::string, std::string>> Options::getOptionText(Command cmd, bool debug) {
 	std::vector<std::pair<std::string, std::string>> res;
 	if (cmd != kCmdNone && cmd != kCmdAll) {
-		res.push_back(std::make_pair(getCommandName(cmd) + " <input path>", getCommandDesc(cmd)));
+		std::string usage = getCommandName(cmd);
+		if (cmd != kCmdServe) {
+			usage += " <input path>";
+		}
+		res.push_back(std::make_pair(usage, getCommandDesc(cmd)));
 	} else if (debug) {
 		res.push_back(std::make_pair("Debug options:", ""));
 	}
@@ -325,7 +392,11 @@ std::vector<std::pair<std::string, std::string>> Options::getOptionText(Command
 		}
 		left += "--";
 		left += info.longName;
-		if (info.argName) {
+		if (info.argName && info.argOptional) {
+			left += " [<";
+			left += info.argName;
+			left += ">]";
+		} else if (info.argName) {
 			left += " <";
 			left += info.argName;
 			left += ">";
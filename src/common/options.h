@@ -20,7 +20,8 @@ enum Command {
 	kCmdNone		= 0,
 	kCmdDecompile	= (1 << 0),
 	kCmdVersion		= (1 << 1),
-	kCmdAll			= (1 << 2) - 1
+	kCmdServe		= (1 << 2),
+	kCmdAll			= (1 << 3) - 1
 };
 
 enum VersionStyle {
@@ -30,6 +31,17 @@ enum VersionStyle {
 	kVersionStyleInternal
 };
 
+enum SoundMode {
+	kSoundModeDecode,
+	kSoundModeKeepUnplayable,
+	kSoundModeExtractSilent
+};
+
+enum ProfileFormat {
+	kProfileFormatTable,
+	kProfileFormatJSON
+};
+
 class Options {
 private:
 	struct CommandInfo {
@@ -53,12 +65,15 @@ private:
 		char shortName = '\0';
 		const char *argName = nullptr;
 		const char *def = nullptr;
+		// The argument can be left out, in which case def is used.
+		bool argOptional = false;
 	};
 
 	std::vector<CommandInfo> _commandInfo;
 	std::vector<OptionInfo> _optionInfo;
 
 	bool _valid = false;
+	bool _printUsage = true;
 
 	std::string _programName;
 	Command _cmd = kCmdNone;
@@ -75,7 +90,7 @@ private:
 
 	void addOption(bool debug, unsigned int cmd, const char *longName, const char *desc, char shortName = '\0');
 	void addStringOption(bool debug, unsigned int cmd, const char *longName, const char *desc, const char *argName, char shortName = '\0', const char *def = nullptr);
-	void addEnumOption(bool debug, unsigned int cmd, const char *longName, const char *desc, const char *argName, std::vector<EnumOptionInfo> enumInfo, char shortName = '\0', const char *def = nullptr);
+	void addEnumOption(bool debug, unsigned int cmd, const char *longName, const char *desc, const char *argName, std::vector<EnumOptionInfo> enumInfo, char shortName = '\0', const char *def = nullptr, bool argOptional = false);
 	const OptionInfo *getOptionInfo(std::string longName);
 	const OptionInfo *getOptionInfo(char shortName);
 
@@ -86,6 +101,9 @@ public:
 	Options();
 
 	void parse(int argc, char *argv[]);
+	void parse(const std::vector<std::string> &args);
+	// Whether parse prints usage information when the arguments are invalid.
+	void setPrintUsage(bool printUsage) { _printUsage = printUsage; }
 
 	bool valid() const { return _valid; }
 	Command cmd() const { return _cmd; }
@@ -0,0 +1,120 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include <boost/format.hpp>
+
+#include "common/json.h"
+#include "common/profile.h"
+
+namespace Common {
+
+static const char *kPhaseNames[kPhaseCount] = {
+	"total",
+	"readMaps",
+	"readCasts",
+	"decompress",
+	"deserialize",
+	"parseScripts",
+	"restoreScriptText",
+	"write"
+};
+
+static const char *kCounterNames[kCounterCount] = {
+	"bytesDecompressed",
+	"chunksDeserialized",
+	"handlersParsed",
+	"astNodes",
+	"scriptCacheHits",
+	"scriptCacheMisses"
+};
+
+/* Profile */
+
+Profile::Profile() : _files(0) {
+	for (int i = 0; i < kPhaseCount; i++) {
+		_nanoseconds[i] = 0;
+		_calls[i] = 0;
+	}
+	for (int i = 0; i < kCounterCount; i++) {
+		_counters[i] = 0;
+	}
+}
+
+void Profile::addTime(ProfilePhase phase, uint64_t nanoseconds) {
+	_nanoseconds[phase].fetch_add(nanoseconds, std::memory_order_relaxed);
+	_calls[phase].fetch_add(1, std::memory_order_relaxed);
+	if (phase == kPhaseTotal) {
+		_files.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void Profile::count(ProfileCounter counter, uint64_t n) {
+	_counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+void Profile::merge(const Profile &other) {
+	for (int i = 0; i < kPhaseCount; i++) {
+		_nanoseconds[i] += other._nanoseconds[i];
+		_calls[i] += other._calls[i];
+	}
+	for (int i = 0; i < kCounterCount; i++) {
+		_counters[i] += other._counters[i];
+	}
+	_files += other._files;
+}
+
+std::string Profile::table(const std::string &title) const {
+	std::string res = title;
+	if (_files > 1) {
+		res += boost::str(boost::format(" (%u files)") % _files.load());
+	}
+	res += "\n";
+	res += boost::str(boost::format("  %-20s %12s %10s\n") % "phase" % "ms" % "calls");
+	for (int i = 0; i < kPhaseCount; i++) {
+		res += boost::str(boost::format("  %-20s %12.3f %10u\n")
+			% kPhaseNames[i] % (_nanoseconds[i] / 1e6) % _calls[i].load());
+	}
+	res += boost::str(boost::format("  %-20s %12s") % "counter" % "value");
+	for (int i = 0; i < kCounterCount; i++) {
+		res += boost::str(boost::format("\n  %-20s %12u") % kCounterNames[i] % _counters[i].load());
+	}
+	return res;
+}
+
+void Profile::writeJSON(JSONWriter &json) const {
+	json.startObject();
+		json.writeKey("files");
+		json.writeVal(_files.load());
+		json.writeKey("phases");
+		json.startObject();
+			for (int i = 0; i < kPhaseCount; i++) {
+				json.writeKey(kPhaseNames[i]);
+				json.startObject();
+					json.writeKey("us");
+					json.writeVal(_nanoseconds[i] / 1000);
+					json.writeKey("calls");
+					json.writeVal(_calls[i].load());
+				json.endObject();
+			}
+		json.endObject();
+		json.writeKey("counters");
+		json.startObject();
+			for (int i = 0; i < kCounterCount; i++) {
+				json.writeKey(kCounterNames[i]);
+				json.writeVal(_counters[i].load());
+			}
+		json.endObject();
+	json.endObject();
+}
+
+/* ScopedTimer */
+
+int &ScopedTimer::depth(ProfilePhase phase) {
+	static thread_local int depths[kPhaseCount] = {};
+	return depths[phase];
+}
+
+} // namespace Common
@@ -0,0 +1,114 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COMMON_PROFILE_H
+#define COMMON_PROFILE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace Common {
+
+class JSONWriter;
+
+enum ProfilePhase {
+	kPhaseTotal,
+	kPhaseReadMaps,
+	kPhaseReadCasts,
+	kPhaseDecompress,
+	kPhaseDeserialize,
+	kPhaseParseScripts,
+	kPhaseRestoreScriptText,
+	kPhaseWrite,
+	kPhaseCount
+};
+
+enum ProfileCounter {
+	kCounterBytesDecompressed,
+	kCounterChunksDeserialized,
+	kCounterHandlersParsed,
+	kCounterASTNodes,
+	kCounterScriptCacheHits,
+	kCounterScriptCacheMisses,
+	kCounterCount
+};
+
+/* Profile */
+
+// Accumulated phase timings and counters for one file, or for a whole batch.
+// Phases nest (decompression happens while deserializing, for instance), so
+// each phase's time includes the phases run inside it. Time spent in
+// parallel stages is summed over all threads. Safe to update from several
+// threads at once.
+class Profile {
+private:
+	std::atomic<uint64_t> _nanoseconds[kPhaseCount];
+	std::atomic<uint64_t> _calls[kPhaseCount];
+	std::atomic<uint64_t> _counters[kCounterCount];
+	std::atomic<uint64_t> _files;
+
+public:
+	Profile();
+
+	void addTime(ProfilePhase phase, uint64_t nanoseconds);
+	void count(ProfileCounter counter, uint64_t n = 1);
+	void merge(const Profile &other);
+
+	uint64_t nanoseconds(ProfilePhase phase) const { return _nanoseconds[phase].load(std::memory_order_relaxed); }
+	uint64_t counter(ProfileCounter counter) const { return _counters[counter].load(std::memory_order_relaxed); }
+
+	std::string table(const std::string &title) const;
+	void writeJSON(JSONWriter &json) const;
+};
+
+// Profiling is off when the profile is null, which costs a single branch.
+inline void count(Profile *profile, ProfileCounter counter, uint64_t n = 1) {
+	if (profile) {
+		profile->count(counter, n);
+	}
+}
+
+/* ScopedTimer */
+
+// Times a phase for as long as it's in scope. A phase can be re-entered,
+// as when deserializing one chunk reads another, in which case only the
+// outermost timer on each thread counts, so no time is counted twice.
+class ScopedTimer {
+private:
+	Profile *_profile;
+	ProfilePhase _phase;
+	bool _outermost;
+	std::chrono::steady_clock::time_point _start;
+
+	static int &depth(ProfilePhase phase);
+
+public:
+	ScopedTimer(Profile *profile, ProfilePhase phase) : _profile(profile), _phase(phase), _outermost(false) {
+		if (_profile) {
+			_outermost = (depth(_phase)++ == 0);
+			if (_outermost) {
+				_start = std::chrono::steady_clock::now();
+			}
+		}
+	}
+	~ScopedTimer() {
+		if (_profile) {
+			depth(_phase)--;
+			if (_outermost) {
+				auto elapsed = std::chrono::steady_clock::now() - _start;
+				_profile->addTime(_phase, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+			}
+		}
+	}
+	ScopedTimer(const ScopedTimer &) = delete;
+	ScopedTimer &operator=(const ScopedTimer &) = delete;
+};
+
+} // namespace Common
+
+#endif // COMMON_PROFILE_H
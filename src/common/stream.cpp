@@ -65,9 +65,13 @@ bool Stream::pastEOF() const {
 /* ReadStream */
 
 BufferView ReadStream::readByteView(size_t len) {
-	BufferView res(_data + _pos, len);
+	size_t p = _pos;
 	_pos += len;
-	return res;
+	if (pastEOF()) {
+		throw std::runtime_error("ReadStream::readByteView: Read past end of stream!");
+	}
+
+	return BufferView(_data + p, len);
 }
 
 ssize_t ReadStream::readUpToBytes(size_t len, uint8_t *dest) {
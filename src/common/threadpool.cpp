@@ -0,0 +1,162 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+
+#include "common/threadpool.h"
+
+namespace Common {
+
+/* ThreadPool */
+
+ThreadPool::ThreadPool(unsigned int threadCount, size_t maxQueued)
+	: _maxQueued(maxQueued), _activeTasks(0), _stopping(false) {
+	if (threadCount < 1)
+		threadCount = 1;
+
+	_threads.reserve(threadCount);
+	for (unsigned int i = 0; i < threadCount; i++) {
+		_threads.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_taskAvailable.notify_all();
+	for (auto &thread : _threads) {
+		thread.join();
+	}
+}
+
+unsigned int ThreadPool::size() const {
+	return _threads.size();
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+	push(std::move(task), true);
+}
+
+void ThreadPool::push(std::function<void()> task, bool bounded) {
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (bounded && _maxQueued > 0) {
+			_spaceAvailable.wait(lock, [this] { return _queue.size() < _maxQueued; });
+		}
+		_queue.push_back(std::move(task));
+	}
+	_taskAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	_allDone.wait(lock, [this] { return _queue.empty() && _activeTasks == 0; });
+}
+
+namespace {
+
+struct ParallelForState {
+	std::mutex mutex;
+	std::condition_variable finished;
+	const std::function<void(size_t)> *fn;
+	size_t count;
+	size_t next = 0;
+	size_t running = 0;
+	std::exception_ptr error;
+	size_t errorIndex = 0;
+
+	// Runs loop iterations until there are none left.
+	// Returns false if the loop was already done and fn wasn't touched.
+	bool work() {
+		std::unique_lock<std::mutex> lock(mutex);
+		if (next >= count)
+			return false;
+
+		running++;
+		while (next < count && !error) {
+			size_t i = next++;
+			lock.unlock();
+			try {
+				(*fn)(i);
+			} catch (...) {
+				lock.lock();
+				// Report the same error a serial loop would have hit first.
+				if (!error || i < errorIndex) {
+					error = std::current_exception();
+					errorIndex = i;
+				}
+				continue;
+			}
+			lock.lock();
+		}
+		running--;
+		if (running == 0) {
+			finished.notify_all();
+		}
+		return true;
+	}
+};
+
+} // namespace
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &fn) {
+	if (count == 0)
+		return;
+
+	auto state = std::make_shared<ParallelForState>();
+	state->fn = &fn;
+	state->count = count;
+
+	// Helpers that only get scheduled after the loop is finished return
+	// without calling fn, so we never have to wait for them. They bypass the
+	// queue bound since the caller may itself be a task.
+	size_t helperCount = std::min<size_t>(_threads.size(), count - 1);
+	for (size_t i = 0; i < helperCount; i++) {
+		push([state]() { state->work(); }, false);
+	}
+
+	state->work();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state] { return state->running == 0; });
+	if (state->error) {
+		std::rethrow_exception(state->error);
+	}
+}
+
+void ThreadPool::workerLoop() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_taskAvailable.wait(lock, [this] { return _stopping || !_queue.empty(); });
+		if (_queue.empty()) // stopping and nothing left to do
+			return;
+
+		std::function<void()> task = std::move(_queue.front());
+		_queue.pop_front();
+		_activeTasks++;
+		_spaceAvailable.notify_one();
+
+		lock.unlock();
+		task();
+		lock.lock();
+
+		_activeTasks--;
+		if (_queue.empty() && _activeTasks == 0) {
+			_allDone.notify_all();
+		}
+	}
+}
+
+unsigned int ThreadPool::hardwareThreads() {
+	unsigned int count = std::thread::hardware_concurrency();
+	return (count > 0) ? count : 1;
+}
+
+} // namespace Common
@@ -0,0 +1,61 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef COMMON_THREADPOOL_H
+#define COMMON_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Common {
+
+/* ThreadPool */
+
+// Fixed-size pool of worker threads consuming a FIFO task queue.
+// Tasks are expected to handle their own exceptions. If maxQueued is
+// nonzero, enqueue() blocks while that many tasks are already waiting, which
+// lets a producer stay only slightly ahead of the workers.
+//
+// parallelFor() splits a loop across the pool. The calling thread works
+// through the loop as well, so it is safe to call from inside a task even
+// when every worker is busy.
+class ThreadPool {
+private:
+	std::vector<std::thread> _threads;
+	std::deque<std::function<void()>> _queue;
+	std::mutex _mutex;
+	std::condition_variable _taskAvailable;
+	std::condition_variable _spaceAvailable;
+	std::condition_variable _allDone;
+	size_t _maxQueued;
+	size_t _activeTasks;
+	bool _stopping;
+
+	void workerLoop();
+	void push(std::function<void()> task, bool bounded);
+
+public:
+	explicit ThreadPool(unsigned int threadCount, size_t maxQueued = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	unsigned int size() const;
+	void enqueue(std::function<void()> task);
+	void wait();
+	void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+	static unsigned int hardwareThreads();
+};
+
+} // namespace Common
+
+#endif // COMMON_THREADPOOL_H
@@ -65,10 +65,25 @@ std::string byteToString(uint8_t byte) {
 	return std::string(hex);
 }
 
-std::string escapeString(const char *str, size_t size) {
-	std::string res;
-	for (size_t i = 0; i < size; i++) {
-		unsigned char ch = str[i];
+static inline bool needsEscape(unsigned char ch) {
+	return ch < 0x20 || ch > 0x7f || ch == '"' || ch == '\\';
+}
+
+void appendEscapedString(std::string &res, const char *str, size_t size) {
+	static const char *hexDigits = "0123456789ABCDEF";
+
+	size_t i = 0;
+	while (i < size) {
+		// Copy runs of characters that don't need escaping in one go.
+		size_t runStart = i;
+		while (i < size && !needsEscape(str[i])) {
+			i++;
+		}
+		res.append(str + runStart, i - runStart);
+		if (i == size)
+			break;
+
+		unsigned char ch = str[i++];
 		switch (ch) {
 		case '"':
 			res += "\\\"";
@@ -95,19 +110,27 @@ std::string escapeString(const char *str, size_t size) {
 			res += "\\v";
 			break;
 		default:
-			if (ch < 0x20 || ch > 0x7f) {
-				res += "\\x" + byteToString(ch);
-			} else {
-				res += ch;
-			}
+			res += "\\x";
+			res += hexDigits[ch >> 4];
+			res += hexDigits[ch & 0xF];
 			break;
 		}
 	}
+}
+
+void appendEscapedString(std::string &res, std::string_view str) {
+	appendEscapedString(res, str.data(), str.size());
+}
+
+std::string escapeString(const char *str, size_t size) {
+	std::string res;
+	res.reserve(size);
+	appendEscapedString(res, str, size);
 	return res;
 }
 
-std::string escapeString(std::string str) {
-	return escapeString(str.c_str(), str.size());
+std::string escapeString(std::string_view str) {
+	return escapeString(str.data(), str.size());
 }
 
 int stricmp(const char *a, const char *b) {
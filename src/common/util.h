@@ -9,6 +9,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 #define FOURCC(a0,a1,a2,a3) ((uint32_t)((a3) | ((a2) << 8) | ((a1) << 16) | ((a0) << 24)))
 
@@ -21,8 +22,10 @@ std::string fourCCToString(uint32_t fourcc);
 std::string cleanFileName(const std::string &fileName);
 std::string floatToString(double f);
 std::string byteToString(uint8_t byte);
+void appendEscapedString(std::string &res, const char *str, size_t size);
+void appendEscapedString(std::string &res, std::string_view str);
 std::string escapeString(const char *str, size_t size);
-std::string escapeString(std::string str);
+std::string escapeString(std::string_view str);
 int stricmp(const char *a, const char *b);
 int compareIgnoreCase(const std::string &a, const std::string &b);
 
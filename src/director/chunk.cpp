@@ -8,12 +8,14 @@
 
 #include "common/json.h"
 #include "common/log.h"
+#include "common/profile.h"
 #include "common/stream.h"
 #include "common/util.h"
 #include "director/castmember.h"
 #include "director/chunk.h"
 #include "director/lingo.h"
 #include "director/dirfile.h"
+#include "director/scriptcache.h"
 #include "director/subchunk.h"
 #include "director/util.h"
 
@@ -50,24 +52,33 @@ void CastChunk::writeJSON(Common::JSONWriter &json) const {
 void CastChunk::populate(const std::string &castName, int32_t id, uint16_t minMember) {
 	name = castName;
 
-	for (const auto &entry : dir->keyTable->entries) {
-		if (entry.castID == id
-				&& (entry.fourCC == FOURCC('L', 'c', 't', 'x') || entry.fourCC == FOURCC('L', 'c', 't', 'X'))
-				&& dir->chunkExists(entry.fourCC, entry.sectionID)) {
-			lctx = std::static_pointer_cast<ScriptContextChunk>(dir->getChunk(entry.fourCC, entry.sectionID));
-			break;
+	// Use whichever script context comes first in the key table.
+	const KeyTableChunk &keyTable = *dir->keyTable;
+	const KeyTableEntry *lctxEntry = nullptr;
+	for (uint32_t fourCC : { FOURCC('L', 'c', 't', 'x'), FOURCC('L', 'c', 't', 'X') }) {
+		for (size_t i : keyTable.findEntries(id, fourCC)) {
+			const KeyTableEntry &entry = keyTable.entries[i];
+			if (dir->chunkExists(entry.fourCC, entry.sectionID)) {
+				if (!lctxEntry || &entry < lctxEntry) {
+					lctxEntry = &entry;
+				}
+				break;
+			}
 		}
 	}
+	if (lctxEntry) {
+		lctx = std::static_pointer_cast<ScriptContextChunk>(dir->getChunk(lctxEntry->fourCC, lctxEntry->sectionID));
+	}
 
 	for (size_t i = 0; i < memberIDs.size(); i++) {
 		int32_t sectionID = memberIDs[i];
 		if (sectionID > 0) {
 			auto member = std::static_pointer_cast<CastMemberChunk>(dir->getChunk(FOURCC('C', 'A', 'S', 't'), sectionID));
 			member->id = i + minMember;
-			Common::debug(boost::format("Member %u: name: \"%s\" chunk: %d")
+			LOG_DEBUG(boost::format("Member %u: name: \"%s\" chunk: %d")
 							% member->id % member->getName() % sectionID);
 			if (!member->info) {
-				Common::debug(boost::format("Member %u: No info!") % member->id);
+				LOG_DEBUG(boost::format("Member %u: No info!") % member->id);
 			}
 			if (lctx && (lctx->scripts.find(member->getScriptID()) != lctx->scripts.end())) {
 				member->script = lctx->scripts[member->getScriptID()].get();
@@ -252,7 +263,7 @@ void CastMemberChunk::setScriptText(std::string val) {
 		Common::warning("Tried to set scriptText on member with no info!");
 		return;
 	}
-	info->scriptSrcText = val;
+	info->scriptSrcText = std::move(val);
 }
 
 std::string CastMemberChunk::getName() const {
@@ -496,34 +507,34 @@ uint32_t ConfigChunk::computeChecksum() {
 	unsigned int ver = humanVersion(directorVersion);
 
 	uint32_t check = len + 1;
-	Common::debug(boost::format("Checksum step 1 (= %1% + 1): %2%") % len % check);
+	LOG_DEBUG(boost::format("Checksum step 1 (= %1% + 1): %2%") % len % check);
 
 	check *= fileVersion + 2;
-	Common::debug(boost::format("Checksum step 2 (*= %1% + 2): %2%") % fileVersion % check);
+	LOG_DEBUG(boost::format("Checksum step 2 (*= %1% + 2): %2%") % fileVersion % check);
 
 	check /= movieTop + 3;
-	Common::debug(boost::format("Checksum step 3 (/= %1% + 3): %2%") % movieTop % check);
+	LOG_DEBUG(boost::format("Checksum step 3 (/= %1% + 3): %2%") % movieTop % check);
 
 	check *= movieLeft + 4;
-	Common::debug(boost::format("Checksum step 4 (*= %1% + 4): %2%") % movieLeft % check);
+	LOG_DEBUG(boost::format("Checksum step 4 (*= %1% + 4): %2%") % movieLeft % check);
 
 	check /= movieBottom + 5;
-	Common::debug(boost::format("Checksum step 5 (/= %1% + 5): %2%") % movieBottom % check);
+	LOG_DEBUG(boost::format("Checksum step 5 (/= %1% + 5): %2%") % movieBottom % check);
 
 	check *= movieRight + 6;
-	Common::debug(boost::format("Checksum step 6 (*= %1% + 6): %2%") % movieRight % check);
+	LOG_DEBUG(boost::format("Checksum step 6 (*= %1% + 6): %2%") % movieRight % check);
 
 	check -= minMember + 7;
-	Common::debug(boost::format("Checksum step 7 (-= %1% + 7): %2%") % minMember % check);
+	LOG_DEBUG(boost::format("Checksum step 7 (-= %1% + 7): %2%") % minMember % check);
 
 	check *= maxMember + 8;
-	Common::debug(boost::format("Checksum step 8 (*= %1% + 8): %2%") % maxMember % check);
+	LOG_DEBUG(boost::format("Checksum step 8 (*= %1% + 8): %2%") % maxMember % check);
 
 	check -= field9 + 9;
-	Common::debug(boost::format("Checksum step 9 (-= %1% + 9): %2%") % (int)field9 % check);
+	LOG_DEBUG(boost::format("Checksum step 9 (-= %1% + 9): %2%") % (int)field9 % check);
 
 	check -= field10 + 10;
-	Common::debug(boost::format("Checksum step 10 (-= %1% + 10): %2%") % (int)field10 % check);
+	LOG_DEBUG(boost::format("Checksum step 10 (-= %1% + 10): %2%") % (int)field10 % check);
 
 	int32_t operand11;
 	if (ver < 700) {
@@ -534,63 +545,63 @@ uint32_t ConfigChunk::computeChecksum() {
 						: (int16_t)((D7stageColorG << 8) | D7stageColorB);
 	}
 	check += operand11 + 11;
-	Common::debug(boost::format("Checksum step 11 (+= %1% + 11): %2%") % operand11 % check);
+	LOG_DEBUG(boost::format("Checksum step 11 (+= %1% + 11): %2%") % operand11 % check);
 
 	check *= commentFont + 12;
-	Common::debug(boost::format("Checksum step 12 (*= %1% + 12): %2%") % commentFont % check);
+	LOG_DEBUG(boost::format("Checksum step 12 (*= %1% + 12): %2%") % commentFont % check);
 
 	check += commentSize + 13;
-	Common::debug(boost::format("Checksum step 13 (+= %1% + 13): %2%") % commentSize % check);
+	LOG_DEBUG(boost::format("Checksum step 13 (+= %1% + 13): %2%") % commentSize % check);
 
 	int32_t operand14 = (ver < 800) ? (uint8_t)((commentStyle >> 8) & 0xFF) : commentStyle;
 	check *= operand14 + 14;
-	Common::debug(boost::format("Checksum step 14 (*= %1% + 14): %2%") % operand14 % check);
+	LOG_DEBUG(boost::format("Checksum step 14 (*= %1% + 14): %2%") % operand14 % check);
 
 	int32_t operand15 = (ver < 700) ? preD7stageColor : D7stageColorR;
 	check += operand15 + 15;
-	Common::debug(boost::format("Checksum step 15 (+= %1% + 15): %2%") % operand15 % check);
+	LOG_DEBUG(boost::format("Checksum step 15 (+= %1% + 15): %2%") % operand15 % check);
 
 	check += bitDepth + 16;
-	Common::debug(boost::format("Checksum step 16 (+= %1% + 16): %2%") % bitDepth % check);
+	LOG_DEBUG(boost::format("Checksum step 16 (+= %1% + 16): %2%") % bitDepth % check);
 
 	check += field17 + 17;
-	Common::debug(boost::format("Checksum step 17 (+= %1% + 17): %2%") % (unsigned int)field17 % check);
+	LOG_DEBUG(boost::format("Checksum step 17 (+= %1% + 17): %2%") % (unsigned int)field17 % check);
 
 	check *= field18 + 18;
-	Common::debug(boost::format("Checksum step 18 (*= %1% + 18): %2%") % (unsigned int)field18 % check);
+	LOG_DEBUG(boost::format("Checksum step 18 (*= %1% + 18): %2%") % (unsigned int)field18 % check);
 
 	check += field19 + 19;
-	Common::debug(boost::format("Checksum step 19 (+= %1% + 19): %2%") % field19 % check);
+	LOG_DEBUG(boost::format("Checksum step 19 (+= %1% + 19): %2%") % field19 % check);
 
 	check *= directorVersion + 20;
-	Common::debug(boost::format("Checksum step 20 (*= %1% + 20): %2%") % directorVersion % check);
+	LOG_DEBUG(boost::format("Checksum step 20 (*= %1% + 20): %2%") % directorVersion % check);
 
 	check += field21 + 21;
-	Common::debug(boost::format("Checksum step 21 (+= %1% + 21): %2%") % field21 % check);
+	LOG_DEBUG(boost::format("Checksum step 21 (+= %1% + 21): %2%") % field21 % check);
 
 	check += field22 + 22;
-	Common::debug(boost::format("Checksum step 22 (+= %1% + 22): %2%") % field22 % check);
+	LOG_DEBUG(boost::format("Checksum step 22 (+= %1% + 22): %2%") % field22 % check);
 
 	check += field23 + 23;
-	Common::debug(boost::format("Checksum step 23 (+= %1% + 23): %2%") % field23 % check);
+	LOG_DEBUG(boost::format("Checksum step 23 (+= %1% + 23): %2%") % field23 % check);
 
 	check += field24 + 24;
-	Common::debug(boost::format("Checksum step 24 (+= %1% + 24): %2%") % field24 % check);
+	LOG_DEBUG(boost::format("Checksum step 24 (+= %1% + 24): %2%") % field24 % check);
 
 	check *= field25 + 25;
-	Common::debug(boost::format("Checksum step 25 (*= %1% + 25): %2%") % (int)field25 % check);
+	LOG_DEBUG(boost::format("Checksum step 25 (*= %1% + 25): %2%") % (int)field25 % check);
 
 	check += frameRate + 26;
-	Common::debug(boost::format("Checksum step 26 (+= %1% + 26): %2%") % frameRate % check);
+	LOG_DEBUG(boost::format("Checksum step 26 (+= %1% + 26): %2%") % frameRate % check);
 
 	check *= platform + 27;
-	Common::debug(boost::format("Checksum step 27 (*= %1% + 27): %2%") % platform % check);
+	LOG_DEBUG(boost::format("Checksum step 27 (*= %1% + 27): %2%") % platform % check);
 
 	check *= (protection * 0xE06) + 0xFF450000;
-	Common::debug(boost::format("Checksum step 28 (*= (%1% * 0xE06) + 0xFF450000): %2%") % protection % check);
+	LOG_DEBUG(boost::format("Checksum step 28 (*= (%1% * 0xE06) + 0xFF450000): %2%") % protection % check);
 
 	check ^= FOURCC('r', 'a', 'l', 'f');
-	Common::debug(boost::format("Checksum step 29 (^= ralf): %1%") % check);
+	LOG_DEBUG(boost::format("Checksum step 29 (^= ralf): %1%") % check);
 
 	return check;
 }
@@ -694,11 +705,23 @@ void KeyTableChunk::read(Common::ReadStream &stream) {
 	usedCount = stream.readUint32();
 
 	entries.resize(entryCount);
-	for (auto &entry : entries) {
-		entry.read(stream);
+	for (size_t i = 0; i < entries.size(); i++) {
+		entries[i].read(stream);
+		index[{ entries[i].castID, entries[i].fourCC }].push_back(i);
 	}
 }
 
+const std::vector<size_t> &KeyTableChunk::findEntries(int32_t castID, uint32_t fourCC) const {
+	static const std::vector<size_t> none;
+	auto it = index.find({ castID, fourCC });
+	return (it != index.end()) ? it->second : none;
+}
+
+int32_t KeyTableChunk::findSectionID(int32_t castID, uint32_t fourCC) const {
+	const std::vector<size_t> &found = findEntries(castID, fourCC);
+	return found.empty() ? -1 : entries[found[0]].sectionID;
+}
+
 void KeyTableChunk::writeJSON(Common::JSONWriter &json) const {
 	json.startObject();
 		JSON_WRITE_FIELD(entrySize);
@@ -918,7 +941,11 @@ void MemoryMapChunk::writeJSON(Common::JSONWriter &json) const {
 ScriptChunk::ScriptChunk(DirectorFile *m) :
 	Chunk(m, kScriptChunk),
 	context(nullptr),
-	member(nullptr) {}
+	member(nullptr),
+	countNameID(-1),
+	getAtNameID(-1),
+	recordNames(false),
+	parsed(false) {}
 
 ScriptChunk::~ScriptChunk() = default;
 
@@ -926,6 +953,11 @@ void ScriptChunk::read(Common::ReadStream &stream) {
 	// Lingo scripts are always big endian regardless of file endianness
 	stream.endianness = Common::kBigEndian;
 
+	if (dir->scriptCache) {
+		contentHash = Common::hash128(stream);
+		recordNames = true;
+	}
+
 	stream.seek(8);
 	/*  8 */ totalLength = stream.readUint32();
 	/* 12 */ totalLength2 = stream.readUint32();
@@ -1044,21 +1076,36 @@ void ScriptChunk::writeJSON(Common::JSONWriter &json) const {
 }
 
 bool ScriptChunk::validName(int id) const {
+	if (recordNames) {
+		referencedNameIDs.insert(id);
+	}
 	return context->validName(id);
 }
 
-std::string ScriptChunk::getName(int id) const {
+std::string_view ScriptChunk::getName(int id) const {
+	if (recordNames) {
+		referencedNameIDs.insert(id);
+	}
 	return context->getName(id);
 }
 
+int ScriptChunk::internedNameID(int id) const {
+	if (recordNames) {
+		referencedNameIDs.insert(id);
+	}
+	return context->internedNameID(id);
+}
+
 void ScriptChunk::setContext(ScriptContextChunk *ctx) {
 	this->context = ctx;
+	countNameID = ctx->findName("count");
+	getAtNameID = ctx->findName("getAt");
 	if (factoryNameID != -1) {
 		factoryName = getName(factoryNameID);
 	}
 	for (auto nameID : propertyNameIDs) {
 		if (validName(nameID)) {
-			std::string name = getName(nameID);
+			std::string_view name = getName(nameID);
 			if (isFactory() && name == "me")
 				continue;
 			propertyNames.push_back(name);
@@ -1075,9 +1122,71 @@ void ScriptChunk::setContext(ScriptContextChunk *ctx) {
 }
 
 void ScriptChunk::parse() {
+	if (parsed)
+		return;
+
 	for (const auto &handler : handlers) {
 		handler->parse();
 	}
+	parsed = true;
+}
+
+bool ScriptChunk::cacheable() const {
+	// A factory's text is written out as part of its parent's, so neither
+	// can be decompiled on its own.
+	return context && !isFactory() && factories.empty();
+}
+
+Common::Hash128 ScriptChunk::cacheKey(const char *lineEnding) const {
+	// The build is part of the key so that a cache directory kept across
+	// upgrades never serves text from an older decompiler.
+	std::string key = boost::str(boost::format("%s %s %u %d %d %s")
+		% ("ProjectorRays " STR(VERSION_NUMBER) "-" STR(GIT_SHA))
+		% contentHash.toString() % dir->version % dir->capitalX % dir->dotSyntax
+		% Common::escapeString(lineEnding));
+	return Common::hash128(key.data(), key.size());
+}
+
+void ScriptChunk::prepareText(const char *lineEnding) {
+	ScriptCache *cache = dir->scriptCache;
+	if (!cache || !cacheable()) {
+		parse();
+		return;
+	}
+
+	Common::Hash128 key = cacheKey(lineEnding);
+	for (auto &variant : cache->load(key)) {
+		bool matches = true;
+		for (const auto &name : variant.names) {
+			if (context->validName(name.id) != name.valid
+					|| (name.valid && context->getName(name.id) != name.name)) {
+				matches = false;
+				break;
+			}
+		}
+		if (matches) {
+			Common::count(dir->profile, Common::kCounterScriptCacheHits);
+			textLineEnding = lineEnding;
+			renderedScriptText = std::move(variant.scriptText);
+			renderedBytecodeText = std::move(variant.bytecodeText);
+			return;
+		}
+	}
+
+	Common::count(dir->profile, Common::kCounterScriptCacheMisses);
+	parse();
+	CachedScript entry;
+	entry.scriptText = scriptText(lineEnding);
+	entry.bytecodeText = bytecodeText(lineEnding);
+	for (int id : referencedNameIDs) {
+		bool valid = context->validName(id);
+		entry.names.push_back({ id, valid, valid ? std::string(context->getName(id)) : std::string() });
+	}
+	cache->store(key, entry);
+
+	textLineEnding = lineEnding;
+	renderedScriptText = std::move(entry.scriptText);
+	renderedBytecodeText = std::move(entry.bytecodeText);
 }
 
 void ScriptChunk::writeVarDeclarations(Common::CodeWriter &code) const {
@@ -1128,8 +1237,20 @@ void ScriptChunk::writeScriptText(Common::CodeWriter &code) const {
 }
 
 std::string ScriptChunk::scriptText(const char *lineEnding) const {
+	if (textLineEnding == lineEnding)
+		return renderedScriptText;
+
 	Common::CodeWriter code(lineEnding);
 	writeScriptText(code);
+	return code.take();
+}
+
+std::string_view ScriptChunk::scriptText(Common::CodeWriter &code) const {
+	if (textLineEnding == code.lineEnding())
+		return renderedScriptText;
+
+	code.clear();
+	writeScriptText(code);
 	return code.str();
 }
 
@@ -1158,8 +1279,20 @@ void ScriptChunk::writeBytecodeText(Common::CodeWriter &code) const {
 }
 
 std::string ScriptChunk::bytecodeText(const char *lineEnding) const {
+	if (textLineEnding == lineEnding)
+		return renderedBytecodeText;
+
 	Common::CodeWriter code(lineEnding);
 	writeBytecodeText(code);
+	return code.take();
+}
+
+std::string_view ScriptChunk::bytecodeText(Common::CodeWriter &code) const {
+	if (textLineEnding == code.lineEnding())
+		return renderedBytecodeText;
+
+	code.clear();
+	writeBytecodeText(code);
 	return code.str();
 }
 
@@ -1240,10 +1373,18 @@ bool ScriptContextChunk::validName(int id) const {
 	return lnam->validName(id);
 }
 
-std::string ScriptContextChunk::getName(int id) const {
+std::string_view ScriptContextChunk::getName(int id) const {
 	return lnam->getName(id);
 }
 
+int ScriptContextChunk::internedNameID(int id) const {
+	return lnam->internedID(id);
+}
+
+int ScriptContextChunk::findName(std::string_view name) const {
+	return lnam->findName(name);
+}
+
 void ScriptContextChunk::parseScripts() {
 	for (auto it = scripts.begin(); it != scripts.end(); ++it) {
 		it->second->parse();
@@ -1264,10 +1405,32 @@ void ScriptNamesChunk::read(Common::ReadStream &stream) {
 	namesCount = stream.readUint16();
 
 	stream.seek(namesOffset);
-	names.resize(namesCount);
-	for (auto &name : names) {
+	std::vector<Common::BufferView> views(namesCount);
+	size_t poolSize = 0;
+	for (auto &view : views) {
 		auto length = stream.readUint8();
-		name = stream.readString(length);
+		view = stream.readByteView(length);
+		poolSize += length;
+	}
+
+	// The pool is never resized after this, so views into it stay valid.
+	namePool.reserve(poolSize);
+	names.resize(namesCount);
+	internedIDs.resize(namesCount);
+	nameIndex.reserve(namesCount);
+	for (size_t i = 0; i < views.size(); i++) {
+		std::string_view name((const char *)views[i].data(), views[i].size());
+		auto it = nameIndex.find(name);
+		if (it != nameIndex.end()) {
+			names[i] = names[it->second];
+			internedIDs[i] = it->second;
+			continue;
+		}
+		size_t offset = namePool.size();
+		namePool.append(name);
+		names[i] = std::string_view(namePool.data() + offset, name.size());
+		internedIDs[i] = i;
+		nameIndex.emplace(names[i], i);
 	}
 }
 
@@ -1292,10 +1455,29 @@ bool ScriptNamesChunk::validName(int id) const {
 	return -1 < id && (unsigned)id < names.size();
 }
 
-std::string ScriptNamesChunk::getName(int id) const {
+std::string_view ScriptNamesChunk::getName(int id) const {
 	if (validName(id))
 		return names[id];
-	return "UNKNOWN_NAME_" + std::to_string(id);
+
+	std::lock_guard<std::mutex> lock(unknownNamesMutex);
+	auto it = unknownNames.find(id);
+	if (it == unknownNames.end()) {
+		it = unknownNames.emplace(id, "UNKNOWN_NAME_" + std::to_string(id)).first;
+	}
+	return it->second;
+}
+
+int ScriptNamesChunk::internedID(int id) const {
+	if (validName(id))
+		return internedIDs[id];
+	return -1;
+}
+
+int ScriptNamesChunk::findName(std::string_view name) const {
+	auto it = nameIndex.find(name);
+	if (it == nameIndex.end())
+		return -1;
+	return it->second;
 }
 
 } // namespace Director
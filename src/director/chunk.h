@@ -10,9 +10,14 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "common/hash.h"
 #include "common/stream.h"
 #include "director/castmember.h"
 #include "director/subchunk.h"
@@ -276,10 +281,16 @@ struct KeyTableChunk : Chunk {
 	uint32_t usedCount;
 	std::vector<KeyTableEntry> entries;
 
+	// Indices into entries, by owner ID and fourCC, in table order
+	std::map<std::pair<int32_t, uint32_t>, std::vector<size_t>> index;
+
 	KeyTableChunk(DirectorFile *m) : Chunk(m, kKeyTableChunk) {}
 	virtual ~KeyTableChunk() = default;
 	virtual void read(Common::ReadStream &stream);
 	virtual void writeJSON(Common::JSONWriter &json) const;
+
+	const std::vector<size_t> &findEntries(int32_t castID, uint32_t fourCC) const;
+	int32_t findSectionID(int32_t castID, uint32_t fourCC) const;
 };
 
 struct MemoryMapChunk : Chunk {
@@ -331,9 +342,9 @@ struct ScriptChunk : Chunk {
 	std::vector<int16_t> propertyNameIDs;
 	std::vector<int16_t> globalNameIDs;
 
-	std::string factoryName;
-	std::vector<std::string> propertyNames;
-	std::vector<std::string> globalNames;
+	std::string_view factoryName;
+	std::vector<std::string_view> propertyNames;
+	std::vector<std::string_view> globalNames;
 	std::vector<std::unique_ptr<Handler>> handlers;
 	std::vector<LiteralStore> literals;
 	std::vector<ScriptChunk *> factories;
@@ -341,19 +352,46 @@ struct ScriptChunk : Chunk {
 	ScriptContextChunk *context;
 	CastMemberChunk *member;
 
+	// Interned IDs of the names loop detection looks for, or -1 where the
+	// context has no such name.
+	int countNameID;
+	int getAtNameID;
+
+	// Used by the script cache. While a cache is in use, every name the
+	// script looks up is recorded so that a cached decompilation is only
+	// reused where those names are the same.
+	Common::Hash128 contentHash;
+	bool recordNames;
+	mutable std::set<int> referencedNameIDs;
+
+	bool parsed;
+	// Text rendered ahead of time with textLineEnding, possibly restored
+	// from the script cache without parsing the script at all.
+	std::string textLineEnding;
+	std::string renderedScriptText;
+	std::string renderedBytecodeText;
+
 	ScriptChunk(DirectorFile *m);
 	virtual ~ScriptChunk();
 	virtual void read(Common::ReadStream &stream);
 	std::vector<int16_t> readVarnamesTable(Common::ReadStream &stream, uint16_t count, uint32_t offset);
 	bool validName(int id) const;
-	std::string getName(int id) const;
+	std::string_view getName(int id) const;
+	int internedNameID(int id) const;
 	void setContext(ScriptContextChunk *ctx);
 	void parse();
+	bool cacheable() const;
+	Common::Hash128 cacheKey(const char *lineEnding) const;
+	void prepareText(const char *lineEnding);
 	void writeVarDeclarations(Common::CodeWriter &code) const;
 	void writeScriptText(Common::CodeWriter &code) const;
 	std::string scriptText(const char *lineEnding) const;
+	// Renders with code's line ending into code, which can then be reused
+	// for the next script. The text is only valid until code is cleared.
+	std::string_view scriptText(Common::CodeWriter &code) const;
 	void writeBytecodeText(Common::CodeWriter &code) const;
 	std::string bytecodeText(const char *lineEnding) const;
+	std::string_view bytecodeText(Common::CodeWriter &code) const;
 	virtual void writeJSON(Common::JSONWriter &json) const;
 
 	bool isFactory() const;
@@ -382,7 +420,9 @@ struct ScriptContextChunk : Chunk {
 	virtual ~ScriptContextChunk() = default;
 	virtual void read(Common::ReadStream &stream);
 	bool validName(int id) const;
-	std::string getName(int id) const;
+	std::string_view getName(int id) const;
+	int internedNameID(int id) const;
+	int findName(std::string_view name) const;
 	void parseScripts();
 	virtual void writeJSON(Common::JSONWriter &json) const;
 };
@@ -394,13 +434,26 @@ struct ScriptNamesChunk : Chunk {
 	uint32_t len2;
 	uint16_t namesOffset;
 	uint16_t namesCount;
-	std::vector<std::string> names;
+
+	// Each distinct name is stored once in namePool, and every ID maps to
+	// the first ID with the same name, so names compare equal exactly when
+	// their interned IDs do. The views stay valid as long as the chunk.
+	std::string namePool;
+	std::vector<std::string_view> names;
+	std::vector<int> internedIDs;
+	std::unordered_map<std::string_view, int> nameIndex;
+
+	// Placeholders for IDs outside the table, made on first use.
+	mutable std::mutex unknownNamesMutex;
+	mutable std::map<int, std::string> unknownNames;
 
 	ScriptNamesChunk(DirectorFile *m) : Chunk(m, kScriptNamesChunk) {}
 	virtual ~ScriptNamesChunk() = default;
 	virtual void read(Common::ReadStream &stream);
 	bool validName(int id) const;
-	std::string getName(int id) const;
+	std::string_view getName(int id) const;
+	int internedID(int id) const;
+	int findName(std::string_view name) const;
 	virtual void writeJSON(Common::JSONWriter &json) const;
 };
 
@@ -4,13 +4,19 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
+#include <cstring>
+#include <map>
 #include <sstream>
 #include <stdexcept>
 
+#include "common/codewriter.h"
 #include "common/fileio.h"
 #include "common/json.h"
 #include "common/log.h"
+#include "common/profile.h"
 #include "common/stream.h"
+#include "common/threadpool.h"
 #include "common/util.h"
 #include "director/chunk.h"
 #include "director/lingo.h"
@@ -31,6 +37,11 @@ static const size_t kChunkHeaderSize = 8;
 DirectorFile::DirectorFile() :
 	_ilsBodyOffset(0),
 	stream(nullptr),
+	sourceFile(nullptr),
+	threadPool(nullptr),
+	profile(nullptr),
+	scriptCache(nullptr),
+	soundMode(Common::kSoundModeDecode),
 	version(0),
 	capitalX(false),
 	codec(0),
@@ -40,6 +51,26 @@ DirectorFile::~DirectorFile() = default;
 
 // read stuff
 
+// Check whether the first kSniffSize bytes of a file look like a movie or
+// cast we know how to read.
+bool DirectorFile::sniff(const Common::BufferView &header) {
+	if (header.size() < kRIFXHeaderSize)
+		return false;
+
+	Common::ReadStream stream(header);
+	auto metaFourCC = stream.readUint32();
+	if (metaFourCC == FOURCC('X', 'F', 'I', 'R')) {
+		stream.endianness = Common::kLittleEndian;
+	} else if (metaFourCC != FOURCC('R', 'I', 'F', 'X')) {
+		return false;
+	}
+	stream.readUint32(); // meta length
+	auto codec = stream.readUint32();
+
+	return codec == FOURCC('M', 'V', '9', '3') || codec == FOURCC('M', 'C', '9', '5')
+		|| codec == FOURCC('F', 'G', 'D', 'M') || codec == FOURCC('F', 'G', 'D', 'C');
+}
+
 bool DirectorFile::read(Common::ReadStream *s) {
 	stream = s;
 	stream->endianness = Common::kBigEndian; // we set this properly when we create the RIFX chunk
@@ -54,17 +85,21 @@ bool DirectorFile::read(Common::ReadStream *s) {
 	codec = stream->readUint32();
 
 	// Codec-dependent map
-	if (codec == FOURCC('M', 'V', '9', '3') || codec == FOURCC('M', 'C', '9', '5')) {
-		readMemoryMap();
-	} else if (codec == FOURCC('F', 'G', 'D', 'M') || codec == FOURCC('F', 'G', 'D', 'C')) {
-		afterburned = true;
-		if (!readAfterburnerMap())
+	{
+		Common::ScopedTimer timer(profile, Common::kPhaseReadMaps);
+		if (codec == FOURCC('M', 'V', '9', '3') || codec == FOURCC('M', 'C', '9', '5')) {
+			readMemoryMap();
+		} else if (codec == FOURCC('F', 'G', 'D', 'M') || codec == FOURCC('F', 'G', 'D', 'C')) {
+			afterburned = true;
+			if (!readAfterburnerMap())
+				return false;
+		} else {
+			Common::warning("Codec unsupported: " + Common::fourCCToString(codec));
 			return false;
-	} else {
-		Common::warning("Codec unsupported: " + Common::fourCCToString(codec));
-		return false;
+		}
 	}
 
+	Common::ScopedTimer timer(profile, Common::kPhaseReadCasts);
 	if (!readKeyTable())
 		return false;
 	if (!readConfig())
@@ -78,20 +113,19 @@ bool DirectorFile::read(Common::ReadStream *s) {
 void DirectorFile::readMemoryMap() {
 	// Initial map
 	std::shared_ptr<InitialMapChunk> imap = std::static_pointer_cast<InitialMapChunk>(readChunk(FOURCC('i', 'm', 'a', 'p')));
-	deserializedChunks[1] = imap;
 
 	// Memory map
 	stream->seek(imap->mmapOffset);
 	std::shared_ptr<MemoryMapChunk> mmap = std::static_pointer_cast<MemoryMapChunk>(readChunk(FOURCC('m', 'm', 'a', 'p')));
-	deserializedChunks[2] = mmap;
 
+	std::vector<ChunkInfo> infos;
 	for (uint32_t i = 0; i < mmap->mapArray.size(); i++) {
 		auto mapEntry = mmap->mapArray[i];
 
 		if (mapEntry.fourCC == FOURCC('f', 'r', 'e', 'e') || mapEntry.fourCC == FOURCC('j', 'u', 'n', 'k'))
 			continue;
 
-		Common::debug(boost::format("Found RIFX resource index %d: '%s', %u bytes @ pos 0x%08x (%d)")
+		LOG_DEBUG(boost::format("Found RIFX resource index %d: '%s', %u bytes @ pos 0x%08x (%d)")
 						% i % Common::fourCCToString(mapEntry.fourCC) % mapEntry.len % mapEntry.offset % mapEntry.offset);
 
 		ChunkInfo info;
@@ -101,10 +135,12 @@ void DirectorFile::readMemoryMap() {
 		info.uncompressedLen = mapEntry.len;
 		info.offset = mapEntry.offset;
 		info.compressionID = NULL_COMPRESSION_GUID;
-		chunkInfo[i] = info;
-
-		chunkIDsByFourCC[mapEntry.fourCC].push_back(i);
+		infos.push_back(info);
 	}
+
+	initChunks(infos, std::max<size_t>(mmap->mapArray.size(), 3));
+	_chunks[1].chunk = imap;
+	_chunks[2].chunk = mmap;
 }
 
 bool DirectorFile::readAfterburnerMap() {
@@ -119,16 +155,16 @@ bool DirectorFile::readAfterburnerMap() {
 	uint32_t fverLength = stream->readVarInt();
 	start = stream->pos();
 	uint32_t fverVersion = stream->readVarInt();
-	Common::debug(boost::format("Fver: version: 0x%X") % fverVersion);
+	LOG_DEBUG(boost::format("Fver: version: 0x%X") % fverVersion);
 	if (fverVersion >= 0x401) {
 		uint32_t imapVersion = stream->readVarInt();
 		uint32_t directorVersion = stream->readVarInt();
-		Common::debug(boost::format("Fver: imapVersion: %u directorVersion: 0x%X") % imapVersion % directorVersion);
+		LOG_DEBUG(boost::format("Fver: imapVersion: %u directorVersion: 0x%X") % imapVersion % directorVersion);
 	}
 	if (fverVersion >= 0x501) {
 		uint8_t versionStringLen = stream->readUint8();
 		fverVersionString = stream->readString(versionStringLen);
-		Common::debug(boost::format("Fver: versionString: %s") % fverVersionString);
+		LOG_DEBUG(boost::format("Fver: versionString: %s") % fverVersionString);
 	}
 	end = stream->pos();
 
@@ -168,9 +204,9 @@ bool DirectorFile::readAfterburnerMap() {
 						% (unsigned)fcdrUncompLength % fcdrStream.pos());
 	}
 
-	Common::debug(boost::format("Fcdr: %u compression types") % compressionTypeCount);
+	LOG_DEBUG(boost::format("Fcdr: %u compression types") % compressionTypeCount);
 	for (size_t i = 0; i < compressionTypeCount; i++) {
-		Common::debug(boost::format("Fcdr: type %zu: %s \"%s\"")
+		LOG_DEBUG(boost::format("Fcdr: type %zu: %s \"%s\"")
 						% i % compressionIDs[i].toString() % compressionDescs[i]);
 	}
 
@@ -183,7 +219,7 @@ bool DirectorFile::readAfterburnerMap() {
 	uint32_t abmpEnd = stream->pos() + abmpLength;
 	uint32_t abmpCompressionType = stream->readVarInt();
 	uint32_t abmpUncompLength = stream->readVarInt();
-	Common::debug(boost::format("ABMP: length: %u compressionType: %u uncompressedLength: %u")
+	LOG_DEBUG(boost::format("ABMP: length: %u compressionType: %u uncompressedLength: %u")
 					% abmpLength % abmpCompressionType % abmpUncompLength);
 
 	std::vector<uint8_t> abmpBuf(abmpUncompLength);
@@ -201,9 +237,11 @@ bool DirectorFile::readAfterburnerMap() {
 	uint32_t abmpUnk1 = abmpStream.readVarInt();
 	uint32_t abmpUnk2 = abmpStream.readVarInt();
 	uint32_t resCount = abmpStream.readVarInt();
-	Common::debug(boost::format("ABMP: unk1: %u unk2: %u resCount: %u")
+	LOG_DEBUG(boost::format("ABMP: unk1: %u unk2: %u resCount: %u")
 					% abmpUnk1 % abmpUnk2 % resCount);
 
+	std::vector<ChunkInfo> infos;
+	size_t chunkCount = 0;
 	for (uint32_t i = 0; i < resCount; i++) {
 		int32_t resId = abmpStream.readVarInt();
 		int32_t offset = abmpStream.readVarInt();
@@ -212,7 +250,7 @@ bool DirectorFile::readAfterburnerMap() {
 		uint32_t compressionType = abmpStream.readVarInt();
 		uint32_t tag = abmpStream.readUint32();
 
-		Common::debug(boost::format("Found RIFX resource index %d: '%s', %u bytes (%u uncompressed) @ pos 0x%08x (%d), compressionType: %u")
+		LOG_DEBUG(boost::format("Found RIFX resource index %d: '%s', %u bytes (%u uncompressed) @ pos 0x%08x (%d), compressionType: %u")
 						% resId % Common::fourCCToString(tag) % compSize % uncompSize % offset % offset % compressionType);
 
 		ChunkInfo info;
@@ -222,13 +260,27 @@ bool DirectorFile::readAfterburnerMap() {
 		info.uncompressedLen = uncompSize;
 		info.offset = offset;
 		info.compressionID = compressionIDs[compressionType];
-		chunkInfo[resId] = info;
-
-		chunkIDsByFourCC[tag].push_back(resId);
+		if (resId < 0) {
+			Common::warning(boost::format("readAfterburnerMap(): Invalid resource index %d") % resId);
+			return false;
+		}
+		infos.push_back(info);
+		chunkCount = std::max(chunkCount, (size_t)resId + 1);
 	}
+	// The chunk table is indexed by ID, so a bogus ID would have it allocate
+	// an enormous table. IDs can be sparse when a movie was never compacted
+	// after deleting chunks, so the limit is on the table's memory rather
+	// than on how sparse it is.
+	const size_t kMaxChunkTableSize = 256 * 1024 * 1024;
+	if (chunkCount > kMaxChunkTableSize / sizeof(ChunkEntry)) {
+		Common::warning(boost::format("readAfterburnerMap(): Resource index %zu out of range")
+						% (chunkCount - 1));
+		return false;
+	}
+	initChunks(infos, chunkCount);
 
 	// Initial load segment
-	if (chunkInfo.find(2) == chunkInfo.end()) {
+	if (!findChunk(2)) {
 		Common::warning("readAfterburnerMap(): Map has no entry for ILS");
 		return false;
 	}
@@ -237,9 +289,9 @@ bool DirectorFile::readAfterburnerMap() {
 		return false;
 	}
 
-	ChunkInfo &ilsInfo = chunkInfo[2];
+	ChunkInfo &ilsInfo = _chunks[2].info;
 	uint32_t ilsUnk1 = stream->readVarInt();
-	Common::debug(boost::format("ILS: length: %u unk1: %u") % ilsInfo.len % ilsUnk1);
+	LOG_DEBUG(boost::format("ILS: length: %u unk1: %u") % ilsInfo.len % ilsUnk1);
 	_ilsBodyOffset = stream->pos();
 	_ilsBuf.resize(ilsInfo.uncompressedLen);
 	ssize_t ilsActualUncompLength = stream->readZlibBytes(ilsInfo.len, _ilsBuf.data(), _ilsBuf.size());
@@ -251,16 +303,23 @@ bool DirectorFile::readAfterburnerMap() {
 		Common::warning(boost::format("ILS: Expected uncompressed length %u but got length %zu")
 						% ilsInfo.uncompressedLen % (unsigned)ilsActualUncompLength);
 	}
+	Common::count(profile, Common::kCounterBytesDecompressed, ilsActualUncompLength);
 	Common::ReadStream ilsStream(_ilsBuf.data(), ilsInfo.uncompressedLen, endianness);
 
 	while (!ilsStream.eof()) {
 		int32_t resId = ilsStream.readVarInt();
-		ChunkInfo &info = chunkInfo[resId];
+		ChunkEntry *entry = findChunk(resId);
+		if (!entry) {
+			Common::warning(boost::format("ILS: Map has no entry for resource %d") % resId);
+			return false;
+		}
+		const ChunkInfo &info = entry->info;
 
-		Common::debug(boost::format("Loading ILS resource %d: '%s', %u bytes")
+		LOG_DEBUG(boost::format("Loading ILS resource %d: '%s', %u bytes")
 						% resId % Common::fourCCToString(info.fourCC) % info.len);
 
-		_cachedChunkViews[resId] = ilsStream.readByteView(info.len);
+		entry->view = ilsStream.readByteView(info.len);
+		entry->cached = true;
 	}
 
 	return true;
@@ -271,14 +330,16 @@ bool DirectorFile::readKeyTable() {
 	if (info) {
 		keyTable = std::static_pointer_cast<KeyTableChunk>(getChunk(info->fourCC, info->id));
 
-		for (size_t i = 0; i < keyTable->usedCount; i++) {
-			const KeyTableEntry &entry = keyTable->entries[i];
-			uint32_t ownerTag = FOURCC('?', '?', '?', '?');
-			if (chunkInfo.find(entry.castID) != chunkInfo.end()) {
-				ownerTag = chunkInfo[entry.castID].fourCC;
+		if (Common::logLevelEnabled(Common::kLogLevelDebug)) {
+			for (size_t i = 0; i < keyTable->usedCount; i++) {
+				const KeyTableEntry &entry = keyTable->entries[i];
+				uint32_t ownerTag = FOURCC('?', '?', '?', '?');
+				if (const ChunkInfo *ownerInfo = getChunkInfo(entry.castID)) {
+					ownerTag = ownerInfo->fourCC;
+				}
+				Common::debug(boost::format("KEY* entry %u: '%s' @ %d owned by '%s' @ %d")
+					% i % Common::fourCCToString(entry.fourCC) % entry.sectionID % Common::fourCCToString(ownerTag) % entry.castID);
 			}
-			Common::debug(boost::format("KEY* entry %u: '%s' @ %d owned by '%s' @ %d")
-				% i % Common::fourCCToString(entry.fourCC) % entry.sectionID % Common::fourCCToString(ownerTag) % entry.castID);
 		}
 
 		return true;
@@ -313,14 +374,8 @@ bool DirectorFile::readCasts() {
 		if (info) {
 			auto castList = std::static_pointer_cast<CastListChunk>(getChunk(info->fourCC, info->id));
 			for (const auto &castEntry : castList->entries) {
-				Common::debug("Cast: " + castEntry.name);
-				int32_t sectionID = -1;
-				for (const auto &keyEntry : keyTable->entries) {
-					if (keyEntry.castID == castEntry.id && keyEntry.fourCC == FOURCC('C', 'A', 'S', '*')) {
-						sectionID = keyEntry.sectionID;
-						break;
-					}
-				}
+				LOG_DEBUG("Cast: " + castEntry.name);
+				int32_t sectionID = keyTable->findSectionID(castEntry.id, FOURCC('C', 'A', 'S', '*'));
 				if (sectionID > 0) {
 					auto cast = std::static_pointer_cast<CastChunk>(getChunk(FOURCC('C', 'A', 'S', '*'), sectionID));
 					cast->populate(castEntry.name, castEntry.id, castEntry.minMember);
@@ -347,41 +402,70 @@ bool DirectorFile::readCasts() {
 	return false;
 }
 
+// The table is sized once from the map, so that pointers into it stay valid.
+void DirectorFile::initChunks(const std::vector<ChunkInfo> &infos, size_t count) {
+	_chunks.clear();
+	_chunks.resize(count);
+	_firstChunkIDs.clear();
+	for (const ChunkInfo &info : infos) {
+		ChunkEntry &entry = _chunks[info.id];
+		entry.info = info;
+		entry.exists = true;
+		_firstChunkIDs.emplace(info.fourCC, info.id);
+	}
+}
+
+DirectorFile::ChunkEntry *DirectorFile::findChunk(int32_t id) {
+	if (id < 0 || (size_t)id >= _chunks.size() || !_chunks[id].exists)
+		return nullptr;
+
+	return &_chunks[id];
+}
+
+const ChunkInfo *DirectorFile::getChunkInfo(int32_t id) {
+	ChunkEntry *entry = findChunk(id);
+	return entry ? &entry->info : nullptr;
+}
+
 const ChunkInfo *DirectorFile::getFirstChunkInfo(uint32_t fourCC) {
-	auto &chunkIDs = chunkIDsByFourCC[fourCC];
-	if (chunkIDs.size() > 0) {
-		return &chunkInfo[chunkIDs[0]];
+	auto it = _firstChunkIDs.find(fourCC);
+	if (it != _firstChunkIDs.end()) {
+		return &_chunks[it->second].info;
 	}
 	return nullptr;
 }
 
 bool DirectorFile::chunkExists(uint32_t fourCC, int32_t id) {
-	if (chunkInfo.find(id) == chunkInfo.end())
+	ChunkEntry *entry = findChunk(id);
+	if (!entry)
 		return false;
 
-	if (fourCC != chunkInfo[id].fourCC)
+	if (fourCC != entry->info.fourCC)
 		return false;
 
 	return true;
 }
 
 std::shared_ptr<Chunk> DirectorFile::getChunk(uint32_t fourCC, int32_t id) {
-	if (deserializedChunks.find(id) != deserializedChunks.end())
-		return deserializedChunks[id];
+	ChunkEntry *entry = findChunk(id);
+	if (entry && entry->chunk)
+		return entry->chunk;
 
 	Common::BufferView chunkView = getChunkData(fourCC, id);
 	std::shared_ptr<Chunk> chunk = makeChunk(fourCC, chunkView);
 
-	deserializedChunks[id] = chunk;
+	// makeChunk may have read other chunks, but the table never moves.
+	_chunks[id].chunk = chunk;
 
 	return chunk;
 }
 
 Common::BufferView DirectorFile::getChunkData(uint32_t fourCC, int32_t id) {
-	if (chunkInfo.find(id) == chunkInfo.end())
+	ChunkEntry *entry = findChunk(id);
+	if (!entry)
 		throw std::runtime_error("Could not find chunk " + std::to_string(id));
 
-	auto &info = chunkInfo[id];
+	auto &info = entry->info;
 	if (fourCC != info.fourCC) {
 		throw std::runtime_error(
 			"Expected chunk " + std::to_string(id) + " to be '" + Common::fourCCToString(fourCC)
@@ -389,51 +473,33 @@ Common::BufferView DirectorFile::getChunkData(uint32_t fourCC, int32_t id) {
 		);
 	}
 
-	if (_cachedChunkViews.find(id) != _cachedChunkViews.end()) {
-		return _cachedChunkViews[id];
+	if (entry->cached) {
+		return entry->view;
 	}
 
 	if (afterburned) {
 		stream->seek(info.offset + _ilsBodyOffset);
 		if (info.len == 0 && info.uncompressedLen == 0) {
-			_cachedChunkViews[id] = stream->readByteView(info.len);
-		} else if (compressionImplemented(info.compressionID)) {
-			ssize_t actualUncompLength = -1;
-			_cachedChunkBufs[id] = std::vector<uint8_t>(info.uncompressedLen);
-			if (info.compressionID == ZLIB_COMPRESSION_GUID) {
-				actualUncompLength = stream->readZlibBytes(info.len, _cachedChunkBufs[id].data(), _cachedChunkBufs[id].size());
-			} else if (info.compressionID == SND_COMPRESSION_GUID) {
-				Common::BufferView chunkView = stream->readByteView(info.len);
-				Common::ReadStream chunkStream(chunkView, endianness);
-				Common::WriteStream uncompStream(_cachedChunkBufs[id].data(), _cachedChunkBufs[id].size(), endianness);
-				actualUncompLength = decompressSnd(chunkStream, uncompStream, id);
-			}
-			if (actualUncompLength == -1) {
-				throw std::runtime_error(boost::str(
-					boost::format("Chunk %d: Could not decompress") % id
-				));
-			}
-			if ((unsigned)actualUncompLength != info.uncompressedLen) {
-				throw std::runtime_error(boost::str(
-					boost::format("Chunk %d: Expected uncompressed length %u but got length %zu")
-						% id % info.uncompressedLen % (unsigned)actualUncompLength
-				));
-			}
-			_cachedChunkViews[id] = Common::BufferView(_cachedChunkBufs[id].data(), _cachedChunkBufs[id].size());
+			entry->view = stream->readByteView(info.len);
+		} else if (decompresses(info)) {
+			entry->buf.resize(decompressedLength(id));
+			decompressChunk(id, entry->buf.data(), entry->buf.size());
+			entry->view = Common::BufferView(entry->buf.data(), entry->buf.size());
 		} else if (info.compressionID == FONTMAP_COMPRESSION_GUID) {
-			_cachedChunkViews[id] = getFontMap(version);
+			entry->view = getFontMap(version);
 		} else {
-			if (info.compressionID != NULL_COMPRESSION_GUID) {
+			if (info.compressionID != NULL_COMPRESSION_GUID && info.compressionID != SND_COMPRESSION_GUID) {
 				Common::warning(boost::format("Unhandled compression type %s!") % info.compressionID.toString());
 			}
-			_cachedChunkViews[id] = stream->readByteView(info.len);
+			entry->view = stream->readByteView(info.len);
 		}
 	} else {
 		stream->seek(info.offset);
-		_cachedChunkViews[id] = readChunkData(fourCC, info.len);
+		entry->view = readChunkData(fourCC, info.len);
 	}
+	entry->cached = true;
 
-	return _cachedChunkViews[id];
+	return entry->view;
 }
 
 std::shared_ptr<Chunk> DirectorFile::readChunk(uint32_t fourCC, uint32_t len) {
@@ -461,13 +527,16 @@ Common::BufferView DirectorFile::readChunkData(uint32_t fourCC, uint32_t len) {
 			+ ", but got '" + Common::fourCCToString(validFourCC) + "' chunk with length " + std::to_string(validLen)
 		);
 	} else {
-		Common::debug("At offset " + std::to_string(offset) + " reading chunk '" + Common::fourCCToString(fourCC) + "' with length " + std::to_string(len));
+		LOG_DEBUG("At offset " + std::to_string(offset) + " reading chunk '" + Common::fourCCToString(fourCC) + "' with length " + std::to_string(len));
 	}
 
 	return stream->readByteView(len);
 }
 
 std::shared_ptr<Chunk> DirectorFile::makeChunk(uint32_t fourCC, const Common::BufferView &view) {
+	Common::ScopedTimer timer(profile, Common::kPhaseDeserialize);
+	Common::count(profile, Common::kCounterChunksDeserialized);
+
 	std::shared_ptr<Chunk> res;
 	switch (fourCC) {
 	case FOURCC('i', 'm', 'a', 'p'):
@@ -524,15 +593,260 @@ bool DirectorFile::compressionImplemented(MoaID compressionID) {
 		|| compressionID == SND_COMPRESSION_GUID;
 }
 
+// Unlike getChunkData, this doesn't touch the shared stream,
+// so chunks can be decompressed concurrently.
+Common::BufferView DirectorFile::compressedChunkData(const ChunkInfo &info) {
+	Common::ReadStream fileStream(stream->data(), stream->size(), endianness, info.offset + _ilsBodyOffset);
+	return fileStream.readByteView(info.len);
+}
+
+bool DirectorFile::decompresses(const ChunkInfo &info) {
+	if (info.compressionID == SND_COMPRESSION_GUID && soundMode == Common::kSoundModeKeepUnplayable)
+		return false;
+
+	return compressionImplemented(info.compressionID);
+}
+
+size_t DirectorFile::decompressedLength(int32_t id) {
+	const ChunkInfo &info = _chunks.at(id).info;
+	if (info.compressionID == SND_COMPRESSION_GUID && soundMode == Common::kSoundModeExtractSilent) {
+		// Only the sound header is kept, so its length depends on its contents.
+		Common::ReadStream chunkStream(compressedChunkData(info), endianness);
+		std::vector<uint8_t> header(info.len);
+		Common::WriteStream headerStream(header.data(), header.size(), endianness);
+		ssize_t headerLength = decompressSnd(chunkStream, headerStream, id, false);
+		if (headerLength == -1) {
+			throw std::runtime_error(boost::str(
+				boost::format("Chunk %d: Could not read sound header") % id
+			));
+		}
+		return headerLength;
+	}
+
+	return info.uncompressedLen;
+}
+
+void DirectorFile::decompressChunk(int32_t id, uint8_t *dest, size_t destLen) {
+	Common::ScopedTimer timer(profile, Common::kPhaseDecompress);
+	const ChunkInfo &info = _chunks.at(id).info;
+	size_t expectedLength = decompressedLength(id);
+	if (destLen < expectedLength) {
+		throw std::runtime_error(boost::str(
+			boost::format("Chunk %d: Not enough space to decompress %zu bytes") % id % expectedLength
+		));
+	}
+
+	Common::BufferView chunkView = compressedChunkData(info);
+	ssize_t actualUncompLength = -1;
+	if (info.compressionID == ZLIB_COMPRESSION_GUID) {
+		Common::ReadStream chunkStream(chunkView, endianness);
+		actualUncompLength = chunkStream.readZlibBytes(info.len, dest, info.uncompressedLen);
+	} else if (info.compressionID == SND_COMPRESSION_GUID) {
+		Common::ReadStream chunkStream(chunkView, endianness);
+		Common::WriteStream uncompStream(dest, expectedLength, endianness);
+		actualUncompLength = decompressSnd(chunkStream, uncompStream, id, soundMode != Common::kSoundModeExtractSilent);
+	}
+	if (actualUncompLength == -1) {
+		throw std::runtime_error(boost::str(
+			boost::format("Chunk %d: Could not decompress") % id
+		));
+	}
+	if ((size_t)actualUncompLength != expectedLength) {
+		throw std::runtime_error(boost::str(
+			boost::format("Chunk %d: Expected uncompressed length %zu but got length %zu")
+				% id % expectedLength % (size_t)actualUncompLength
+		));
+	}
+	Common::count(profile, Common::kCounterBytesDecompressed, actualUncompLength);
+}
+
 // write stuff
 
-void DirectorFile::writeToFile(const std::filesystem::path &path) {
+bool DirectorFile::writeToFile(const std::filesystem::path &path) {
+	Common::ScopedTimer timer(profile, Common::kPhaseWrite);
 	generateInitialMap();
 	generateMemoryMap();
-	std::vector<uint8_t> buf(size());
-	Common::WriteStream stream(buf.data(), buf.size(), endianness);
-	write(stream);
-	Common::writeFile(path, stream);
+
+	// Unchanged chunks are copied from the input as the output is written,
+	// so overwriting the input has to go through a temporary file.
+	std::filesystem::path outputPath = path;
+	std::error_code ec;
+	bool replacingSource = sourceFile && std::filesystem::equivalent(path, sourceFile->path(), ec);
+	if (replacingSource) {
+		outputPath += ".tmp";
+	}
+
+	Common::FileWriter file;
+	if (!file.open(outputPath)) {
+		Common::warning("Could not write " + outputPath.string() + "!");
+		return false;
+	}
+	write(file);
+	file.close();
+
+	if (replacingSource) {
+		std::filesystem::rename(outputPath, path);
+	}
+
+	if (soundMode == Common::kSoundModeExtractSilent) {
+		std::filesystem::path soundDir = path;
+		soundDir.replace_filename(path.stem().string() + "_sounds");
+		extractSounds(soundDir);
+	}
+
+	return true;
+}
+
+// An uncompressed movie can be patched rather than rewritten: its chunks
+// stay where they are and the memory map is updated to point at the ones
+// that changed.
+bool DirectorFile::canPatch() const {
+	return !afterburned && sourceFile && _chunks.size() > 2 && _chunks[2].chunk;
+}
+
+bool DirectorFile::patchFile(const std::filesystem::path &path) {
+	Common::ScopedTimer timer(profile, Common::kPhaseWrite);
+	auto &mmap = static_cast<MemoryMapChunk &>(*_chunks[2].chunk);
+	auto &rifxEntry = mmap.mapArray[0];
+	auto &mmapEntry = mmap.mapArray[2];
+
+	// Chunks that grew are moved to the end of the file. The space they
+	// leave behind is simply no longer referenced.
+	struct Patch {
+		size_t offset;
+		std::vector<uint8_t> data;
+	};
+	std::vector<Patch> patches;
+	size_t end = std::max(sourceFile->size(), (size_t)rifxEntry.len + kChunkHeaderSize);
+	for (auto &entry : _chunks) {
+		const ChunkInfo &info = entry.info;
+		int32_t id = info.id;
+		if (!entry.exists || id <= 2) // Ignore RIFX, imap, mmap
+			continue;
+
+		if (!entry.chunk || !entry.chunk->writable)
+			continue;
+
+		Chunk &chunk = *entry.chunk;
+		size_t len = chunk.size();
+		std::vector<uint8_t> buf(kChunkHeaderSize + len);
+		Common::WriteStream stream(buf.data(), buf.size(), endianness);
+		stream.writeUint32(info.fourCC);
+		stream.writeUint32(len);
+		chunk.write(stream);
+
+		Common::BufferView original = getChunkData(info.fourCC, id);
+		if (len == original.size() && memcmp(buf.data() + kChunkHeaderSize, original.data(), len) == 0)
+			continue;
+
+		auto &mapEntry = mmap.mapArray[id];
+		if (len > info.len) {
+			mapEntry.offset = end;
+			end += buf.size();
+		}
+		mapEntry.len = len;
+		patches.push_back({ (size_t)mapEntry.offset, std::move(buf) });
+	}
+	rifxEntry.len = end - kChunkHeaderSize;
+
+	std::vector<uint8_t> mmapBuf(mmap.size());
+	Common::WriteStream mmapStream(mmapBuf.data(), mmapBuf.size(), endianness);
+	mmap.write(mmapStream);
+
+	uint8_t rifxLen[4];
+	Common::WriteStream rifxStream(rifxLen, sizeof(rifxLen), endianness);
+	rifxStream.writeUint32(rifxEntry.len);
+
+	// Everything to be written is built by now, so the input is no longer
+	// read and can be patched in place. Then only the changes are written.
+	std::error_code ec;
+	bool inPlace = std::filesystem::equivalent(path, sourceFile->path(), ec);
+	Common::FileWriter file;
+	if (!file.open(path, !inPlace)) {
+		Common::warning("Could not write " + path.string() + "!");
+		return false;
+	}
+	if (!inPlace) {
+		file.copy(*sourceFile, 0, 0, sourceFile->size());
+		file.flush();
+	}
+	if (!patches.empty()) {
+		// Chunks moved to the end go first and reach the disk before anything
+		// the current map points to is touched, so an interrupted patch
+		// leaves the old chunks intact wherever possible. The RIFX length
+		// comes last.
+		size_t sourceSize = sourceFile->size();
+		for (const auto &patch : patches) {
+			if (patch.offset >= sourceSize) {
+				file.write(patch.offset, patch.data.data(), patch.data.size());
+			}
+		}
+		file.sync();
+		for (const auto &patch : patches) {
+			if (patch.offset < sourceSize) {
+				file.write(patch.offset, patch.data.data(), patch.data.size());
+			}
+		}
+		file.write(mmapEntry.offset + kChunkHeaderSize, mmapBuf.data(), mmapStream.pos());
+		file.write(rifxEntry.offset + 4, rifxLen, sizeof(rifxLen));
+	}
+	file.close();
+
+	LOG_DEBUG(boost::format("Patched %zu chunks") % patches.size());
+	return true;
+}
+
+// Each sound is named after the cast member it belongs to, the way
+// dumpScripts() names scripts, so it can be matched back to its member.
+void DirectorFile::extractSounds(const std::filesystem::path &dir) {
+	std::map<int32_t, int32_t> sndOwners;
+	if (keyTable) {
+		for (const auto &entry : keyTable->entries) {
+			if (entry.fourCC == FOURCC('s', 'n', 'd', ' ')) {
+				sndOwners[entry.sectionID] = entry.castID;
+			}
+		}
+	}
+	std::map<int32_t, const CastChunk *> memberCasts;
+	for (const auto &cast : casts) {
+		for (int32_t sectionID : cast->memberIDs) {
+			if (sectionID > 0) {
+				memberCasts[sectionID] = cast.get();
+			}
+		}
+	}
+
+	for (const auto &entry : _chunks) {
+		const ChunkInfo &info = entry.info;
+		int32_t id = info.id;
+		if (!entry.exists || !afterburned || info.compressionID != SND_COMPRESSION_GUID || info.len == 0)
+			continue;
+
+		Common::ReadStream chunkStream(compressedChunkData(info), endianness);
+		std::vector<uint8_t> header(info.len);
+		Common::WriteStream headerStream(header.data(), header.size(), endianness);
+		if (decompressSnd(chunkStream, headerStream, id, false) == -1) {
+			Common::warning(boost::format("Chunk %d: Could not read sound header") % id);
+			continue;
+		}
+
+		std::string name = Common::fourCCToString(info.fourCC) + "-" + std::to_string(id);
+		auto owner = sndOwners.find(id);
+		if (owner != sndOwners.end()) {
+			auto cast = memberCasts.find(owner->second);
+			if (cast != memberCasts.end() && chunkExists(FOURCC('C', 'A', 'S', 't'), owner->second)) {
+				auto member = std::static_pointer_cast<CastMemberChunk>(getChunk(FOURCC('C', 'A', 'S', 't'), owner->second));
+				name = "Cast " + cast->second->name + " Sound " + std::to_string(member->id);
+				if (!member->getName().empty()) {
+					name += " - " + member->getName();
+				}
+			}
+		}
+
+		std::filesystem::create_directories(dir);
+		std::filesystem::path fileName = dir / (Common::cleanFileName(name) + ".mp3");
+		Common::writeFile(fileName, chunkStream.readByteView(chunkStream.size() - chunkStream.pos()));
+	}
 }
 
 void DirectorFile::generateInitialMap() {
@@ -548,9 +862,9 @@ void DirectorFile::generateInitialMap() {
 void DirectorFile::generateMemoryMap() {
 	// Figure out how many slots we'll need
 	int32_t maxID = 2; // the mmap's ID
-	for (auto [id, info] : chunkInfo) {
-		if (id > maxID) {
-			maxID = id;
+	for (const auto &entry : _chunks) {
+		if (entry.exists && entry.info.id > maxID) {
+			maxID = entry.info.id;
 		}
 	}
 
@@ -604,12 +918,13 @@ void DirectorFile::generateMemoryMap() {
 	mmapEntry.next = 0;
 	nextOffset += mmapEntry.len + kChunkHeaderSize;
 
-	for (auto [id, info] : chunkInfo) {
-		if (id <= 2) // Ignore RIFX, imap, mmap
+	for (const auto &chunkEntry : _chunks) {
+		int32_t id = chunkEntry.info.id;
+		if (!chunkEntry.exists || id <= 2) // Ignore RIFX, imap, mmap
 			continue;
 
 		auto &entry = memoryMap->mapArray[id];
-		entry.fourCC = info.fourCC;
+		entry.fourCC = chunkEntry.info.fourCC;
 		entry.len = chunkSize(id);
 		entry.offset = nextOffset;
 		entry.flags = 0;
@@ -636,14 +951,12 @@ size_t DirectorFile::size() {
 
 size_t DirectorFile::chunkSize(int32_t id) {
 	// If we've implemented writing for this chunk, recalculate its size.
-	if (deserializedChunks.find(id) != deserializedChunks.end()) {
-		Chunk &chunk = *deserializedChunks[id];
-		if (chunk.writable) {
-			return chunk.size();
-		}
+	ChunkEntry &entry = _chunks.at(id);
+	if (entry.chunk && entry.chunk->writable) {
+		return entry.chunk->size();
 	}
 
-	auto &info = chunkInfo[id];
+	auto &info = entry.info;
 
 	// If this is a compressed fontmap, return the default fontmap size.
 	if (info.compressionID == FONTMAP_COMPRESSION_GUID) {
@@ -652,42 +965,82 @@ size_t DirectorFile::chunkSize(int32_t id) {
 
 	// If we've implemented this compression algorithm,
 	// return the uncompressed size.
-	if (compressionImplemented(info.compressionID)) {
-		return info.uncompressedLen;
+	if (decompresses(info)) {
+		return decompressedLength(id);
 	}
 
 	// Otherwise, return the original size.
 	return info.len;
 }
 
-void DirectorFile::write(Common::WriteStream &stream) {
-	writeChunk(stream, 0); // Write RIFX
-	writeChunk(stream, 1); // Write imap
-	writeChunk(stream, 2); // Write mmap
+void DirectorFile::write(Common::OutputWriter &file) {
+	writeChunk(file, 0); // Write RIFX
+	writeChunk(file, 1); // Write imap
+	writeChunk(file, 2); // Write mmap
+
+	// Decompressing pass-through chunks is usually the bulk of the work, and
+	// each one goes to its own region of the output, so do those in parallel
+	// first.
+	std::vector<int32_t> decompressedIDs;
+	if (threadPool) {
+		for (const auto &entry : _chunks) {
+			int32_t id = entry.info.id;
+			if (entry.exists && id > 2 && isPassThroughCompressed(id)) {
+				decompressedIDs.push_back(id);
+			}
+		}
+		std::vector<std::vector<Common::LogMessage>> messages(decompressedIDs.size());
+		threadPool->parallelFor(decompressedIDs.size(), [&](size_t i) {
+			Common::LogCapture capture;
+			writeChunk(file, decompressedIDs[i]);
+			messages[i] = capture.take();
+		});
+		for (const auto &chunkMessages : messages) {
+			Common::replay(chunkMessages);
+		}
+	}
 
-	for (auto [id, info] : chunkInfo) {
-		if (id <= 2) // Ignore RIFX, imap, mmap
+	auto decompressed = decompressedIDs.begin();
+	for (const auto &entry : _chunks) {
+		int32_t id = entry.info.id;
+		if (!entry.exists || id <= 2) // Ignore RIFX, imap, mmap
 			continue;
 
-		writeChunk(stream, id);
+		if (decompressed != decompressedIDs.end() && *decompressed == id) {
+			decompressed++;
+			continue;
+		}
+		writeChunk(file, id);
 	}
 }
 
-void DirectorFile::writeChunk(Common::WriteStream &stream, int32_t id) {
-	auto &mapEntry = memoryMap->mapArray[id];
+bool DirectorFile::isPassThroughCompressed(int32_t id) {
+	const ChunkEntry &entry = _chunks.at(id);
+	if (!afterburned || entry.cached)
+		return false;
+
+	if (entry.chunk && entry.chunk->writable)
+		return false;
 
-	stream.endianness = endianness;
+	const ChunkInfo &info = entry.info;
+	return info.len != 0 && decompresses(info);
+}
+
+void DirectorFile::writeChunk(Common::OutputWriter &file, int32_t id) {
+	auto &mapEntry = memoryMap->mapArray[id];
 
-	stream.seek(mapEntry.offset);
-	stream.writeUint32(mapEntry.fourCC);
-	stream.writeUint32(mapEntry.len);
+	uint8_t header[kRIFXHeaderSize];
+	Common::WriteStream headerStream(header, sizeof(header), endianness);
+	headerStream.writeUint32(mapEntry.fourCC);
+	headerStream.writeUint32(mapEntry.len);
 
 	Chunk *chunk = nullptr;
 	switch (id) {
 	case 0: // RIFX
 		{
 			uint32_t newCodec = (isCast()) ? FOURCC('M', 'C', '9', '5') : FOURCC('M', 'V', '9', '3');
-			stream.writeUint32(newCodec);
+			headerStream.writeUint32(newCodec);
+			file.write(mapEntry.offset, header, kRIFXHeaderSize);
 		}
 		return;
 	case 1: // imap
@@ -697,17 +1050,47 @@ void DirectorFile::writeChunk(Common::WriteStream &stream, int32_t id) {
 		chunk = memoryMap.get();
 		break;
 	default:
-		if (deserializedChunks.find(id) != deserializedChunks.end()) {
-			chunk = deserializedChunks[id].get();
-		}
+		chunk = _chunks.at(id).chunk.get();
 		break;
 	}
+
+	size_t len;
 	if (chunk && chunk->writable) {
+		std::vector<uint8_t> buf(kChunkHeaderSize + mapEntry.len);
+		Common::WriteStream stream(buf.data(), buf.size(), endianness);
+		stream.writeBytes(header, kChunkHeaderSize);
 		chunk->write(stream);
+		len = stream.pos() - kChunkHeaderSize;
+		file.write(mapEntry.offset, buf.data(), stream.pos());
+	} else if (id > 2 && isPassThroughCompressed(id)) {
+		// This chunk is only being copied through, so inflate it for the
+		// output alone rather than keeping a copy around.
+		len = decompressedLength(id);
+		std::vector<uint8_t> buf(kChunkHeaderSize + len);
+		memcpy(buf.data(), header, kChunkHeaderSize);
+		decompressChunk(id, buf.data() + kChunkHeaderSize, len);
+		file.write(mapEntry.offset, buf.data(), buf.size());
 	} else {
-		stream.writeBytes(getChunkData(mapEntry.fourCC, id));
+		Common::BufferView data = getChunkData(mapEntry.fourCC, id);
+		len = data.size();
+		if (sourceFile && sourceFile->contains(data)) {
+			// Unchanged data is copied straight from the input. Unless the
+			// input was compressed, the chunk's header is right before it
+			// and can be copied along with it, which lets runs of untouched
+			// chunks go out as a single copy.
+			size_t sourceOffset = data.data() - sourceFile->data();
+			if (sourceOffset >= kChunkHeaderSize
+					&& memcmp(data.data() - kChunkHeaderSize, header, kChunkHeaderSize) == 0) {
+				file.copy(*sourceFile, sourceOffset - kChunkHeaderSize, mapEntry.offset, kChunkHeaderSize + len);
+			} else {
+				file.write(mapEntry.offset, header, kChunkHeaderSize);
+				file.copy(*sourceFile, sourceOffset, mapEntry.offset + kChunkHeaderSize, len);
+			}
+		} else {
+			file.write(mapEntry.offset, header, kChunkHeaderSize);
+			file.write(mapEntry.offset + kChunkHeaderSize, data);
+		}
 	}
-	size_t len = stream.pos() - mapEntry.offset - 8;
 	if ((unsigned)mapEntry.len != len) {
 		Common::warning(
 			boost::format("Size estimate for '%s' was incorrect! (Expected %u bytes, wrote %zu)")
@@ -719,15 +1102,62 @@ void DirectorFile::writeChunk(Common::WriteStream &stream, int32_t id) {
 // restoration
 
 void DirectorFile::parseScripts() {
+	Common::ScopedTimer timer(profile, Common::kPhaseParseScripts);
+	if (!threadPool && !scriptCache) {
+		for (const auto &cast : casts) {
+			if (!cast->lctx)
+				continue;
+
+			cast->lctx->parseScripts();
+		}
+		return;
+	}
+
+	std::vector<ScriptChunk *> scripts;
 	for (const auto &cast : casts) {
 		if (!cast->lctx)
 			continue;
 
-		cast->lctx->parseScripts();
+		for (auto &[scriptId, script] : cast->lctx->scripts) {
+			scripts.push_back(script.get());
+		}
+	}
+
+	// With a script cache, the text restoreScriptText needs is looked up or
+	// rendered now so that it happens in parallel and the scripts that are
+	// found don't need to be parsed at all.
+	auto parseScript = [this](ScriptChunk *script) {
+		if (scriptCache) {
+			script->prepareText("\r");
+		} else {
+			script->parse();
+		}
+	};
+
+	if (!threadPool) {
+		for (ScriptChunk *script : scripts) {
+			parseScript(script);
+		}
+		return;
+	}
+
+	// A script's handlers only share its literals and the read-only name
+	// table, so scripts can be parsed independently of each other. Messages
+	// are held back per script and logged in order afterwards so that the
+	// output doesn't depend on scheduling.
+	std::vector<std::vector<Common::LogMessage>> messages(scripts.size());
+	threadPool->parallelFor(scripts.size(), [&](size_t i) {
+		Common::LogCapture capture;
+		parseScript(scripts[i]);
+		messages[i] = capture.take();
+	});
+	for (const auto &scriptMessages : messages) {
+		Common::replay(scriptMessages);
 	}
 }
 
 void DirectorFile::restoreScriptText() {
+	Common::ScopedTimer timer(profile, Common::kPhaseRestoreScriptText);
 	for (const auto &cast : casts) {
 		if (!cast->lctx)
 			continue;
@@ -743,53 +1173,86 @@ void DirectorFile::restoreScriptText() {
 
 // dumping
 
+std::string DirectorFile::scriptTypeName(const CastMemberChunk *member) const {
+	if (member->type != kScriptMember)
+		return "CastScript";
+
+	const ScriptMember *scriptMember = static_cast<const ScriptMember *>(member->member.get());
+	switch (scriptMember->scriptType) {
+	case kScoreScript:
+		return (version >= 600) ? "BehaviorScript" : "ScoreScript";
+	case kMovieScript:
+		return "MovieScript";
+	case kParentScript:
+		return "ParentScript";
+	default:
+		return "UnknownScript";
+	}
+}
+
 void DirectorFile::dumpScripts() {
+	Common::CodeWriter code(Common::kPlatformLineEnding);
 	for (const auto &cast : casts) {
 		if (!cast->lctx)
 			continue;
 
 		for (auto it = cast->lctx->scripts.begin(); it != cast->lctx->scripts.end(); ++it) {
-			std::string scriptType;
-			std::string id;
 			CastMemberChunk *member = it->second->member;
 			if (!member)
 				continue;
 
-			if (member->type == kScriptMember) {
-				ScriptMember *scriptMember = static_cast<ScriptMember *>(member->member.get());
-				switch (scriptMember->scriptType) {
-				case kScoreScript:
-					scriptType = (version >= 600) ? "BehaviorScript" : "ScoreScript";
-					break;
-				case kMovieScript:
-					scriptType = "MovieScript";
-					break;
-				case kParentScript:
-					scriptType = "ParentScript";
-					break;
-				default:
-					scriptType = "UnknownScript";
-					break;
-				}
-			} else {
-				scriptType = "CastScript";
-			}
-			id = std::to_string(member->id);
+			std::string id = std::to_string(member->id);
 			if (!member->getName().empty()) {
 				id += " - " + member->getName();
 			}
 
-			std::string fileName = Common::cleanFileName("Cast " + cast->name + " " + scriptType + " " + id);
-			Common::writeFile(fileName + ".ls", it->second->scriptText(Common::kPlatformLineEnding));
-			Common::writeFile(fileName + ".lasm", it->second->bytecodeText(Common::kPlatformLineEnding));
+			// Scripts restored from the script cache only have their text
+			// for the line ending that's stored in the movie.
+			it->second->parse();
+
+			std::string fileName = Common::cleanFileName("Cast " + cast->name + " " + scriptTypeName(member) + " " + id);
+			Common::writeFile(fileName + ".ls", it->second->scriptText(code));
+			Common::writeFile(fileName + ".lasm", it->second->bytecodeText(code));
 		}
 	}
 }
 
+void DirectorFile::writeScriptsJSON(Common::JSONWriter &json) {
+	Common::CodeWriter code("\n");
+	json.startArray();
+	for (const auto &cast : casts) {
+		if (!cast->lctx)
+			continue;
+
+		for (const auto &[scriptId, script] : cast->lctx->scripts) {
+			CastMemberChunk *member = script->member;
+			if (!member)
+				continue;
+
+			script->parse();
+			json.startObject();
+				json.writeKey("cast");
+				json.writeVal(cast->name);
+				json.writeKey("member");
+				json.writeVal(member->id);
+				json.writeKey("name");
+				json.writeVal(member->getName());
+				json.writeKey("type");
+				json.writeVal(scriptTypeName(member));
+				json.writeKey("text");
+				json.writeVal(script->scriptText(code));
+				json.writeKey("bytecode");
+				json.writeVal(script->bytecodeText(code));
+			json.endObject();
+		}
+	}
+	json.endArray();
+}
+
 void DirectorFile::dumpChunks() {
-	for (auto it = chunkInfo.begin(); it != chunkInfo.end(); it++) {
-		const auto &info = it->second;
-		if (info.id == 0) // RIFX
+	for (const auto &entry : _chunks) {
+		const auto &info = entry.info;
+		if (!entry.exists || info.id == 0) // RIFX
 			continue;
 
 		std::string fileName = Common::cleanFileName(Common::fourCCToString(info.fourCC) + "-" + std::to_string(info.id));
@@ -798,16 +1261,21 @@ void DirectorFile::dumpChunks() {
 }
 
 void DirectorFile::dumpJSON() {
-	for (auto it = chunkInfo.begin(); it != chunkInfo.end(); it++) {
-		const auto &info = it->second;
-		if (info.id == 0) // RIFX
+	for (const auto &entry : _chunks) {
+		const auto &info = entry.info;
+		if (!entry.exists || info.id == 0) // RIFX
 			continue;
 
 		std::string fileName = Common::cleanFileName(Common::fourCCToString(info.fourCC) + "-" + std::to_string(info.id));
-		if (deserializedChunks.find(info.id) != deserializedChunks.end()) {
-			Common::JSONWriter json;
-			deserializedChunks[info.id]->writeJSON(json);
-			Common::writeFile(fileName + ".json", json.str());
+		if (entry.chunk) {
+			Common::FileSink sink;
+			if (!sink.open(fileName + ".json"))
+				continue;
+
+			Common::JSONWriter json(sink);
+			entry.chunk->writeJSON(json);
+			json.flush();
+			sink.close();
 		}
 	}
 }
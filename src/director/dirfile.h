@@ -15,17 +15,28 @@
 #include <string>
 #include <vector>
 
+#include "common/options.h"
 #include "common/stream.h"
 #include "director/guid.h"
 
+namespace Common {
+class JSONWriter;
+class MappedFile;
+class OutputWriter;
+class Profile;
+class ThreadPool;
+}
+
 namespace Director {
 
 struct Chunk;
 struct CastChunk;
+struct CastMemberChunk;
 struct ConfigChunk;
 struct KeyTableChunk;
 struct InitialMapChunk;
 struct MemoryMapChunk;
+class ScriptCache;
 
 struct ChunkInfo {
 	int32_t id;
@@ -38,14 +49,37 @@ struct ChunkInfo {
 
 class DirectorFile {
 private:
+	// Everything known about one resource. Resource IDs are indices into the
+	// memory map or ABMP, so the table is indexed by ID directly. The fields
+	// every lookup checks come first.
+	struct ChunkEntry {
+		ChunkInfo info;
+		bool exists;
+		bool cached;
+		Common::BufferView view;
+		std::shared_ptr<Chunk> chunk;
+		std::vector<uint8_t> buf;
+
+		ChunkEntry() : exists(false), cached(false) {}
+	};
+
 	size_t _ilsBodyOffset;
 	std::vector<uint8_t> _ilsBuf;
 
-	std::map<int32_t, std::vector<uint8_t>> _cachedChunkBufs;
-	std::map<int32_t, Common::BufferView> _cachedChunkViews;
+	std::vector<ChunkEntry> _chunks;
+	std::map<uint32_t, int32_t> _firstChunkIDs;
+
+	void initChunks(const std::vector<ChunkInfo> &infos, size_t count);
+	ChunkEntry *findChunk(int32_t id);
+	bool isPassThroughCompressed(int32_t id);
 
 public:
 	Common::ReadStream *stream;
+	const Common::MappedFile *sourceFile;
+	Common::ThreadPool *threadPool;
+	Common::Profile *profile;
+	ScriptCache *scriptCache;
+	Common::SoundMode soundMode;
 	std::shared_ptr<KeyTableChunk> keyTable;
 	std::shared_ptr<ConfigChunk> config;
 
@@ -57,10 +91,6 @@ public:
 	uint32_t codec;
 	bool afterburned;
 
-	std::map<uint32_t, std::vector<int32_t>> chunkIDsByFourCC;
-	std::map<int32_t, ChunkInfo> chunkInfo;
-	std::map<int32_t, std::shared_ptr<Chunk>> deserializedChunks;
-
 	std::vector<std::shared_ptr<CastChunk>> casts;
 
 	std::unique_ptr<InitialMapChunk> initialMap;
@@ -69,12 +99,16 @@ public:
 	DirectorFile();
 	~DirectorFile();
 
+	static const size_t kSniffSize = 12;
+	static bool sniff(const Common::BufferView &header);
+
 	bool read(Common::ReadStream *s);
 	void readMemoryMap();
 	bool readAfterburnerMap();
 	bool readKeyTable();
 	bool readConfig();
 	bool readCasts();
+	const ChunkInfo *getChunkInfo(int32_t id);
 	const ChunkInfo *getFirstChunkInfo(uint32_t fourCC);
 	bool chunkExists(uint32_t fourCC, int32_t id);
 	std::shared_ptr<Chunk> getChunk(uint32_t fourCC, int32_t id);
@@ -84,20 +118,29 @@ public:
 	std::shared_ptr<Chunk> makeChunk(uint32_t fourCC, const Common::BufferView &view);
 
 	bool compressionImplemented(MoaID compressionID);
+	Common::BufferView compressedChunkData(const ChunkInfo &info);
+	bool decompresses(const ChunkInfo &info);
+	size_t decompressedLength(int32_t id);
+	void decompressChunk(int32_t id, uint8_t *dest, size_t destLen);
 
 	size_t size();
 	size_t chunkSize(int32_t id);
 
-	void writeToFile(const std::filesystem::path &path);
+	bool writeToFile(const std::filesystem::path &path);
+	bool canPatch() const;
+	bool patchFile(const std::filesystem::path &path);
+	void extractSounds(const std::filesystem::path &dir);
 	void generateInitialMap();
 	void generateMemoryMap();
-	void write(Common::WriteStream &stream);
-	void writeChunk(Common::WriteStream &stream, int32_t id);
+	void write(Common::OutputWriter &file);
+	void writeChunk(Common::OutputWriter &file, int32_t id);
 
 	void parseScripts();
 	void restoreScriptText();
 
+	std::string scriptTypeName(const CastMemberChunk *member) const;
 	void dumpScripts();
+	void writeScriptsJSON(Common::JSONWriter &json);
 	void dumpChunks();
 	void dumpJSON();
 
@@ -5,13 +5,13 @@
  */
 
 #include <algorithm>
-#include <iomanip>
+#include <cstdio>
 #include <iostream>
-#include <sstream>
 
 #include "common/codewriter.h"
 #include "common/json.h"
 #include "common/log.h"
+#include "common/profile.h"
 #include "common/stream.h"
 #include "common/util.h"
 #include "director/chunk.h"
@@ -66,36 +66,37 @@ void Handler::writeJSON(Common::JSONWriter &json) const {
 
 void Handler::readData(Common::ReadStream &stream) {
 	stream.seek(compiledOffset);
+	// Every instruction is at least one byte long. The length comes from the
+	// file, so don't reserve more than the stream could hold.
+	size_t available = (stream.size() > compiledOffset) ? stream.size() - compiledOffset : 0;
+	bytecodeArray.reserve(std::min<size_t>(compiledLen, available));
 	while (stream.pos() < compiledOffset + compiledLen) {
 		uint32_t pos = stream.pos() - compiledOffset;
 		uint8_t op = stream.readUint8();
-		OpCode opcode = static_cast<OpCode>(op >= 0x40 ? 0x40 + op % 0x40 : op);
+		OperandType operand = Lingo::opcodeInfo(op).operand;
 		// argument can be one, two or four bytes
 		int32_t obj = 0;
-		if (op >= 0xc0) {
-			// four bytes
+		switch (Lingo::operandWidth(op)) {
+		case 4:
 			obj = stream.readInt32();
-		} else if (op >= 0x80) {
-			// two bytes
-			if (opcode == kOpPushInt16 || opcode == kOpPushInt8) {
-				// treat pushint's arg as signed
-				// pushint8 may be used to push a 16-bit int in older Lingo
+			break;
+		case 2:
+			// pushint8 may be used to push a 16-bit int in older Lingo
+			if (operand == kOperandSigned || operand == kOperandSigned16) {
 				obj = stream.readInt16();
 			} else {
 				obj = stream.readUint16();
 			}
-		} else if (op >= 0x40) {
-			// one byte
-			if (opcode == kOpPushInt8) {
-				// treat pushint's arg as signed
+			break;
+		case 1:
+			if (operand == kOperandSigned) {
 				obj = stream.readInt8();
 			} else {
 				obj = stream.readUint8();
 			}
+			break;
 		}
-		Bytecode bytecode(op, obj, pos);
-		bytecodeArray.push_back(bytecode);
-		bytecodePosMap[pos] = bytecodeArray.size() - 1;
+		bytecodeArray.push(op, obj, pos);
 	}
 
 	argumentNameIDs = readVarnamesTable(stream, argumentCount, argumentOffset);
@@ -138,25 +139,29 @@ bool Handler::validName(int id) const {
 	return script->validName(id);
 }
 
-std::string Handler::getName(int id) const {
+std::string_view Handler::getName(int id) const {
 	return script->getName(id);
 }
 
-std::string Handler::getArgumentName(int id) const {
+bool Handler::nameIs(int id, int internedID) const {
+	return internedID != -1 && script->internedNameID(id) == internedID;
+}
+
+std::string_view Handler::getArgumentName(int id) {
 	if (-1 < id && (unsigned)id < argumentNameIDs.size())
 		return getName(argumentNameIDs[id]);
-	return "UNKNOWN_ARG_" + std::to_string(id);
+	return *arena.make<std::string>("UNKNOWN_ARG_" + std::to_string(id));
 }
 
-std::string Handler::getLocalName(int id) const {
+std::string_view Handler::getLocalName(int id) {
 	if (-1 < id && (unsigned)id < localNameIDs.size())
 		return getName(localNameIDs[id]);
-	return "UNKNOWN_LOCAL_" + std::to_string(id);
+	return *arena.make<std::string>("UNKNOWN_LOCAL_" + std::to_string(id));
 }
 
-std::shared_ptr<Node> Handler::pop() {
+Node *Handler::pop() {
 	if (stack.empty())
-		return std::make_shared<ErrorNode>();
+		return arena.make<ErrorNode>();
 
 	auto res = stack.back();
 	stack.pop_back();
@@ -173,11 +178,11 @@ int Handler::variableMultiplier() {
 	return 6;
 }
 
-std::shared_ptr<Node> Handler::readVar(int varType) {
-	std::shared_ptr<Node> castID;
+Node *Handler::readVar(int varType) {
+	Node *castID = nullptr;
 	if (varType == 0x6 && script->dir->version >= 500) // field cast ID
 		castID = pop();
-	std::shared_ptr<Node> id = pop();
+	Node *id = pop();
 
 	switch (varType) {
 	case 0x1: // global
@@ -186,40 +191,40 @@ std::shared_ptr<Node> Handler::readVar(int varType) {
 		return id;
 	case 0x4: // arg
 		{
-			std::string name = getArgumentName(id->getValue()->i / variableMultiplier());
-			auto ref = std::make_shared<Datum>(kDatumVarRef, name);
-			return std::make_shared<LiteralNode>(std::move(ref));
+			std::string_view name = getArgumentName(id->getValue()->i / variableMultiplier());
+			auto ref = arena.make<Datum>(kDatumVarRef, name);
+			return arena.make<LiteralNode>(ref);
 		}
 	case 0x5: // local
 		{
-			std::string name = getLocalName(id->getValue()->i / variableMultiplier());
-			auto ref = std::make_shared<Datum>(kDatumVarRef, name);
-			return std::make_shared<LiteralNode>(std::move(ref));
+			std::string_view name = getLocalName(id->getValue()->i / variableMultiplier());
+			auto ref = arena.make<Datum>(kDatumVarRef, name);
+			return arena.make<LiteralNode>(ref);
 		}
 	case 0x6: // field
-		return std::make_shared<MemberExprNode>("field", std::move(id), std::move(castID));
+		return arena.make<MemberExprNode>("field", id, castID);
 	default:
 		Common::warning(boost::format("findVar: unhandled var type %d") % varType);
 		break;
 	}
-	return std::make_shared<ErrorNode>();
+	return arena.make<ErrorNode>();
 }
 
-std::string Handler::getVarNameFromSet(const Bytecode &bytecode) {
-	std::string varName;
-	switch (bytecode.opcode) {
+std::string_view Handler::getVarNameFromSet(uint32_t index) {
+	std::string_view varName;
+	switch (bytecodeArray.opcode[index]) {
 	case kOpSetGlobal:
 	case kOpSetGlobal2:
-		varName = getName(bytecode.obj);
+		varName = getName(bytecodeArray.obj[index]);
 		break;
 	case kOpSetProp:
-		varName = getName(bytecode.obj);
+		varName = getName(bytecodeArray.obj[index]);
 		break;
 	case kOpSetParam:
-		varName = getArgumentName(bytecode.obj / variableMultiplier());
+		varName = getArgumentName(bytecodeArray.obj[index] / variableMultiplier());
 		break;
 	case kOpSetLocal:
-		varName = getLocalName(bytecode.obj / variableMultiplier());
+		varName = getLocalName(bytecodeArray.obj[index] / variableMultiplier());
 		break;
 	default:
 		varName = "ERROR";
@@ -228,64 +233,64 @@ std::string Handler::getVarNameFromSet(const Bytecode &bytecode) {
 	return varName;
 }
 
-std::shared_ptr<Node> Handler::readV4Property(int propertyType, int propertyID) {
+Node *Handler::readV4Property(int propertyType, int propertyID) {
 	switch (propertyType) {
 	case 0x00:
 		{
 			if (propertyID <= 0x0b) { // movie property
 				auto propName = Lingo::getName(Lingo::moviePropertyNames, propertyID);
-				return std::make_shared<TheExprNode>(propName);
+				return arena.make<TheExprNode>(propName);
 			} else { // last chunk
 				auto string = pop();
 				auto chunkType = static_cast<ChunkExprType>(propertyID - 0x0b);
-				return std::make_shared<LastStringChunkExprNode>(chunkType, std::move(string));
+				return arena.make<LastStringChunkExprNode>(chunkType, string);
 			}
 		}
 		break;
 	case 0x01: // number of chunks
 		{
 			auto string = pop();
-			return std::make_shared<StringChunkCountExprNode>(static_cast<ChunkExprType>(propertyID), std::move(string));
+			return arena.make<StringChunkCountExprNode>(static_cast<ChunkExprType>(propertyID), string);
 		}
 		break;
 	case 0x02: // menu property
 		{
 			auto menuID = pop();
-			return std::make_shared<MenuPropExprNode>(std::move(menuID), propertyID);
+			return arena.make<MenuPropExprNode>(menuID, propertyID);
 		}
 		break;
 	case 0x03: // menu item property
 		{
 			auto menuID = pop();
 			auto itemID = pop();
-			return std::make_shared<MenuItemPropExprNode>(std::move(menuID), std::move(itemID), propertyID);
+			return arena.make<MenuItemPropExprNode>(menuID, itemID, propertyID);
 		}
 		break;
 	case 0x04: // sound property
 		{
 			auto soundID = pop();
-			return std::make_shared<SoundPropExprNode>(std::move(soundID), propertyID);
+			return arena.make<SoundPropExprNode>(soundID, propertyID);
 		}
 		break;
 	case 0x05: // resource property - unused?
-		return std::make_shared<CommentNode>("ERROR: Resource property");
+		return arena.make<CommentNode>("ERROR: Resource property");
 	case 0x06: // sprite property
 		{
 			auto spriteID = pop();
-			return std::make_shared<SpritePropExprNode>(std::move(spriteID), propertyID);
+			return arena.make<SpritePropExprNode>(spriteID, propertyID);
 		}
 		break;
 	case 0x07: // animation property
-		return std::make_shared<TheExprNode>(Lingo::getName(Lingo::animationPropertyNames, propertyID));
+		return arena.make<TheExprNode>(Lingo::getName(Lingo::animationPropertyNames, propertyID));
 	case 0x08: // animation 2 property
 		if (propertyID == 0x02 && script->dir->version >= 500) { // the number of castMembers supports castLib selection from Director 5.0
 			auto castLib = pop();
 			if (!(castLib->type == kLiteralNode && castLib->getValue()->type == kDatumInt && castLib->getValue()->toInt() == 0)) {
-				auto castLibNode = std::make_shared<MemberExprNode>("castLib", castLib, nullptr);
-				return std::make_shared<ThePropExprNode>(castLibNode, Lingo::getName(Lingo::animation2PropertyNames, propertyID));
+				auto castLibNode = arena.make<MemberExprNode>("castLib", castLib, nullptr);
+				return arena.make<ThePropExprNode>(castLibNode, Lingo::getName(Lingo::animation2PropertyNames, propertyID));
 			}
 		}
-		return std::make_shared<TheExprNode>(Lingo::getName(Lingo::animation2PropertyNames, propertyID));
+		return arena.make<TheExprNode>(Lingo::getName(Lingo::animation2PropertyNames, propertyID));
 	case 0x09: // generic cast member
 	case 0x0a: // chunk of cast member
 	case 0x0b: // field
@@ -301,12 +306,12 @@ std::shared_ptr<Node> Handler::readV4Property(int propertyType, int propertyID)
 	case 0x15: // chunk of scriptText
 		{
 			auto propName = Lingo::getName(Lingo::memberPropertyNames, propertyID);
-			std::shared_ptr<Node> castID;
+			Node *castID = nullptr;
 			if (script->dir->version >= 500) {
 				castID = pop();
 			}
 			auto memberID = pop();
-			std::string prefix;
+			std::string_view prefix;
 			if (propertyType == 0x0b || propertyType == 0x0c) {
 				prefix = "field";
 			} else if (propertyType == 0x14 || propertyType == 0x15) {
@@ -314,23 +319,23 @@ std::shared_ptr<Node> Handler::readV4Property(int propertyType, int propertyID)
 			} else {
 				prefix = (script->dir->version >= 500) ? "member" : "cast";
 			}
-			auto member = std::make_shared<MemberExprNode>(prefix, std::move(memberID), std::move(castID));
-			std::shared_ptr<Node> entity;
+			auto member = arena.make<MemberExprNode>(prefix, memberID, castID);
+			Node *entity;
 			if (propertyType == 0x0a || propertyType == 0x0c || propertyType == 0x15) {
-				entity = readChunkRef(std::move(member));
+				entity = readChunkRef(member);
 			} else {
 				entity = member;
 			}
-			return std::make_shared<ThePropExprNode>(std::move(entity), propName);
+			return arena.make<ThePropExprNode>(entity, propName);
 		}
 		break;
 	default:
 		break;
 	}
-	return std::make_shared<CommentNode>("ERROR: Unknown property type " + std::to_string(propertyType));
+	return arena.make<CommentNode>("ERROR: Unknown property type " + std::to_string(propertyType));
 }
 
-std::shared_ptr<Node> Handler::readChunkRef(std::shared_ptr<Node> string) {
+Node *Handler::readChunkRef(Node *string) {
 	auto lastLine = pop();
 	auto firstLine = pop();
 	auto lastItem = pop();
@@ -341,13 +346,13 @@ std::shared_ptr<Node> Handler::readChunkRef(std::shared_ptr<Node> string) {
 	auto firstChar = pop();
 
 	if (!(firstLine->type == kLiteralNode && firstLine->getValue()->type == kDatumInt && firstLine->getValue()->toInt() == 0))
-		string = std::make_shared<ChunkExprNode>(kChunkLine, std::move(firstLine), std::move(lastLine), std::move(string));
+		string = arena.make<ChunkExprNode>(kChunkLine, firstLine, lastLine, string);
 	if (!(firstItem->type == kLiteralNode && firstItem->getValue()->type == kDatumInt && firstItem->getValue()->toInt() == 0))
-		string = std::make_shared<ChunkExprNode>(kChunkItem, std::move(firstItem), std::move(lastItem), std::move(string));
+		string = arena.make<ChunkExprNode>(kChunkItem, firstItem, lastItem, string);
 	if (!(firstWord->type == kLiteralNode && firstWord->getValue()->type == kDatumInt && firstWord->getValue()->toInt() == 0))
-		string = std::make_shared<ChunkExprNode>(kChunkWord, std::move(firstWord), std::move(lastWord), std::move(string));
+		string = arena.make<ChunkExprNode>(kChunkWord, firstWord, lastWord, string);
 	if (!(firstChar->type == kLiteralNode && firstChar->getValue()->type == kDatumInt && firstChar->getValue()->toInt() == 0))
-		string = std::make_shared<ChunkExprNode>(kChunkChar, std::move(firstChar), std::move(lastChar), std::move(string));
+		string = arena.make<ChunkExprNode>(kChunkChar, firstChar, lastChar, string);
 
 	return string;
 }
@@ -361,46 +366,48 @@ void Handler::tagLoops() {
 
 	for (uint32_t startIndex = 0; startIndex < bytecodeArray.size(); startIndex++) {
 		// All loops begin with jmpifz...
-		auto &jmpifz = bytecodeArray[startIndex];
-		if (jmpifz.opcode != kOpJmpIfZ)
+		if (bytecodeArray.opcode[startIndex] != kOpJmpIfZ)
 			continue;
 
 		// ...and end with endrepeat.
-		uint32_t jmpPos = jmpifz.pos + jmpifz.obj;
-		uint32_t endIndex = bytecodePosMap[jmpPos];
-		auto &endRepeat = bytecodeArray[endIndex - 1];
-		if (endRepeat.opcode != kOpEndRepeat || (endRepeat.pos - endRepeat.obj) > jmpifz.pos)
+		uint32_t jmpifzPos = bytecodeArray.pos[startIndex];
+		uint32_t endIndex = bytecodeArray.indexAt(jmpifzPos + bytecodeArray.obj[startIndex]);
+		if (endIndex == BytecodeArray::kNoIndex || endIndex == 0)
+			continue;
+		uint32_t endRepeatIndex = endIndex - 1;
+		uint32_t conditionPos = bytecodeArray.pos[endRepeatIndex] - bytecodeArray.obj[endRepeatIndex];
+		if (bytecodeArray.opcode[endRepeatIndex] != kOpEndRepeat || conditionPos > jmpifzPos)
 			continue;
 
 		BytecodeTag loopType = identifyLoop(startIndex, endIndex);
-		bytecodeArray[startIndex].tag = loopType;
+		bytecodeArray.tag[startIndex] = loopType;
 
 		if (loopType == kTagRepeatWithIn) {
 			for (uint32_t i = startIndex - 7, end = startIndex - 1; i <= end; i++)
-				bytecodeArray[i].tag = kTagSkip;
+				bytecodeArray.tag[i] = kTagSkip;
 			for (uint32_t i = startIndex + 1, end = startIndex + 5; i <= end; i++)
-				bytecodeArray[i].tag = kTagSkip;
-			bytecodeArray[endIndex - 3].tag = kTagNextRepeatTarget; // pushint8 1
-			bytecodeArray[endIndex - 3].ownerLoop = startIndex;
-			bytecodeArray[endIndex - 2].tag = kTagSkip; // add
-			bytecodeArray[endIndex - 1].tag = kTagSkip; // endrepeat
-			bytecodeArray[endIndex - 1].ownerLoop = startIndex;
-			bytecodeArray[endIndex].tag = kTagSkip; // pop 3
+				bytecodeArray.tag[i] = kTagSkip;
+			bytecodeArray.tag[endIndex - 3] = kTagNextRepeatTarget; // pushint8 1
+			bytecodeArray.ownerLoop[endIndex - 3] = startIndex;
+			bytecodeArray.tag[endIndex - 2] = kTagSkip; // add
+			bytecodeArray.tag[endIndex - 1] = kTagSkip; // endrepeat
+			bytecodeArray.ownerLoop[endIndex - 1] = startIndex;
+			bytecodeArray.tag[endIndex] = kTagSkip; // pop 3
 		} else if (loopType == kTagRepeatWithTo || loopType == kTagRepeatWithDownTo) {
-			uint32_t conditionStartIndex = bytecodePosMap[endRepeat.pos - endRepeat.obj];
-			bytecodeArray[conditionStartIndex - 1].tag = kTagSkip; // set
-			bytecodeArray[conditionStartIndex].tag = kTagSkip; // get
-			bytecodeArray[startIndex - 1].tag = kTagSkip; // lteq / gteq
-			bytecodeArray[endIndex - 5].tag = kTagNextRepeatTarget; // pushint8 1 / pushint8 -1
-			bytecodeArray[endIndex - 5].ownerLoop = startIndex;
-			bytecodeArray[endIndex - 4].tag = kTagSkip; // get
-			bytecodeArray[endIndex - 3].tag = kTagSkip; // add
-			bytecodeArray[endIndex - 2].tag = kTagSkip; // set
-			bytecodeArray[endIndex - 1].tag = kTagSkip; // endrepeat
-			bytecodeArray[endIndex - 1].ownerLoop = startIndex;
+			uint32_t conditionStartIndex = bytecodeArray.indexAt(conditionPos);
+			bytecodeArray.tag[conditionStartIndex - 1] = kTagSkip; // set
+			bytecodeArray.tag[conditionStartIndex] = kTagSkip; // get
+			bytecodeArray.tag[startIndex - 1] = kTagSkip; // lteq / gteq
+			bytecodeArray.tag[endIndex - 5] = kTagNextRepeatTarget; // pushint8 1 / pushint8 -1
+			bytecodeArray.ownerLoop[endIndex - 5] = startIndex;
+			bytecodeArray.tag[endIndex - 4] = kTagSkip; // get
+			bytecodeArray.tag[endIndex - 3] = kTagSkip; // add
+			bytecodeArray.tag[endIndex - 2] = kTagSkip; // set
+			bytecodeArray.tag[endIndex - 1] = kTagSkip; // endrepeat
+			bytecodeArray.ownerLoop[endIndex - 1] = startIndex;
 		} else if (loopType == kTagRepeatWhile) {
-			bytecodeArray[endIndex - 1].tag = kTagNextRepeatTarget; // endrepeat
-			bytecodeArray[endIndex - 1].ownerLoop = startIndex;
+			bytecodeArray.tag[endIndex - 1] = kTagNextRepeatTarget; // endrepeat
+			bytecodeArray.ownerLoop[endIndex - 1] = startIndex;
 		}
 	}
 }
@@ -408,43 +415,43 @@ void Handler::tagLoops() {
 bool Handler::isRepeatWithIn(uint32_t startIndex, uint32_t endIndex) {
 	if (startIndex < 7 || startIndex > bytecodeArray.size() - 6)
 		return false;
-	if (!(bytecodeArray[startIndex - 7].opcode == kOpPeek && bytecodeArray[startIndex - 7].obj == 0))
+	if (!(bytecodeArray.opcode[startIndex - 7] == kOpPeek && bytecodeArray.obj[startIndex - 7] == 0))
 		return false;
-	if (!(bytecodeArray[startIndex - 6].opcode == kOpPushArgList && bytecodeArray[startIndex - 6].obj == 1))
+	if (!(bytecodeArray.opcode[startIndex - 6] == kOpPushArgList && bytecodeArray.obj[startIndex - 6] == 1))
 		return false;
-	if (!(bytecodeArray[startIndex - 5].opcode == kOpExtCall && getName(bytecodeArray[startIndex - 5].obj) == "count"))
+	if (!(bytecodeArray.opcode[startIndex - 5] == kOpExtCall && nameIs(bytecodeArray.obj[startIndex - 5], script->countNameID)))
 		return false;
-	if (!(bytecodeArray[startIndex - 4].opcode == kOpPushInt8 && bytecodeArray[startIndex - 4].obj == 1))
+	if (!(bytecodeArray.opcode[startIndex - 4] == kOpPushInt8 && bytecodeArray.obj[startIndex - 4] == 1))
 		return false;
-	if (!(bytecodeArray[startIndex - 3].opcode == kOpPeek && bytecodeArray[startIndex - 3].obj == 0))
+	if (!(bytecodeArray.opcode[startIndex - 3] == kOpPeek && bytecodeArray.obj[startIndex - 3] == 0))
 		return false;
-	if (!(bytecodeArray[startIndex - 2].opcode == kOpPeek && bytecodeArray[startIndex - 2].obj == 2))
+	if (!(bytecodeArray.opcode[startIndex - 2] == kOpPeek && bytecodeArray.obj[startIndex - 2] == 2))
 		return false;
-	if (!(bytecodeArray[startIndex - 1].opcode == kOpLtEq))
+	if (!(bytecodeArray.opcode[startIndex - 1] == kOpLtEq))
 		return false;
-	// if (!(bytecodeArray[startIndex].opcode == kOpJmpIfZ))
+	// if (!(bytecodeArray.opcode[startIndex] == kOpJmpIfZ))
 	//     return false;
-	if (!(bytecodeArray[startIndex + 1].opcode == kOpPeek && bytecodeArray[startIndex + 1].obj == 2))
+	if (!(bytecodeArray.opcode[startIndex + 1] == kOpPeek && bytecodeArray.obj[startIndex + 1] == 2))
 		return false;
-	if (!(bytecodeArray[startIndex + 2].opcode == kOpPeek && bytecodeArray[startIndex + 2].obj == 1))
+	if (!(bytecodeArray.opcode[startIndex + 2] == kOpPeek && bytecodeArray.obj[startIndex + 2] == 1))
 		return false;
-	if (!(bytecodeArray[startIndex + 3].opcode == kOpPushArgList && bytecodeArray[startIndex + 3].obj == 2))
+	if (!(bytecodeArray.opcode[startIndex + 3] == kOpPushArgList && bytecodeArray.obj[startIndex + 3] == 2))
 		return false;
-	if (!(bytecodeArray[startIndex + 4].opcode == kOpExtCall && getName(bytecodeArray[startIndex + 4].obj) == "getAt"))
+	if (!(bytecodeArray.opcode[startIndex + 4] == kOpExtCall && nameIs(bytecodeArray.obj[startIndex + 4], script->getAtNameID)))
 		return false;
-	if (!(bytecodeArray[startIndex + 5].opcode == kOpSetGlobal || bytecodeArray[startIndex + 5].opcode == kOpSetProp
-			|| bytecodeArray[startIndex + 5].opcode == kOpSetParam || bytecodeArray[startIndex + 5].opcode == kOpSetLocal))
+	if (!(bytecodeArray.opcode[startIndex + 5] == kOpSetGlobal || bytecodeArray.opcode[startIndex + 5] == kOpSetProp
+			|| bytecodeArray.opcode[startIndex + 5] == kOpSetParam || bytecodeArray.opcode[startIndex + 5] == kOpSetLocal))
 		return false;
 
 	if (endIndex < 3)
 		return false;
-	if (!(bytecodeArray[endIndex - 3].opcode == kOpPushInt8 && bytecodeArray[endIndex - 3].obj == 1))
+	if (!(bytecodeArray.opcode[endIndex - 3] == kOpPushInt8 && bytecodeArray.obj[endIndex - 3] == 1))
 		return false;
-	if (!(bytecodeArray[endIndex - 2].opcode == kOpAdd))
+	if (!(bytecodeArray.opcode[endIndex - 2] == kOpAdd))
 		return false;
-	// if (!(bytecodeArray[startIndex - 1].opcode == kOpEndRepeat))
+	// if (!(bytecodeArray.opcode[startIndex - 1] == kOpEndRepeat))
 	//     return false;
-	if (!(bytecodeArray[endIndex].opcode == kOpPop && bytecodeArray[endIndex].obj == 3))
+	if (!(bytecodeArray.opcode[endIndex] == kOpPop && bytecodeArray.obj[endIndex] == 3))
 		return false;
 
 	return true;
@@ -458,7 +465,7 @@ BytecodeTag Handler::identifyLoop(uint32_t startIndex, uint32_t endIndex) {
 		return kTagRepeatWhile;
 
 	bool up;
-	switch (bytecodeArray[startIndex - 1].opcode) {
+	switch (bytecodeArray.opcode[startIndex - 1]) {
 	case kOpLtEq:
 		up = true;
 		break;
@@ -469,14 +476,14 @@ BytecodeTag Handler::identifyLoop(uint32_t startIndex, uint32_t endIndex) {
 		return kTagRepeatWhile;
 	}
 
-	auto &endRepeat = bytecodeArray[endIndex - 1];
-	uint32_t conditionStartIndex = bytecodePosMap[endRepeat.pos - endRepeat.obj];
+	uint32_t endRepeatIndex = endIndex - 1;
+	uint32_t conditionStartIndex = bytecodeArray.indexAt(bytecodeArray.pos[endRepeatIndex] - bytecodeArray.obj[endRepeatIndex]);
 
-	if (conditionStartIndex < 1)
+	if (conditionStartIndex == BytecodeArray::kNoIndex || conditionStartIndex < 1)
 		return kTagRepeatWhile;
 
 	OpCode getOp;
-	switch (bytecodeArray[conditionStartIndex - 1].opcode) {
+	switch (bytecodeArray.opcode[conditionStartIndex - 1]) {
 	case kOpSetGlobal:
 		getOp = kOpGetGlobal;
 		break;
@@ -495,26 +502,26 @@ BytecodeTag Handler::identifyLoop(uint32_t startIndex, uint32_t endIndex) {
 	default:
 		return kTagRepeatWhile;
 	}
-	OpCode setOp = bytecodeArray[conditionStartIndex - 1].opcode;
-	int32_t varID = bytecodeArray[conditionStartIndex - 1].obj;
+	OpCode setOp = bytecodeArray.opcode[conditionStartIndex - 1];
+	int32_t varID = bytecodeArray.obj[conditionStartIndex - 1];
 
-	if (!(bytecodeArray[conditionStartIndex].opcode == getOp && bytecodeArray[conditionStartIndex].obj == varID))
+	if (!(bytecodeArray.opcode[conditionStartIndex] == getOp && bytecodeArray.obj[conditionStartIndex] == varID))
 		return kTagRepeatWhile;
 
 	if (endIndex < 5)
 		return kTagRepeatWhile;
 	if (up) {
-		if (!(bytecodeArray[endIndex - 5].opcode == kOpPushInt8 && bytecodeArray[endIndex - 5].obj == 1))
+		if (!(bytecodeArray.opcode[endIndex - 5] == kOpPushInt8 && bytecodeArray.obj[endIndex - 5] == 1))
 			return kTagRepeatWhile;
 	} else {
-		if (!(bytecodeArray[endIndex - 5].opcode == kOpPushInt8 && bytecodeArray[endIndex - 5].obj == -1))
+		if (!(bytecodeArray.opcode[endIndex - 5] == kOpPushInt8 && bytecodeArray.obj[endIndex - 5] == -1))
 			return kTagRepeatWhile;
 	}
-	if (!(bytecodeArray[endIndex - 4].opcode == getOp && bytecodeArray[endIndex - 4].obj == varID))
+	if (!(bytecodeArray.opcode[endIndex - 4] == getOp && bytecodeArray.obj[endIndex - 4] == varID))
 		return kTagRepeatWhile;
-	if (!(bytecodeArray[endIndex - 3].opcode == kOpAdd))
+	if (!(bytecodeArray.opcode[endIndex - 3] == kOpAdd))
 		return kTagRepeatWhile;
-	if (!(bytecodeArray[endIndex - 2].opcode == setOp && bytecodeArray[endIndex - 2].obj == varID))
+	if (!(bytecodeArray.opcode[endIndex - 2] == setOp && bytecodeArray.obj[endIndex - 2] == varID))
 		return kTagRepeatWhile;
 
 	return up ? kTagRepeatWithTo : kTagRepeatWithDownTo;
@@ -523,11 +530,12 @@ BytecodeTag Handler::identifyLoop(uint32_t startIndex, uint32_t endIndex) {
 void Handler::parse() {
 	tagLoops();
 	stack.clear();
-	ast = std::make_unique<AST>(this);
+	ast.reset();
+	arena.clear();
+	ast = std::make_unique<AST>(arena, this);
 	uint32_t i = 0;
 	while (i < bytecodeArray.size()) {
-		auto &bytecode = bytecodeArray[i];
-		uint32_t pos = bytecode.pos;
+		uint32_t pos = bytecodeArray.pos[i];
 		// exit last block if at end
 		while (pos == ast->currentBlock->endPos) {
 			auto exitedBlock = ast->currentBlock;
@@ -536,8 +544,8 @@ void Handler::parse() {
 			if (ancestorStmt) {
 				if (ancestorStmt->type == kIfStmtNode) {
 					auto ifStatement = static_cast<IfStmtNode *>(ancestorStmt);
-					if (ifStatement->hasElse && exitedBlock == ifStatement->block1.get()) {
-						ast->enterBlock(ifStatement->block2.get());
+					if (ifStatement->hasElse && exitedBlock == ifStatement->block1) {
+						ast->enterBlock(ifStatement->block2);
 					}
 				} else if (ancestorStmt->type == kCaseStmtNode) {
 					auto caseStmt = static_cast<CaseStmtNode *>(ancestorStmt);
@@ -545,10 +553,12 @@ void Handler::parse() {
 					if (caseLabel) {
 						if (caseLabel->expect == kCaseExpectOtherwise) {
 							ast->currentBlock->currentCaseLabel = nullptr;
-							caseStmt->addOtherwise();
-							size_t otherwiseIndex = bytecodePosMap[caseStmt->potentialOtherwisePos];
-							bytecodeArray[otherwiseIndex].translation = caseStmt->otherwise;
-							ast->enterBlock(caseStmt->otherwise->block.get());
+							caseStmt->addOtherwise(arena);
+							uint32_t otherwiseIndex = bytecodeArray.indexAt(caseStmt->potentialOtherwisePos);
+							if (otherwiseIndex != BytecodeArray::kNoIndex) {
+								bytecodeArray.translation[otherwiseIndex] = caseStmt->otherwise;
+							}
+							ast->enterBlock(caseStmt->otherwise->block);
 						} else if (caseLabel->expect == kCaseExpectEnd) {
 							ast->currentBlock->currentCaseLabel = nullptr;
 						}
@@ -556,30 +566,33 @@ void Handler::parse() {
 				}
 			}
 		}
-		auto translateSize = translateBytecode(bytecode, i);
+		auto translateSize = translateBytecode(i);
 		i += translateSize;
 	}
+
+	Common::count(script->dir->profile, Common::kCounterHandlersParsed);
+	Common::count(script->dir->profile, Common::kCounterASTNodes, arena.objectCount());
 }
 
-uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
-	if (bytecode.tag == kTagSkip || bytecode.tag == kTagNextRepeatTarget) {
+uint32_t Handler::translateBytecode(uint32_t index) {
+	if (bytecodeArray.tag[index] == kTagSkip || bytecodeArray.tag[index] == kTagNextRepeatTarget) {
 		// This is internal loop logic. Skip it.
 		return 1;
 	}
 
-	std::shared_ptr<Node> translation = nullptr;
+	Node *translation = nullptr;
 	BlockNode *nextBlock = nullptr;
 
-	switch (bytecode.opcode) {
+	switch (bytecodeArray.opcode[index]) {
 	case kOpRet:
 	case kOpRetFactory:
 		if (index == bytecodeArray.size() - 1) {
 			return 1; // end of handler
 		}
-		translation = std::make_shared<ExitStmtNode>();
+		translation = arena.make<ExitStmtNode>();
 		break;
 	case kOpPushZero:
-		translation = std::make_shared<LiteralNode>(std::make_shared<Datum>(0));
+		translation = arena.make<LiteralNode>(arena.make<Datum>(0));
 		break;
 	case kOpMul:
 	case kOpAdd:
@@ -601,39 +614,39 @@ uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
 		{
 			auto b = pop();
 			auto a = pop();
-			translation = std::make_shared<BinaryOpNode>(bytecode.opcode, std::move(a), std::move(b));
+			translation = arena.make<BinaryOpNode>(bytecodeArray.opcode[index], a, b);
 		}
 		break;
 	case kOpInv:
 		{
 			auto x = pop();
-			translation = std::make_shared<InverseOpNode>(std::move(x));
+			translation = arena.make<InverseOpNode>(x);
 		}
 		break;
 	case kOpNot:
 		{
 			auto x = pop();
-			translation = std::make_shared<NotOpNode>(std::move(x));
+			translation = arena.make<NotOpNode>(x);
 		}
 		break;
 	case kOpGetChunk:
 		{
 			auto string = pop();
-			translation = readChunkRef(std::move(string));
+			translation = readChunkRef(string);
 		}
 		break;
 	case kOpHiliteChunk:
 		{
-			std::shared_ptr<Node> castID;
+			Node *castID = nullptr;
 			if (script->dir->version >= 500)
 				castID = pop();
 			auto fieldID = pop();
-			auto field = std::make_shared<MemberExprNode>("field", std::move(fieldID), std::move(castID));
-			auto chunk = readChunkRef(std::move(field));
+			auto field = arena.make<MemberExprNode>("field", fieldID, castID);
+			auto chunk = readChunkRef(field);
 			if (chunk->type == kCommentNode) { // error comment
 				translation = chunk;
 			} else {
-				translation = std::make_shared<ChunkHiliteStmtNode>(std::move(chunk));
+				translation = arena.make<ChunkHiliteStmtNode>(chunk);
 			}
 		}
 		break;
@@ -641,31 +654,31 @@ uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
 		{
 			auto secondSprite = pop();
 			auto firstSprite = pop();
-			translation = std::make_shared<SpriteIntersectsExprNode>(std::move(firstSprite), std::move(secondSprite));
+			translation = arena.make<SpriteIntersectsExprNode>(firstSprite, secondSprite);
 		}
 		break;
 	case kOpIntoSpr:
 		{
 			auto secondSprite = pop();
 			auto firstSprite = pop();
-			translation = std::make_shared<SpriteWithinExprNode>(std::move(firstSprite), std::move(secondSprite));
+			translation = arena.make<SpriteWithinExprNode>(firstSprite, secondSprite);
 		}
 		break;
 	case kOpGetField:
 		{
-			std::shared_ptr<Node> castID;
+			Node *castID = nullptr;
 			if (script->dir->version >= 500)
 				castID = pop();
 			auto fieldID = pop();
-			translation = std::make_shared<MemberExprNode>("field", std::move(fieldID), std::move(castID));
+			translation = arena.make<MemberExprNode>("field", fieldID, castID);
 		}
 		break;
 	case kOpStartTell:
 		{
 			auto window = pop();
-			auto tellStmt = std::make_shared<TellStmtNode>(std::move(window));
+			auto tellStmt = arena.make<TellStmtNode>(arena, window);
 			translation = tellStmt;
-			nextBlock = tellStmt->block.get();
+			nextBlock = tellStmt->block;
 		}
 		break;
 	case kOpEndTell:
@@ -677,14 +690,18 @@ uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
 	case kOpPushList:
 		{
 			auto list = pop();
-			list->getValue()->type = kDatumList;
+			if (list->type == kLiteralNode) {
+				list->getValue()->type = kDatumList;
+			}
 			translation = list;
 		}
 		break;
 	case kOpPushPropList:
 		{
 			auto list = pop();
-			list->getValue()->type = kDatumPropList;
+			if (list->type == kLiteralNode) {
+				list->getValue()->type = kDatumPropList;
+			}
 			translation = list;
 		}
 		break;
@@ -699,207 +716,208 @@ uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
 	case kOpPushInt16:
 	case kOpPushInt32:
 		{
-			auto i = std::make_shared<Datum>(bytecode.obj);
-			translation = std::make_shared<LiteralNode>(std::move(i));
+			auto i = arena.make<Datum>(bytecodeArray.obj[index]);
+			translation = arena.make<LiteralNode>(i);
 		}
 		break;
 	case kOpPushFloat32:
 		{
-			auto f = std::make_shared<Datum>(*(float *)(&bytecode.obj));
-			translation = std::make_shared<LiteralNode>(std::move(f));
+			auto f = arena.make<Datum>(*(float *)(&bytecodeArray.obj[index]));
+			translation = arena.make<LiteralNode>(f);
 		}
 		break;
 	case kOpPushArgListNoRet:
 		{
-			auto argCount = bytecode.obj;
-			std::vector<std::shared_ptr<Node>> args;
+			auto argCount = bytecodeArray.obj[index];
+			std::vector<Node *> args;
 			args.resize(argCount);
 			while (argCount) {
 				argCount--;
 				args[argCount] = pop();
 			}
-			auto argList = std::make_shared<Datum>(kDatumArgListNoRet, args);
-			translation = std::make_shared<LiteralNode>(std::move(argList));
+			auto argList = arena.make<Datum>(kDatumArgListNoRet, args);
+			translation = arena.make<LiteralNode>(argList);
 		}
 		break;
 	case kOpPushArgList:
 		{
-			auto argCount = bytecode.obj;
-			std::vector<std::shared_ptr<Node>> args;
+			auto argCount = bytecodeArray.obj[index];
+			std::vector<Node *> args;
 			args.resize(argCount);
 			while (argCount) {
 				argCount--;
 				args[argCount] = pop();
 			}
-			auto argList = std::make_shared<Datum>(kDatumArgList, args);
-			translation = std::make_shared<LiteralNode>(std::move(argList));
+			auto argList = arena.make<Datum>(kDatumArgList, args);
+			translation = arena.make<LiteralNode>(argList);
 		}
 		break;
 	case kOpPushCons:
 		{
-			int literalID = bytecode.obj / variableMultiplier();
+			int literalID = bytecodeArray.obj[index] / variableMultiplier();
 			if (-1 < literalID && (unsigned)literalID < script->literals.size()) {
-				translation = std::make_shared<LiteralNode>(script->literals[literalID].value);
+				translation = arena.make<LiteralNode>(script->literals[literalID].value.get());
 			} else {
-				translation = std::make_shared<ErrorNode>();
+				translation = arena.make<ErrorNode>();
 			}
 			break;
 		}
 	case kOpPushSymb:
 		{
-			auto sym = std::make_shared<Datum>(kDatumSymbol, getName(bytecode.obj));
-			translation = std::make_shared<LiteralNode>(std::move(sym));
+			auto sym = arena.make<Datum>(kDatumSymbol, getName(bytecodeArray.obj[index]));
+			translation = arena.make<LiteralNode>(sym);
 		}
 		break;
 	case kOpPushVarRef:
 		{
-			auto ref = std::make_shared<Datum>(kDatumVarRef, getName(bytecode.obj));
-			translation = std::make_shared<LiteralNode>(std::move(ref));
+			auto ref = arena.make<Datum>(kDatumVarRef, getName(bytecodeArray.obj[index]));
+			translation = arena.make<LiteralNode>(ref);
 		}
 		break;
 	case kOpGetGlobal:
 	case kOpGetGlobal2:
 		{
-			auto name = getName(bytecode.obj);
-			translation = std::make_shared<VarNode>(name);
+			auto name = getName(bytecodeArray.obj[index]);
+			translation = arena.make<VarNode>(name);
 		}
 		break;
 	case kOpGetProp:
-		translation = std::make_shared<VarNode>(getName(bytecode.obj));
+		translation = arena.make<VarNode>(getName(bytecodeArray.obj[index]));
 		break;
 	case kOpGetParam:
-		translation = std::make_shared<VarNode>(getArgumentName(bytecode.obj / variableMultiplier()));
+		translation = arena.make<VarNode>(getArgumentName(bytecodeArray.obj[index] / variableMultiplier()));
 		break;
 	case kOpGetLocal:
-		translation = std::make_shared<VarNode>(getLocalName(bytecode.obj / variableMultiplier()));
+		translation = arena.make<VarNode>(getLocalName(bytecodeArray.obj[index] / variableMultiplier()));
 		break;
 	case kOpSetGlobal:
 	case kOpSetGlobal2:
 		{
-			auto varName = getName(bytecode.obj);
-			auto var = std::make_shared<VarNode>(varName);
+			auto varName = getName(bytecodeArray.obj[index]);
+			auto var = arena.make<VarNode>(varName);
 			auto value = pop();
-			translation = std::make_shared<AssignmentStmtNode>(std::move(var), std::move(value));
+			translation = arena.make<AssignmentStmtNode>(var, value);
 		}
 		break;
 	case kOpSetProp:
 		{
-			auto var = std::make_shared<VarNode>(getName(bytecode.obj));
+			auto var = arena.make<VarNode>(getName(bytecodeArray.obj[index]));
 			auto value = pop();
-			translation = std::make_shared<AssignmentStmtNode>(std::move(var), std::move(value));
+			translation = arena.make<AssignmentStmtNode>(var, value);
 		}
 		break;
 	case kOpSetParam:
 		{
-			auto var = std::make_shared<VarNode>(getArgumentName(bytecode.obj / variableMultiplier()));
+			auto var = arena.make<VarNode>(getArgumentName(bytecodeArray.obj[index] / variableMultiplier()));
 			auto value = pop();
-			translation = std::make_shared<AssignmentStmtNode>(std::move(var), std::move(value));
+			translation = arena.make<AssignmentStmtNode>(var, value);
 		}
 		break;
 	case kOpSetLocal:
 		{
-			auto var = std::make_shared<VarNode>(getLocalName(bytecode.obj / variableMultiplier()));
+			auto var = arena.make<VarNode>(getLocalName(bytecodeArray.obj[index] / variableMultiplier()));
 			auto value = pop();
-			translation = std::make_shared<AssignmentStmtNode>(std::move(var), std::move(value));
+			translation = arena.make<AssignmentStmtNode>(var, value);
 		}
 		break;
 	case kOpJmp:
 		{
-			uint32_t targetPos = bytecode.pos + bytecode.obj;
-			size_t targetIndex = bytecodePosMap[targetPos];
-			auto &targetBytecode = bytecodeArray[targetIndex];
+			uint32_t targetPos = bytecodeArray.pos[index] + bytecodeArray.obj[index];
+			uint32_t targetIndex = bytecodeArray.indexAt(targetPos);
+			bool hasTarget = (targetIndex != BytecodeArray::kNoIndex && targetIndex > 0);
 			auto ancestorLoop = ast->currentBlock->ancestorLoop();
-			if (ancestorLoop) {
-				if (bytecodeArray[targetIndex - 1].opcode == kOpEndRepeat && bytecodeArray[targetIndex - 1].ownerLoop == ancestorLoop->startIndex) {
-					translation = std::make_shared<ExitRepeatStmtNode>();
+			if (ancestorLoop && hasTarget) {
+				if (bytecodeArray.opcode[targetIndex - 1] == kOpEndRepeat && bytecodeArray.ownerLoop[targetIndex - 1] == ancestorLoop->startIndex) {
+					translation = arena.make<ExitRepeatStmtNode>();
 					break;
-				} else if (bytecodeArray[targetIndex].tag == kTagNextRepeatTarget && bytecodeArray[targetIndex].ownerLoop == ancestorLoop->startIndex) {
-					translation = std::make_shared<NextRepeatStmtNode>();
+				} else if (bytecodeArray.tag[targetIndex] == kTagNextRepeatTarget && bytecodeArray.ownerLoop[targetIndex] == ancestorLoop->startIndex) {
+					translation = arena.make<NextRepeatStmtNode>();
 					break;
 				}
 			}
-			auto &nextBytecode = bytecodeArray[index + 1];
 			auto ancestorStatement = ast->currentBlock->ancestorStatement();
-			if (ancestorStatement && nextBytecode.pos == ast->currentBlock->endPos) {
+			if (ancestorStatement && bytecodeArray.pos[index + 1] == ast->currentBlock->endPos) {
 				if (ancestorStatement->type == kIfStmtNode) {
 					auto ifStmt = static_cast<IfStmtNode *>(ancestorStatement);
-					if (ast->currentBlock == ifStmt->block1.get()) {
+					if (ast->currentBlock == ifStmt->block1) {
 						ifStmt->hasElse = true;
 						ifStmt->block2->endPos = targetPos;
 						return 1; // if statement amended, nothing to push
 					}
 				} else if (ancestorStatement->type == kCaseStmtNode) {
 					auto caseStmt = static_cast<CaseStmtNode *>(ancestorStatement);
-					caseStmt->potentialOtherwisePos = bytecode.pos;
+					caseStmt->potentialOtherwisePos = bytecodeArray.pos[index];
 					caseStmt->endPos = targetPos;
-					targetBytecode.tag = kTagEndCase;
+					if (hasTarget) {
+						bytecodeArray.tag[targetIndex] = kTagEndCase;
+					}
 					return 1;
 				}
 			}
-			if (targetBytecode.opcode == kOpPop && targetBytecode.obj == 1) {
+			if (hasTarget && bytecodeArray.opcode[targetIndex] == kOpPop && bytecodeArray.obj[targetIndex] == 1) {
 				// This is a case statement starting with 'otherwise'
 				auto value = pop();
-				auto caseStmt = std::make_shared<CaseStmtNode>(std::move(value));
+				auto caseStmt = arena.make<CaseStmtNode>(value);
 				caseStmt->endPos = targetPos;
-				targetBytecode.tag = kTagEndCase;
-				caseStmt->addOtherwise();
+				bytecodeArray.tag[targetIndex] = kTagEndCase;
+				caseStmt->addOtherwise(arena);
 				translation = caseStmt;
-				nextBlock = caseStmt->otherwise->block.get();
+				nextBlock = caseStmt->otherwise->block;
 				break;
 			}
-			translation = std::make_shared<CommentNode>("ERROR: Could not identify jmp");
+			translation = arena.make<CommentNode>("ERROR: Could not identify jmp");
 		}
 		break;
 	case kOpEndRepeat:
 		// This should normally be tagged kTagSkip or kTagNextRepeatTarget and skipped.
-		translation = std::make_shared<CommentNode>("ERROR: Stray endrepeat");
+		translation = arena.make<CommentNode>("ERROR: Stray endrepeat");
 		break;
 	case kOpJmpIfZ:
 		{
-			uint32_t endPos = bytecode.pos + bytecode.obj;
-			uint32_t endIndex = bytecodePosMap[endPos];
-			switch (bytecode.tag) {
+			uint32_t endPos = bytecodeArray.pos[index] + bytecodeArray.obj[index];
+			switch (bytecodeArray.tag[index]) {
 			case kTagRepeatWhile:
 				{
 					auto condition = pop();
-					auto loop = std::make_shared<RepeatWhileStmtNode>(index, std::move(condition));
+					auto loop = arena.make<RepeatWhileStmtNode>(arena, index, condition);
 					loop->block->endPos = endPos;
 					translation = loop;
-					nextBlock = loop->block.get();
+					nextBlock = loop->block;
 				}
 				break;
 			case kTagRepeatWithIn:
 				{
 					auto list = pop();
-					std::string varName = getVarNameFromSet(bytecodeArray[index + 5]);
-					auto loop = std::make_shared<RepeatWithInStmtNode>(index, varName, std::move(list));
+					std::string_view varName = getVarNameFromSet(index + 5);
+					auto loop = arena.make<RepeatWithInStmtNode>(arena, index, varName, list);
 					loop->block->endPos = endPos;
 					translation = loop;
-					nextBlock = loop->block.get();
+					nextBlock = loop->block;
 				}
 				break;
 			case kTagRepeatWithTo:
 			case kTagRepeatWithDownTo:
 				{
-					bool up = (bytecode.tag == kTagRepeatWithTo);
+					bool up = (bytecodeArray.tag[index] == kTagRepeatWithTo);
 					auto end = pop();
 					auto start = pop();
-					auto endRepeat = bytecodeArray[endIndex - 1];
-					uint32_t conditionStartIndex = bytecodePosMap[endRepeat.pos - endRepeat.obj];
-					std::string varName = getVarNameFromSet(bytecodeArray[conditionStartIndex - 1]);
-					auto loop = std::make_shared<RepeatWithToStmtNode>(index, varName, std::move(start), up, std::move(end));
+					// tagLoops has already checked that these exist.
+					uint32_t endRepeatIndex = bytecodeArray.indexAt(endPos) - 1;
+					uint32_t conditionStartIndex = bytecodeArray.indexAt(bytecodeArray.pos[endRepeatIndex] - bytecodeArray.obj[endRepeatIndex]);
+					std::string_view varName = getVarNameFromSet(conditionStartIndex - 1);
+					auto loop = arena.make<RepeatWithToStmtNode>(arena, index, varName, start, up, end);
 					loop->block->endPos = endPos;
 					translation = loop;
-					nextBlock = loop->block.get();
+					nextBlock = loop->block;
 				}
 				break;
 			default:
 				{
 					auto condition = pop();
-					auto ifStmt = std::make_shared<IfStmtNode>(std::move(condition));
+					auto ifStmt = arena.make<IfStmtNode>(arena, condition);
 					ifStmt->block1->endPos = endPos;
 					translation = ifStmt;
-					nextBlock = ifStmt->block1.get();
+					nextBlock = ifStmt->block1;
 				}
 				break;
 			}
@@ -908,125 +926,125 @@ uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
 	case kOpLocalCall:
 		{
 			auto argList = pop();
-			translation = std::make_shared<CallNode>(script->handlers[bytecode.obj]->name, std::move(argList));
+			translation = arena.make<CallNode>(script->handlers[bytecodeArray.obj[index]]->name, argList);
 		}
 		break;
 	case kOpExtCall:
 	case kOpTellCall:
 		{
-			std::string name = getName(bytecode.obj);
+			std::string_view name = getName(bytecodeArray.obj[index]);
 			auto argList = pop();
 			bool isStatement = (argList->getValue()->type == kDatumArgListNoRet);
 			auto &rawArgList = argList->getValue()->l;
 			size_t nargs = rawArgList.size();
 			if (isStatement && name == "sound" && nargs > 0 && rawArgList[0]->type == kLiteralNode && rawArgList[0]->getValue()->type == kDatumSymbol) {
-				std::string cmd = rawArgList[0]->getValue()->s;
+				std::string_view cmd = rawArgList[0]->getValue()->s;
 				rawArgList.erase(rawArgList.begin());
-				translation = std::make_shared<SoundCmdStmtNode>(cmd, std::move(argList));
+				translation = arena.make<SoundCmdStmtNode>(cmd, argList);
 			} else {
-				translation = std::make_shared<CallNode>(name, std::move(argList));
+				translation = arena.make<CallNode>(name, argList);
 			}
 		}
 		break;
 	case kOpObjCallV4:
 		{
-			auto object = readVar(bytecode.obj);
+			auto object = readVar(bytecodeArray.obj[index]);
 			auto argList = pop();
 			auto &rawArgList = argList->getValue()->l;
 			if (rawArgList.size() > 0) {
 				// first arg is a symbol
 				// replace it with a variable
-				rawArgList[0] = std::make_shared<VarNode>(rawArgList[0]->getValue()->s);
+				rawArgList[0] = arena.make<VarNode>(rawArgList[0]->getValue()->s);
 			}
-			translation = std::make_shared<ObjCallV4Node>(std::move(object), std::move(argList));
+			translation = arena.make<ObjCallV4Node>(object, argList);
 		}
 		break;
 	case kOpPut:
 		{
-			PutType putType = static_cast<PutType>((bytecode.obj >> 4) & 0xF);
-			uint32_t varType = bytecode.obj & 0xF;
+			PutType putType = static_cast<PutType>((bytecodeArray.obj[index] >> 4) & 0xF);
+			uint32_t varType = bytecodeArray.obj[index] & 0xF;
 			auto var = readVar(varType);
 			auto val = pop();
-			translation = std::make_shared<PutStmtNode>(putType, std::move(var), std::move(val));
+			translation = arena.make<PutStmtNode>(putType, var, val);
 		}
 		break;
 	case kOpPutChunk:
 		{
-			PutType putType = static_cast<PutType>((bytecode.obj >> 4) & 0xF);
-			uint32_t varType = bytecode.obj & 0xF;
+			PutType putType = static_cast<PutType>((bytecodeArray.obj[index] >> 4) & 0xF);
+			uint32_t varType = bytecodeArray.obj[index] & 0xF;
 			auto var = readVar(varType);
-			auto chunk = readChunkRef(std::move(var));
+			auto chunk = readChunkRef(var);
 			auto val = pop();
 			if (chunk->type == kCommentNode) { // error comment
 				translation = chunk;
 			} else {
-				translation = std::make_shared<PutStmtNode>(putType, std::move(chunk), std::move(val));
+				translation = arena.make<PutStmtNode>(putType, chunk, val);
 			}
 		}
 		break;
 	case kOpDeleteChunk:
 		{
-			auto var = readVar(bytecode.obj);
-			auto chunk = readChunkRef(std::move(var));
+			auto var = readVar(bytecodeArray.obj[index]);
+			auto chunk = readChunkRef(var);
 			if (chunk->type == kCommentNode) { // error comment
 				translation = chunk;
 			} else {
-				translation = std::make_shared<ChunkDeleteStmtNode>(std::move(chunk));
+				translation = arena.make<ChunkDeleteStmtNode>(chunk);
 			}
 		}
 		break;
 	case kOpGet:
 		{
 			int propertyID = pop()->getValue()->toInt();
-			translation = readV4Property(bytecode.obj, propertyID);
+			translation = readV4Property(bytecodeArray.obj[index], propertyID);
 		}
 		break;
 	case kOpSet:
 		{
 			int propertyID = pop()->getValue()->toInt();
 			auto value = pop();
-			if (bytecode.obj == 0x00 && 0x01 <= propertyID && propertyID <= 0x05 && value->getValue()->type == kDatumString) {
+			if (bytecodeArray.obj[index] == 0x00 && 0x01 <= propertyID && propertyID <= 0x05 && value->getValue()->type == kDatumString) {
 				// This is either a `set eventScript to "script"` or `when event then script` statement.
 				// If the script starts with a space, it's probably a when statement.
 				// If the script contains a line break, it's definitely a when statement.
-				std::string script = value->getValue()->s;
+				std::string_view script = value->getValue()->s;
 				if (script.size() > 0 && (script[0] == ' ' || script.find('\r') != std::string::npos)) {
-					translation = std::make_shared<WhenStmtNode>(propertyID, script);
+					translation = arena.make<WhenStmtNode>(propertyID, script);
 				}
 			}
 			if (!translation) {
-				auto prop = readV4Property(bytecode.obj, propertyID);
+				auto prop = readV4Property(bytecodeArray.obj[index], propertyID);
 				if (prop->type == kCommentNode) { // error comment
 					translation = prop;
 				} else {
-					translation = std::make_shared<AssignmentStmtNode>(std::move(prop), std::move(value), true);
+					translation = arena.make<AssignmentStmtNode>(prop, value, true);
 				}
 			}
 		}
 		break;
 	case kOpGetMovieProp:
-		translation = std::make_shared<TheExprNode>(getName(bytecode.obj));
+		translation = arena.make<TheExprNode>(getName(bytecodeArray.obj[index]));
 		break;
 	case kOpSetMovieProp:
 		{
 			auto value = pop();
-			auto prop = std::make_shared<TheExprNode>(getName(bytecode.obj));
-			translation = std::make_shared<AssignmentStmtNode>(std::move(prop), std::move(value));
+			auto prop = arena.make<TheExprNode>(getName(bytecodeArray.obj[index]));
+			translation = arena.make<AssignmentStmtNode>(prop, value);
 		}
 		break;
 	case kOpGetObjProp:
 	case kOpGetChainedProp:
 		{
 			auto object = pop();
-			translation = std::make_shared<ObjPropExprNode>(std::move(object), getName(bytecode.obj));
+			translation = arena.make<ObjPropExprNode>(object, getName(bytecodeArray.obj[index]));
 		}
 		break;
 	case kOpSetObjProp:
 		{
 			auto value = pop();
 			auto object = pop();
-			auto prop = std::make_shared<ObjPropExprNode>(std::move(object), getName(bytecode.obj));
-			translation = std::make_shared<AssignmentStmtNode>(std::move(prop), std::move(value));
+			auto prop = arena.make<ObjPropExprNode>(object, getName(bytecodeArray.obj[index]));
+			translation = arena.make<AssignmentStmtNode>(prop, value);
 		}
 		break;
 	case kOpPeek:
@@ -1041,62 +1059,60 @@ uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
 			// This must be a case. Find the comparison against the switch expression.
 			auto originalStackSize = stack.size();
 			uint32_t currIndex = index + 1;
-			Bytecode *currBytecode = &bytecodeArray[currIndex];
 			do {
-				translateBytecode(*currBytecode, currIndex);
+				translateBytecode(currIndex);
 				currIndex += 1;
-				currBytecode = &bytecodeArray[currIndex];
 			} while (
 				currIndex < bytecodeArray.size()
-				&& !(stack.size() == originalStackSize + 1 && (currBytecode->opcode == kOpEq || currBytecode->opcode == kOpNtEq))
+				&& !(stack.size() == originalStackSize + 1 && (bytecodeArray.opcode[currIndex] == kOpEq || bytecodeArray.opcode[currIndex] == kOpNtEq))
 			);
 			if (currIndex >= bytecodeArray.size()) {
-				bytecode.translation = std::make_shared<CommentNode>("ERROR: Expected eq or nteq!");
-				ast->addStatement(bytecode.translation);
+				bytecodeArray.translation[index] = arena.make<CommentNode>("ERROR: Expected eq or nteq!");
+				ast->addStatement(bytecodeArray.translation[index]);
 				return currIndex - index + 1;
 			}
 
 			// If the comparison is <>, this is followed by another, equivalent case.
 			// (e.g. this could be case1 in `case1, case2: statement`)
-			bool notEq = (currBytecode->opcode == kOpNtEq);
-			std::shared_ptr<Node> caseValue = pop(); // This is the value the switch expression is compared against.
+			bool notEq = (bytecodeArray.opcode[currIndex] == kOpNtEq);
+			Node *caseValue = pop(); // This is the value the switch expression is compared against.
 
 			currIndex += 1;
-			currBytecode = &bytecodeArray[currIndex];
-			if (currIndex >= bytecodeArray.size() || currBytecode->opcode != kOpJmpIfZ) {
-				bytecode.translation = std::make_shared<CommentNode>("ERROR: Expected jmpifz!");
-				ast->addStatement(bytecode.translation);
+			if (currIndex >= bytecodeArray.size() || bytecodeArray.opcode[currIndex] != kOpJmpIfZ) {
+				bytecodeArray.translation[index] = arena.make<CommentNode>("ERROR: Expected jmpifz!");
+				ast->addStatement(bytecodeArray.translation[index]);
 				return currIndex - index + 1;
 			}
 
-			auto &jmpifz = *currBytecode;
-			auto jmpPos = jmpifz.pos + jmpifz.obj;
-			size_t targetIndex = bytecodePosMap[jmpPos];
-			auto &targetBytecode = bytecodeArray[targetIndex];
-			auto &prevFromTarget = bytecodeArray[targetIndex - 1];
+			uint32_t jmpifzIndex = currIndex;
+			uint32_t jmpPos = bytecodeArray.pos[jmpifzIndex] + bytecodeArray.obj[jmpifzIndex];
+			uint32_t targetIndex = bytecodeArray.indexAt(jmpPos);
+			bool hasTarget = (targetIndex != BytecodeArray::kNoIndex && targetIndex > 0);
+			uint32_t prevIndex = targetIndex - 1;
 			CaseExpect expect;
 			if (notEq) {
 				expect = kCaseExpectOr; // Expect an equivalent case after this one.
-			} else if (targetBytecode.opcode == kOpPeek) {
+			} else if (hasTarget && bytecodeArray.opcode[targetIndex] == kOpPeek) {
 				expect = kCaseExpectNext; // Expect a different case after this one.
-			} else if (targetBytecode.opcode == kOpPop
-					&& targetBytecode.obj == 1
-					&& (prevFromTarget.opcode != kOpJmp || prevFromTarget.pos + prevFromTarget.obj == targetBytecode.pos)) {
+			} else if (hasTarget
+					&& bytecodeArray.opcode[targetIndex] == kOpPop
+					&& bytecodeArray.obj[targetIndex] == 1
+					&& (bytecodeArray.opcode[prevIndex] != kOpJmp || bytecodeArray.pos[prevIndex] + bytecodeArray.obj[prevIndex] == jmpPos)) {
 				expect = kCaseExpectEnd; // Expect the end of the switch statement.
 			} else {
 				expect = kCaseExpectOtherwise; // Expect an 'otherwise' block.
 			}
 
-			auto currLabel = std::make_shared<CaseLabelNode>(std::move(caseValue), expect);
-			jmpifz.translation = currLabel;
-			ast->currentBlock->currentCaseLabel = currLabel.get();
+			auto currLabel = arena.make<CaseLabelNode>(caseValue, expect);
+			bytecodeArray.translation[jmpifzIndex] = currLabel;
+			ast->currentBlock->currentCaseLabel = currLabel;
 
 			if (!prevLabel) {
 				auto peekedValue = pop();
-				auto caseStmt = std::make_shared<CaseStmtNode>(std::move(peekedValue));
+				auto caseStmt = arena.make<CaseStmtNode>(peekedValue);
 				caseStmt->firstLabel = currLabel;
-				currLabel->parent = caseStmt.get();
-				bytecode.translation = caseStmt;
+				currLabel->parent = caseStmt;
+				bytecodeArray.translation[index] = caseStmt;
 				ast->addStatement(caseStmt);
 			} else if (prevLabel->expect == kCaseExpectOr) {
 				prevLabel->nextOr = currLabel;
@@ -1109,10 +1125,10 @@ uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
 			// The block doesn't start until the after last equivalent case,
 			// so don't create a block yet if we're expecting an equivalent case.
 			if (currLabel->expect != kCaseExpectOr) {
-				currLabel->block = std::make_shared<BlockNode>();
-				currLabel->block->parent = currLabel.get();
+				currLabel->block = arena.make<BlockNode>();
+				currLabel->block->parent = currLabel;
 				currLabel->block->endPos = jmpPos;
-				ast->enterBlock(currLabel->block.get());
+				ast->enterBlock(currLabel->block);
 			}
 
 			return currIndex - index + 1;
@@ -1121,17 +1137,17 @@ uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
 	case kOpPop:
 		{
 			// Pop instructions in 'repeat with in' loops are tagged kTagSkip and skipped.
-			if (bytecode.tag == kTagEndCase) {
+			if (bytecodeArray.tag[index] == kTagEndCase) {
 				// We've already recognized this as the end of a case statement.
 				// Attach an 'end case' node for the summary only.
-				bytecode.translation = std::make_shared<EndCaseNode>();
+				bytecodeArray.translation[index] = arena.make<EndCaseNode>();
 				return 1;
 			}
-			if (bytecode.obj == 1 && stack.size() == 1) {
+			if (bytecodeArray.obj[index] == 1 && stack.size() == 1) {
 				// We have an unused value on the stack, so this must be the end
 				// of a case statement with no labels.
 				auto value = pop();
-				translation = std::make_shared<CaseStmtNode>(std::move(value));
+				translation = arena.make<CaseStmtNode>(value);
 				break;
 			}
 			// Otherwise, this pop instruction occurs before a 'return' within
@@ -1142,12 +1158,12 @@ uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
 	case kOpTheBuiltin:
 		{
 			pop(); // empty arglist
-			translation = std::make_shared<TheExprNode>(getName(bytecode.obj));
+			translation = arena.make<TheExprNode>(getName(bytecodeArray.obj[index]));
 		}
 		break;
 	case kOpObjCall:
 		{
-			std::string method = getName(bytecode.obj);
+			std::string_view method = getName(bytecodeArray.obj[index]);
 			auto argList = pop();
 			auto &rawArgList = argList->getValue()->l;
 			size_t nargs = rawArgList.size();
@@ -1155,38 +1171,38 @@ uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
 				// obj.getAt(i) => obj[i]
 				auto obj = rawArgList[0];
 				auto prop = rawArgList[1];
-				translation = std::make_shared<ObjBracketExprNode>(std::move(obj), std::move(prop));
+				translation = arena.make<ObjBracketExprNode>(obj, prop);
 			} else if (method == "setAt" && nargs == 3) {
 				// obj.setAt(i) => obj[i] = val
 				auto obj = rawArgList[0];
 				auto prop = rawArgList[1];
 				auto val = rawArgList[2];
-				std::shared_ptr<Node> propExpr = std::make_shared<ObjBracketExprNode>(std::move(obj), std::move(prop));
-				translation = std::make_shared<AssignmentStmtNode>(std::move(propExpr), std::move(val));
+				Node *propExpr = arena.make<ObjBracketExprNode>(obj, prop);
+				translation = arena.make<AssignmentStmtNode>(propExpr, val);
 			} else if ((method == "getProp" || method == "getPropRef") && (nargs == 3 || nargs == 4) && rawArgList[1]->getValue()->type == kDatumSymbol) {
 				// obj.getProp(#prop, i) => obj.prop[i]
 				// obj.getProp(#prop, i, i2) => obj.prop[i..i2]
 				auto obj = rawArgList[0];
-				std::string propName  = rawArgList[1]->getValue()->s;
+				std::string_view propName = rawArgList[1]->getValue()->s;
 				auto i = rawArgList[2];
 				auto i2 = (nargs == 4) ? rawArgList[3] : nullptr;
-				translation = std::make_shared<ObjPropIndexExprNode>(std::move(obj), propName, std::move(i), std::move(i2));
+				translation = arena.make<ObjPropIndexExprNode>(obj, propName, i, i2);
 			} else if (method == "setProp" && (nargs == 4 || nargs == 5) && rawArgList[1]->getValue()->type == kDatumSymbol) {
 				// obj.setProp(#prop, i, val) => obj.prop[i] = val
 				// obj.setProp(#prop, i, i2, val) => obj.prop[i..i2] = val
 				auto obj = rawArgList[0];
-				std::string propName  = rawArgList[1]->getValue()->s;
+				std::string_view propName = rawArgList[1]->getValue()->s;
 				auto i = rawArgList[2];
 				auto i2 = (nargs == 5) ? rawArgList[3] : nullptr;
-				auto propExpr = std::make_shared<ObjPropIndexExprNode>(std::move(obj), propName, std::move(i), std::move(i2));
+				auto propExpr = arena.make<ObjPropIndexExprNode>(obj, propName, i, i2);
 				auto val = rawArgList[nargs - 1];
-				translation = std::make_shared<AssignmentStmtNode>(std::move(propExpr), std::move(val));
+				translation = arena.make<AssignmentStmtNode>(propExpr, val);
 			} else if (method == "count" && nargs == 2 && rawArgList[1]->getValue()->type == kDatumSymbol) {
 				// obj.count(#prop) => obj.prop.count
 				auto obj = rawArgList[0];
-				std::string propName  = rawArgList[1]->getValue()->s;
-				auto propExpr = std::make_shared<ObjPropExprNode>(std::move(obj), propName);
-				translation = std::make_shared<ObjPropExprNode>(std::move(propExpr), "count");
+				std::string_view propName = rawArgList[1]->getValue()->s;
+				auto propExpr = arena.make<ObjPropExprNode>(obj, propName);
+				translation = arena.make<ObjPropExprNode>(propExpr, "count");
 			} else if ((method == "setContents" || method == "setContentsAfter" || method == "setContentsBefore") && nargs == 2) {
 				// var.setContents(val) => put val into var
 				// var.setContentsAfter(val) => put val after var
@@ -1201,54 +1217,54 @@ uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
 				}
 				auto var = rawArgList[0];
 				auto val = rawArgList[1];
-				translation = std::make_shared<PutStmtNode>(putType, std::move(var), std::move(val));
+				translation = arena.make<PutStmtNode>(putType, var, val);
 			} else if (method == "hilite" && nargs == 1) {
 				// chunk.hilite() => hilite chunk
 				auto chunk = rawArgList[0];
-				translation = std::make_shared<ChunkHiliteStmtNode>(chunk);
+				translation = arena.make<ChunkHiliteStmtNode>(chunk);
 			} else if (method == "delete" && nargs == 1) {
 				// chunk.delete() => delete chunk
 				auto chunk = rawArgList[0];
-				translation = std::make_shared<ChunkDeleteStmtNode>(chunk);
+				translation = arena.make<ChunkDeleteStmtNode>(chunk);
 			} else {
-				translation = std::make_shared<ObjCallNode>(method, std::move(argList));
+				translation = arena.make<ObjCallNode>(method, argList);
 			}
 		}
 		break;
 	case kOpPushChunkVarRef:
-		translation = readVar(bytecode.obj);
+		translation = readVar(bytecodeArray.obj[index]);
 		break;
 	case kOpGetTopLevelProp:
 		{
-			auto name = getName(bytecode.obj);
-			translation = std::make_shared<VarNode>(name);
+			auto name = getName(bytecodeArray.obj[index]);
+			translation = arena.make<VarNode>(name);
 		}
 		break;
 	case kOpNewObj:
 		{
-			auto objType = getName(bytecode.obj);
+			auto objType = getName(bytecodeArray.obj[index]);
 			auto objArgs = pop();
-			translation = std::make_shared<NewObjNode>(objType, std::move(objArgs));
+			translation = arena.make<NewObjNode>(objType, objArgs);
 		}
 		break;
 	default:
 		{
-			auto commentText = Lingo::getOpcodeName(bytecode.opID);
-			if (bytecode.opcode >= 0x40)
-				commentText += " " + std::to_string(bytecode.obj);
-			translation = std::make_shared<CommentNode>(commentText);
+			auto commentText = Lingo::getOpcodeName(bytecodeArray.opID[index]);
+			if (bytecodeArray.opcode[index] >= 0x40)
+				commentText += " " + std::to_string(bytecodeArray.obj[index]);
+			translation = arena.make<CommentNode>(commentText);
 			stack.clear(); // Clear stack so later bytecode won't be too screwed up
 		}
 	}
 
 	if (!translation)
-		translation = std::make_shared<ErrorNode>();
+		translation = arena.make<ErrorNode>();
 
-	bytecode.translation = translation;
+	bytecodeArray.translation[index] = translation;
 	if (translation->isExpression) {
-		stack.push_back(std::move(translation));
+		stack.push_back(translation);
 	} else {
-		ast->addStatement(std::move(translation));
+		ast->addStatement(translation);
 	}
 
 	if (nextBlock)
@@ -1257,10 +1273,10 @@ uint32_t Handler::translateBytecode(Bytecode &bytecode, uint32_t index) {
 	return 1;
 }
 
-std::string posToString(int32_t pos) {
-	std::stringstream ss;
-	ss << "[" << std::setfill(' ') << std::setw(3) << pos << "]";
-	return ss.str();
+static void writePos(Common::CodeWriter &code, int32_t pos) {
+	char str[16];
+	int len = snprintf(str, sizeof(str), "[%3d]", pos);
+	code.write(std::string_view(str, len));
 }
 
 void Handler::writeBytecodeText(Common::CodeWriter &code) {
@@ -1285,42 +1301,50 @@ void Handler::writeBytecodeText(Common::CodeWriter &code) {
 		code.writeLine();
 		code.indent();
 	}
-	for (auto &bytecode : bytecodeArray) {
-		code.write(posToString(bytecode.pos));
+	for (size_t i = 0; i < bytecodeArray.size(); i++) {
+		uint8_t opID = bytecodeArray.opID[i];
+		int32_t obj = bytecodeArray.obj[i];
+		uint32_t pos = bytecodeArray.pos[i];
+		Node *translation = bytecodeArray.translation[i];
+		writePos(code, pos);
 		code.write(" ");
-		code.write(Lingo::getOpcodeName(bytecode.opID));
-		switch (bytecode.opcode) {
-		case kOpJmp:
-		case kOpJmpIfZ:
+		const OpcodeInfo &info = Lingo::opcodeInfo(opID);
+		if (!info.name.empty()) {
+			code.write(info.name);
+		} else {
+			code.write(Lingo::getOpcodeName(opID));
+		}
+		switch (info.operand) {
+		case kOperandJumpForward:
 			code.write(" ");
-			code.write(posToString(bytecode.pos + bytecode.obj));
+			writePos(code, pos + obj);
 			break;
-		case kOpEndRepeat:
+		case kOperandJumpBackward:
 			code.write(" ");
-			code.write(posToString(bytecode.pos - bytecode.obj));
+			writePos(code, pos - obj);
 			break;
-		case kOpPushFloat32:
+		case kOperandFloat:
 			code.write(" ");
-			code.write(Common::floatToString(*(float *)(&bytecode.obj)));
+			code.write(Common::floatToString(*(float *)(&obj)));
 			break;
 		default:
-			if (bytecode.opID > 0x40) {
+			if (opID > 0x40) {
 				code.write(" ");
-				code.write(std::to_string(bytecode.obj));
+				code.write(obj);
 			}
 			break;
 		}
-		if (bytecode.translation) {
+		if (translation) {
 			code.write(" ...");
 			while (code.lineWidth() < 49) {
 				code.write(".");
 			}
 			code.write(" ");
-			if (bytecode.translation->isExpression) {
+			if (translation->isExpression) {
 				code.write("<");
 			}
-			bytecode.translation->writeScriptText(code, dotSyntax, true);
-			if (bytecode.translation->isExpression) {
+			translation->writeScriptText(code, dotSyntax, true);
+			if (translation->isExpression) {
 				code.write(">");
 			}
 		}
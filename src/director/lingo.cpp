@@ -4,6 +4,8 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
+
 #include "common/codewriter.h"
 #include "common/json.h"
 #include "common/util.h"
@@ -15,293 +17,40 @@ namespace Director {
 
 /* Lingo */
 
-std::map<unsigned int, std::string> Lingo::opcodeNames = {
-	// single-byte
-	{ kOpRet,				"ret" },
-	{ kOpRetFactory,		"retfactory" },
-	{ kOpPushZero,			"pushzero" },
-	{ kOpMul,				"mul" },
-	{ kOpAdd,				"add" },
-	{ kOpSub,				"sub" },
-	{ kOpDiv,				"div" },
-	{ kOpMod,				"mod" },
-	{ kOpInv,				"inv" },
-	{ kOpJoinStr,			"joinstr" },
-	{ kOpJoinPadStr,		"joinpadstr" },
-	{ kOpLt,				"lt" },
-	{ kOpLtEq,				"lteq" },
-	{ kOpNtEq,				"nteq" },
-	{ kOpEq,				"eq" },
-	{ kOpGt,				"gt" },
-	{ kOpGtEq,				"gteq" },
-	{ kOpAnd,				"and" },
-	{ kOpOr,				"or" },
-	{ kOpNot,				"not" },
-	{ kOpContainsStr,		"containsstr" },
-	{ kOpContains0Str,		"contains0str" },
-	{ kOpGetChunk,			"getchunk" },
-	{ kOpHiliteChunk,		"hilitechunk" },
-	{ kOpOntoSpr,			"ontospr" },
-	{ kOpIntoSpr,			"intospr" },
-	{ kOpGetField,			"getfield" },
-	{ kOpStartTell,			"starttell" },
-	{ kOpEndTell,			"endtell" },
-	{ kOpPushList,			"pushlist" },
-	{ kOpPushPropList,		"pushproplist" },
-	{ kOpSwap,				"swap" },
-
-	// multi-byte
-	{ kOpPushInt8,			"pushint8" },
-	{ kOpPushArgListNoRet,	"pusharglistnoret" },
-	{ kOpPushArgList,		"pusharglist" },
-	{ kOpPushCons,			"pushcons" },
-	{ kOpPushSymb,			"pushsymb" },
-	{ kOpPushVarRef,		"pushvarref" },
-	{ kOpGetGlobal2,		"getglobal2" },
-	{ kOpGetGlobal,			"getglobal" },
-	{ kOpGetProp,			"getprop" },
-	{ kOpGetParam,			"getparam" },
-	{ kOpGetLocal,			"getlocal" },
-	{ kOpSetGlobal2,		"setglobal2" },
-	{ kOpSetGlobal,			"setglobal" },
-	{ kOpSetProp,			"setprop" },
-	{ kOpSetParam,			"setparam" },
-	{ kOpSetLocal,			"setlocal" },
-	{ kOpJmp,				"jmp" },
-	{ kOpEndRepeat,			"endrepeat" },
-	{ kOpJmpIfZ,			"jmpifz" },
-	{ kOpLocalCall,			"localcall" },
-	{ kOpExtCall,			"extcall" },
-	{ kOpObjCallV4,			"objcallv4" },
-	{ kOpPut,				"put" },
-	{ kOpPutChunk,			"putchunk" },
-	{ kOpDeleteChunk,		"deletechunk" },
-	{ kOpGet,				"get" },
-	{ kOpSet,				"set" },
-	{ kOpGetMovieProp,		"getmovieprop" },
-	{ kOpSetMovieProp,		"setmovieprop" },
-	{ kOpGetObjProp,		"getobjprop" },
-	{ kOpSetObjProp,		"setobjprop" },
-	{ kOpTellCall,			"tellcall" },
-	{ kOpPeek,				"peek" },
-	{ kOpPop,				"pop" },
-	{ kOpTheBuiltin,		"thebuiltin" },
-	{ kOpObjCall,			"objcall" },
-	{ kOpPushChunkVarRef,	"pushchunkvarref" },
-	{ kOpPushInt16,			"pushint16" },
-	{ kOpPushInt32,			"pushint32" },
-	{ kOpGetChainedProp,	"getchainedprop" },
-	{ kOpPushFloat32,		"pushfloat32" },
-	{ kOpGetTopLevelProp,	"gettoplevelprop" },
-	{ kOpNewObj,			"newobj" }
-};
-
-std::map<unsigned int, std::string> Lingo::binaryOpNames = {
-	{ kOpMul,			"*" },
-	{ kOpAdd,			"+" },
-	{ kOpSub,			"-" },
-	{ kOpDiv,			"/" },
-	{ kOpMod,			"mod" },
-	{ kOpJoinStr,		"&" },
-	{ kOpJoinPadStr,	"&&" },
-	{ kOpLt,			"<" },
-	{ kOpLtEq,			"<=" },
-	{ kOpNtEq,			"<>" },
-	{ kOpEq,			"=" },
-	{ kOpGt,			">" },
-	{ kOpGtEq,			">=" },
-	{ kOpAnd,			"and" },
-	{ kOpOr,			"or" },
-	{ kOpContainsStr,	"contains" },
-	{ kOpContains0Str,	"starts" }
-};
-
-std::map<unsigned int, std::string> Lingo::chunkTypeNames = {
-	{ kChunkChar, "char" },
-	{ kChunkWord, "word" },
-	{ kChunkItem, "item" },
-	{ kChunkLine, "line" }
-};
-
-std::map<unsigned int, std::string> Lingo::putTypeNames = {
-	{ kPutInto,		"into" },
-	{ kPutAfter,	"after" },
-	{ kPutBefore,	"before" }
-};
-
-std::map<unsigned int, std::string> Lingo::moviePropertyNames = {
-	{ 0x00, "floatPrecision" },
-	{ 0x01, "mouseDownScript" },
-	{ 0x02, "mouseUpScript" },
-	{ 0x03, "keyDownScript" },
-	{ 0x04, "keyUpScript" },
-	{ 0x05, "timeoutScript" },
-	{ 0x06, "short time" },
-	{ 0x07, "abbr time" },
-	{ 0x08, "long time" },
-	{ 0x09, "short date" },
-	{ 0x0a, "abbr date" },
-	{ 0x0b, "long date" }
-};
-
-std::map<unsigned int, std::string> Lingo::whenEventNames = {
-	{ 0x01, "mouseDown" },
-	{ 0x02, "mouseUp" },
-	{ 0x03, "keyDown" },
-	{ 0x04, "keyUp" },
-	{ 0x05, "timeOut" },
-};
-
-std::map<unsigned int, std::string> Lingo::menuPropertyNames = {
-	{ 0x01, "name" },
-	{ 0x02, "number of menuItems" }
-};
-
-std::map<unsigned int, std::string> Lingo::menuItemPropertyNames = {
-	{ 0x01, "name" },
-	{ 0x02, "checkMark" },
-	{ 0x03, "enabled" },
-	{ 0x04, "script" }
-};
-
-std::map<unsigned int, std::string> Lingo::soundPropertyNames = {
-	{ 0x01, "volume" }
-};
-
-std::map<unsigned int, std::string> Lingo::spritePropertyNames = {
-	{ 0x01, "type" },
-	{ 0x02, "backColor" },
-	{ 0x03, "bottom" },
-	{ 0x04, "castNum" },
-	{ 0x05, "constraint" },
-	{ 0x06, "cursor" },
-	{ 0x07, "foreColor" },
-	{ 0x08, "height" },
-	{ 0x09, "immediate" },
-	{ 0x0a, "ink" },
-	{ 0x0b, "left" },
-	{ 0x0c, "lineSize" },
-	{ 0x0d, "locH" },
-	{ 0x0e, "locV" },
-	{ 0x0f, "movieRate" },
-	{ 0x10, "movieTime" },
-	{ 0x11, "pattern" },
-	{ 0x12, "puppet" },
-	{ 0x13, "right" },
-	{ 0x14, "startTime" },
-	{ 0x15, "stopTime" },
-	{ 0x16, "stretch" },
-	{ 0x17, "top" },
-	{ 0x18, "trails" },
-	{ 0x19, "visible" },
-	{ 0x1a, "volume" },
-	{ 0x1b, "width" },
-	{ 0x1c, "blend" },
-	{ 0x1d, "scriptNum" },
-	{ 0x1e, "moveableSprite" },
-	{ 0x1f, "editableText" },
-	{ 0x20, "scoreColor" },
-	{ 0x21, "loc" },
-	{ 0x22, "rect" },
-	{ 0x23, "memberNum" },
-	{ 0x24, "castLibNum" },
-	{ 0x25, "member" },
-	{ 0x26, "scriptInstanceList" },
-	{ 0x27, "currentTime" },
-	{ 0x28, "mostRecentCuePoint" },
-	{ 0x29, "tweened" },
-	{ 0x2a, "name" }
-};
-
-std::map<unsigned int, std::string> Lingo::animationPropertyNames = {
-	{ 0x01, "beepOn" },
-	{ 0x02, "buttonStyle" },
-	{ 0x03, "centerStage" },
-	{ 0x04, "checkBoxAccess" },
-	{ 0x05, "checkboxType" },
-	{ 0x06, "colorDepth" },
-	{ 0x07, "colorQD" },
-	{ 0x08, "exitLock" },
-	{ 0x09, "fixStageSize" },
-	{ 0x0a, "fullColorPermit" },
-	{ 0x0b, "imageDirect" },
-	{ 0x0c, "doubleClick" },
-	{ 0x0d, "key" },
-	{ 0x0e, "lastClick" },
-	{ 0x0f, "lastEvent" },
-	{ 0x10, "keyCode" },
-	{ 0x11, "lastKey" },
-	{ 0x12, "lastRoll"},
-	{ 0x13, "timeoutLapsed" },
-	{ 0x14, "multiSound" },
-	{ 0x15, "pauseState" },
-	{ 0x16, "quickTimePresent" },
-	{ 0x17, "selEnd" },
-	{ 0x18, "selStart" },
-	{ 0x19, "soundEnabled" },
-	{ 0x1a, "soundLevel" },
-	{ 0x1b, "stageColor" },
-	// 0x1c indicates dontPassEvent was called.
-	// It doesn't seem to have a Lingo-accessible name.
-	{ 0x1d, "switchColorDepth" },
-	{ 0x1e, "timeoutKeyDown" },
-	{ 0x1f, "timeoutLength" },
-	{ 0x20, "timeoutMouse" },
-	{ 0x21, "timeoutPlay" },
-	{ 0x22, "timer" },
-	{ 0x23, "preLoadRAM" },
-	{ 0x24, "videoForWindowsPresent" },
-	{ 0x25, "netPresent" },
-	{ 0x26, "safePlayer" },
-	{ 0x27, "soundKeepDevice" },
-	{ 0x28, "soundMixMedia" }
-};
-
-std::map<unsigned int, std::string> Lingo::animation2PropertyNames = {
-	{ 0x01, "perFrameHook" },
-	{ 0x02, "number of castMembers" },
-	{ 0x03, "number of menus" },
-	{ 0x04, "number of castLibs" },
-	{ 0x05, "number of xtras" }
-};
-
-std::map<unsigned int, std::string> Lingo::memberPropertyNames = {
-	{ 0x01, "name" },
-	{ 0x02, "text" },
-	{ 0x03, "textStyle" },
-	{ 0x04, "textFont" },
-	{ 0x05, "textHeight" },
-	{ 0x06, "textAlign" },
-	{ 0x07, "textSize" },
-	{ 0x08, "picture" },
-	{ 0x09, "hilite" },
-	{ 0x0a, "number" },
-	{ 0x0b, "size" },
-	{ 0x0c, "loop" },
-	{ 0x0d, "duration" },
-	{ 0x0e, "controller" },
-	{ 0x0f, "directToStage" },
-	{ 0x10, "sound" },
-	{ 0x11, "foreColor" },
-	{ 0x12, "backColor" },
-	{ 0x13, "type" }
-};
-
 std::string Lingo::getOpcodeName(uint8_t id) {
-	if (id >= 0x40)
-		id = 0x40 + id % 0x40;
-	auto it = opcodeNames.find(id);
-	if (it == opcodeNames.end()){
+	id = normalizeOpcode(id);
+	if (opcodes[id].name.empty())
 		return "unk" + Common::byteToString(id);
-	}
-	return it->second;
+	return std::string(opcodes[id].name);
+}
+
+/* BytecodeArray */
+
+void BytecodeArray::reserve(size_t count) {
+	opID.reserve(count);
+	opcode.reserve(count);
+	obj.reserve(count);
+	pos.reserve(count);
+	tag.reserve(count);
+	ownerLoop.reserve(count);
+	translation.reserve(count);
+}
+
+void BytecodeArray::push(uint8_t op, int32_t o, uint32_t p) {
+	opID.push_back(op);
+	opcode.push_back(Lingo::normalizeOpcode(op));
+	obj.push_back(o);
+	pos.push_back(p);
+	tag.push_back(kTagNone);
+	ownerLoop.push_back(UINT32_MAX);
+	translation.push_back(nullptr);
 }
 
-std::string Lingo::getName(const std::map<unsigned int, std::string> &nameMap, unsigned int id) {
-	auto it = nameMap.find(id);
-	if (it == nameMap.end())
-		return "ERROR";
-	return it->second;
+uint32_t BytecodeArray::indexAt(uint32_t p) const {
+	auto it = std::lower_bound(pos.begin(), pos.end(), p);
+	if (it == pos.end() || *it != p)
+		return kNoIndex;
+	return it - pos.begin();
 }
 
 /* Datum */
@@ -324,7 +73,8 @@ void Datum::writeScriptText(Common::CodeWriter &code, bool dot, bool sum) const
 		code.write("VOID");
 		return;
 	case kDatumSymbol:
-		code.write("#" + s);
+		code.write('#');
+		code.write(s);
 		return;
 	case kDatumVarRef:
 		code.write(s);
@@ -356,13 +106,17 @@ void Datum::writeScriptText(Common::CodeWriter &code, bool dot, bool sum) const
 			}
 		}
 		if (sum) {
-			code.write("\"" + Common::escapeString(s) + "\"");
+			code.write('"');
+			code.write(Common::escapeString(s));
+			code.write('"');
 			return;
 		}
-		code.write("\"" + s + "\"");
+		code.write('"');
+		code.write(s);
+		code.write('"');
 		return;
 	case kDatumInt:
-		code.write(std::to_string(i));
+		code.write(i);
 		return;
 	case kDatumFloat:
 		code.write(Common::floatToString(f));
@@ -425,7 +179,7 @@ void AST::writeScriptText(Common::CodeWriter &code, bool dot, bool sum) const {
 	root->writeScriptText(code, dot, sum);
 }
 
-void AST::addStatement(std::shared_ptr<Node> statement) {
+void AST::addStatement(Node *statement) {
 	currentBlock->addChild(std::move(statement));
 }
 
@@ -451,8 +205,10 @@ void AST::exitBlock() {
 
 /* Node */
 
-std::shared_ptr<Datum> Node::getValue() {
-	return std::make_shared<Datum>();
+Datum *Node::getValue() {
+	// Only literals have a value. Callers must not modify this one.
+	static Datum voidDatum;
+	return &voidDatum;
 }
 
 Node *Node::ancestorStatement() {
@@ -498,7 +254,7 @@ void LiteralNode::writeScriptText(Common::CodeWriter &code, bool dot, bool sum)
 	value->writeScriptText(code, dot, sum);
 }
 
-std::shared_ptr<Datum> LiteralNode::getValue() {
+Datum *LiteralNode::getValue() {
 	return value;
 }
 
@@ -515,7 +271,7 @@ void BlockNode::writeScriptText(Common::CodeWriter &code, bool dot, bool sum) co
 	}
 }
 
-void BlockNode::addChild(std::shared_ptr<Node> child) {
+void BlockNode::addChild(Node *child) {
 	child->parent = this;
 	children.push_back(std::move(child));
 }
@@ -614,7 +370,7 @@ void BinaryOpNode::writeScriptText(Common::CodeWriter &code, bool dot, bool sum)
 	bool parenRight = false;
 	if (precedence) {
 		if (left->type == kBinaryOpNode) {
-			auto leftBinaryOpNode = static_cast<BinaryOpNode *>(left.get());
+			auto leftBinaryOpNode = static_cast<BinaryOpNode *>(left);
 			parenLeft = (leftBinaryOpNode->getPrecedence() != precedence);
 		}
 		parenRight = (right->type == kBinaryOpNode);
@@ -900,7 +656,7 @@ void CaseLabelNode::writeScriptText(Common::CodeWriter &code, bool dot, bool sum
 		code.write("(case) ");
 		if (parent->type == kCaseLabelNode) {
 			auto parentLabel = static_cast<CaseLabelNode *>(parent);
-			if (parentLabel->nextOr.get() == this) {
+			if (parentLabel->nextOr == this) {
 				code.write("..., ");
 			}
 		}
@@ -991,8 +747,8 @@ void CaseStmtNode::writeScriptText(Common::CodeWriter &code, bool dot, bool sum)
 	}
 }
 
-void CaseStmtNode::addOtherwise() {
-	otherwise = std::make_shared<OtherwiseNode>();
+void CaseStmtNode::addOtherwise(Common::Arena &arena) {
+	otherwise = arena.make<OtherwiseNode>(arena);
 	otherwise->parent = this;
 	otherwise->block->endPos = endPos;
 }
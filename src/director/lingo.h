@@ -7,11 +7,15 @@
 #ifndef DIRECTOR_LINGO_H
 #define DIRECTOR_LINGO_H
 
-#include <map>
+#include <array>
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "common/arena.h"
+
 namespace Common {
 class CodeWriter;
 class JSONWriter;
@@ -21,7 +25,6 @@ class ReadStream;
 namespace Director {
 
 struct AST;
-struct Bytecode;
 struct CaseLabelNode;
 struct LoopNode;
 struct Node;
@@ -225,24 +228,358 @@ enum ScriptFlag {
 
 /* Lingo */
 
+// How an opcode's operand is read and written out. Its width isn't part of
+// this; that's given by the opcode byte itself.
+enum OperandType {
+	kOperandUnsigned,
+	kOperandSigned,
+	kOperandSigned16,		// only sign-extended in its two-byte form
+	kOperandJumpForward,
+	kOperandJumpBackward,
+	kOperandFloat
+};
+
+struct OpcodeInfo {
+	std::string_view name;
+	OperandType operand = kOperandUnsigned;
+};
+
+struct OpcodeEntry {
+	OpCode opcode;
+	std::string_view name;
+	OperandType operand = kOperandUnsigned;
+};
+
+struct NameEntry {
+	unsigned int id;
+	std::string_view name;
+};
+
+// The tables below are written as lists of entries and spread out into
+// arrays indexed by ID at compile time, so a lookup is a bounds check and a
+// load and nothing has to be built at startup.
+template <size_t Size, size_t Count>
+constexpr std::array<OpcodeInfo, Size> makeOpcodeTable(const OpcodeEntry (&entries)[Count]) {
+	std::array<OpcodeInfo, Size> table{};
+	for (const auto &entry : entries) {
+		table[entry.opcode] = { entry.name, entry.operand };
+	}
+	return table;
+}
+
+template <size_t Size, size_t Count>
+constexpr std::array<std::string_view, Size> makeNameTable(const NameEntry (&entries)[Count]) {
+	std::array<std::string_view, Size> table{};
+	for (const auto &entry : entries) {
+		table[entry.id] = entry.name;
+	}
+	return table;
+}
+
 struct Lingo {
-	static std::map<unsigned int, std::string> opcodeNames;
-	static std::map<unsigned int, std::string> binaryOpNames;
-	static std::map<unsigned int, std::string> chunkTypeNames;
-	static std::map<unsigned int, std::string> putTypeNames;
-	static std::map<unsigned int, std::string> moviePropertyNames;
-	static std::map<unsigned int, std::string> whenEventNames;
-	static std::map<unsigned int, std::string> timeNames;
-	static std::map<unsigned int, std::string> menuPropertyNames;
-	static std::map<unsigned int, std::string> menuItemPropertyNames;
-	static std::map<unsigned int, std::string> soundPropertyNames;
-	static std::map<unsigned int, std::string> spritePropertyNames;
-	static std::map<unsigned int, std::string> animationPropertyNames;
-	static std::map<unsigned int, std::string> animation2PropertyNames;
-	static std::map<unsigned int, std::string> memberPropertyNames;
+	// Multi-byte opcodes are 0x40 plus the opcode, plus 0x40 for each size
+	// up of the operand, so every opcode falls below 0x80 once the operand
+	// size is taken out.
+	static constexpr size_t kOpcodeCount = 0x80;
+
+	static constexpr std::array<OpcodeInfo, kOpcodeCount> opcodes = makeOpcodeTable<kOpcodeCount>({
+		// single-byte
+		{ kOpRet,				"ret" },
+		{ kOpRetFactory,		"retfactory" },
+		{ kOpPushZero,			"pushzero" },
+		{ kOpMul,				"mul" },
+		{ kOpAdd,				"add" },
+		{ kOpSub,				"sub" },
+		{ kOpDiv,				"div" },
+		{ kOpMod,				"mod" },
+		{ kOpInv,				"inv" },
+		{ kOpJoinStr,			"joinstr" },
+		{ kOpJoinPadStr,		"joinpadstr" },
+		{ kOpLt,				"lt" },
+		{ kOpLtEq,				"lteq" },
+		{ kOpNtEq,				"nteq" },
+		{ kOpEq,				"eq" },
+		{ kOpGt,				"gt" },
+		{ kOpGtEq,				"gteq" },
+		{ kOpAnd,				"and" },
+		{ kOpOr,				"or" },
+		{ kOpNot,				"not" },
+		{ kOpContainsStr,		"containsstr" },
+		{ kOpContains0Str,		"contains0str" },
+		{ kOpGetChunk,			"getchunk" },
+		{ kOpHiliteChunk,		"hilitechunk" },
+		{ kOpOntoSpr,			"ontospr" },
+		{ kOpIntoSpr,			"intospr" },
+		{ kOpGetField,			"getfield" },
+		{ kOpStartTell,			"starttell" },
+		{ kOpEndTell,			"endtell" },
+		{ kOpPushList,			"pushlist" },
+		{ kOpPushPropList,		"pushproplist" },
+		{ kOpSwap,				"swap" },
+
+		// multi-byte
+		{ kOpPushInt8,			"pushint8", kOperandSigned },
+		{ kOpPushArgListNoRet,	"pusharglistnoret" },
+		{ kOpPushArgList,		"pusharglist" },
+		{ kOpPushCons,			"pushcons" },
+		{ kOpPushSymb,			"pushsymb" },
+		{ kOpPushVarRef,		"pushvarref" },
+		{ kOpGetGlobal2,		"getglobal2" },
+		{ kOpGetGlobal,			"getglobal" },
+		{ kOpGetProp,			"getprop" },
+		{ kOpGetParam,			"getparam" },
+		{ kOpGetLocal,			"getlocal" },
+		{ kOpSetGlobal2,		"setglobal2" },
+		{ kOpSetGlobal,			"setglobal" },
+		{ kOpSetProp,			"setprop" },
+		{ kOpSetParam,			"setparam" },
+		{ kOpSetLocal,			"setlocal" },
+		{ kOpJmp,				"jmp", kOperandJumpForward },
+		{ kOpEndRepeat,			"endrepeat", kOperandJumpBackward },
+		{ kOpJmpIfZ,			"jmpifz", kOperandJumpForward },
+		{ kOpLocalCall,			"localcall" },
+		{ kOpExtCall,			"extcall" },
+		{ kOpObjCallV4,			"objcallv4" },
+		{ kOpPut,				"put" },
+		{ kOpPutChunk,			"putchunk" },
+		{ kOpDeleteChunk,		"deletechunk" },
+		{ kOpGet,				"get" },
+		{ kOpSet,				"set" },
+		{ kOpGetMovieProp,		"getmovieprop" },
+		{ kOpSetMovieProp,		"setmovieprop" },
+		{ kOpGetObjProp,		"getobjprop" },
+		{ kOpSetObjProp,		"setobjprop" },
+		{ kOpTellCall,			"tellcall" },
+		{ kOpPeek,				"peek" },
+		{ kOpPop,				"pop" },
+		{ kOpTheBuiltin,		"thebuiltin" },
+		{ kOpObjCall,			"objcall" },
+		{ kOpPushChunkVarRef,	"pushchunkvarref" },
+		{ kOpPushInt16,			"pushint16", kOperandSigned16 },
+		{ kOpPushInt32,			"pushint32" },
+		{ kOpGetChainedProp,	"getchainedprop" },
+		{ kOpPushFloat32,		"pushfloat32", kOperandFloat },
+		{ kOpGetTopLevelProp,	"gettoplevelprop" },
+		{ kOpNewObj,			"newobj" }
+	});
+
+	static constexpr std::array<std::string_view, kOpContains0Str + 1> binaryOpNames = makeNameTable<kOpContains0Str + 1>({
+		{ kOpMul,			"*" },
+		{ kOpAdd,			"+" },
+		{ kOpSub,			"-" },
+		{ kOpDiv,			"/" },
+		{ kOpMod,			"mod" },
+		{ kOpJoinStr,		"&" },
+		{ kOpJoinPadStr,	"&&" },
+		{ kOpLt,			"<" },
+		{ kOpLtEq,			"<=" },
+		{ kOpNtEq,			"<>" },
+		{ kOpEq,			"=" },
+		{ kOpGt,			">" },
+		{ kOpGtEq,			">=" },
+		{ kOpAnd,			"and" },
+		{ kOpOr,			"or" },
+		{ kOpContainsStr,	"contains" },
+		{ kOpContains0Str,	"starts" }
+	});
+
+	static constexpr std::array<std::string_view, kChunkLine + 1> chunkTypeNames = makeNameTable<kChunkLine + 1>({
+		{ kChunkChar, "char" },
+		{ kChunkWord, "word" },
+		{ kChunkItem, "item" },
+		{ kChunkLine, "line" }
+	});
+
+	static constexpr std::array<std::string_view, kPutBefore + 1> putTypeNames = makeNameTable<kPutBefore + 1>({
+		{ kPutInto,		"into" },
+		{ kPutAfter,	"after" },
+		{ kPutBefore,	"before" }
+	});
+
+	static constexpr std::array<std::string_view, 0x0c> moviePropertyNames = makeNameTable<0x0c>({
+		{ 0x00, "floatPrecision" },
+		{ 0x01, "mouseDownScript" },
+		{ 0x02, "mouseUpScript" },
+		{ 0x03, "keyDownScript" },
+		{ 0x04, "keyUpScript" },
+		{ 0x05, "timeoutScript" },
+		{ 0x06, "short time" },
+		{ 0x07, "abbr time" },
+		{ 0x08, "long time" },
+		{ 0x09, "short date" },
+		{ 0x0a, "abbr date" },
+		{ 0x0b, "long date" }
+	});
+
+	static constexpr std::array<std::string_view, 0x06> whenEventNames = makeNameTable<0x06>({
+		{ 0x01, "mouseDown" },
+		{ 0x02, "mouseUp" },
+		{ 0x03, "keyDown" },
+		{ 0x04, "keyUp" },
+		{ 0x05, "timeOut" }
+	});
+
+	static constexpr std::array<std::string_view, 0x03> menuPropertyNames = makeNameTable<0x03>({
+		{ 0x01, "name" },
+		{ 0x02, "number of menuItems" }
+	});
+
+	static constexpr std::array<std::string_view, 0x05> menuItemPropertyNames = makeNameTable<0x05>({
+		{ 0x01, "name" },
+		{ 0x02, "checkMark" },
+		{ 0x03, "enabled" },
+		{ 0x04, "script" }
+	});
+
+	static constexpr std::array<std::string_view, 0x02> soundPropertyNames = makeNameTable<0x02>({
+		{ 0x01, "volume" }
+	});
+
+	static constexpr std::array<std::string_view, 0x2b> spritePropertyNames = makeNameTable<0x2b>({
+		{ 0x01, "type" },
+		{ 0x02, "backColor" },
+		{ 0x03, "bottom" },
+		{ 0x04, "castNum" },
+		{ 0x05, "constraint" },
+		{ 0x06, "cursor" },
+		{ 0x07, "foreColor" },
+		{ 0x08, "height" },
+		{ 0x09, "immediate" },
+		{ 0x0a, "ink" },
+		{ 0x0b, "left" },
+		{ 0x0c, "lineSize" },
+		{ 0x0d, "locH" },
+		{ 0x0e, "locV" },
+		{ 0x0f, "movieRate" },
+		{ 0x10, "movieTime" },
+		{ 0x11, "pattern" },
+		{ 0x12, "puppet" },
+		{ 0x13, "right" },
+		{ 0x14, "startTime" },
+		{ 0x15, "stopTime" },
+		{ 0x16, "stretch" },
+		{ 0x17, "top" },
+		{ 0x18, "trails" },
+		{ 0x19, "visible" },
+		{ 0x1a, "volume" },
+		{ 0x1b, "width" },
+		{ 0x1c, "blend" },
+		{ 0x1d, "scriptNum" },
+		{ 0x1e, "moveableSprite" },
+		{ 0x1f, "editableText" },
+		{ 0x20, "scoreColor" },
+		{ 0x21, "loc" },
+		{ 0x22, "rect" },
+		{ 0x23, "memberNum" },
+		{ 0x24, "castLibNum" },
+		{ 0x25, "member" },
+		{ 0x26, "scriptInstanceList" },
+		{ 0x27, "currentTime" },
+		{ 0x28, "mostRecentCuePoint" },
+		{ 0x29, "tweened" },
+		{ 0x2a, "name" }
+	});
+
+	static constexpr std::array<std::string_view, 0x29> animationPropertyNames = makeNameTable<0x29>({
+		{ 0x01, "beepOn" },
+		{ 0x02, "buttonStyle" },
+		{ 0x03, "centerStage" },
+		{ 0x04, "checkBoxAccess" },
+		{ 0x05, "checkboxType" },
+		{ 0x06, "colorDepth" },
+		{ 0x07, "colorQD" },
+		{ 0x08, "exitLock" },
+		{ 0x09, "fixStageSize" },
+		{ 0x0a, "fullColorPermit" },
+		{ 0x0b, "imageDirect" },
+		{ 0x0c, "doubleClick" },
+		{ 0x0d, "key" },
+		{ 0x0e, "lastClick" },
+		{ 0x0f, "lastEvent" },
+		{ 0x10, "keyCode" },
+		{ 0x11, "lastKey" },
+		{ 0x12, "lastRoll"},
+		{ 0x13, "timeoutLapsed" },
+		{ 0x14, "multiSound" },
+		{ 0x15, "pauseState" },
+		{ 0x16, "quickTimePresent" },
+		{ 0x17, "selEnd" },
+		{ 0x18, "selStart" },
+		{ 0x19, "soundEnabled" },
+		{ 0x1a, "soundLevel" },
+		{ 0x1b, "stageColor" },
+		// 0x1c indicates dontPassEvent was called.
+		// It doesn't seem to have a Lingo-accessible name.
+		{ 0x1d, "switchColorDepth" },
+		{ 0x1e, "timeoutKeyDown" },
+		{ 0x1f, "timeoutLength" },
+		{ 0x20, "timeoutMouse" },
+		{ 0x21, "timeoutPlay" },
+		{ 0x22, "timer" },
+		{ 0x23, "preLoadRAM" },
+		{ 0x24, "videoForWindowsPresent" },
+		{ 0x25, "netPresent" },
+		{ 0x26, "safePlayer" },
+		{ 0x27, "soundKeepDevice" },
+		{ 0x28, "soundMixMedia" }
+	});
+
+	static constexpr std::array<std::string_view, 0x06> animation2PropertyNames = makeNameTable<0x06>({
+		{ 0x01, "perFrameHook" },
+		{ 0x02, "number of castMembers" },
+		{ 0x03, "number of menus" },
+		{ 0x04, "number of castLibs" },
+		{ 0x05, "number of xtras" }
+	});
+
+	static constexpr std::array<std::string_view, 0x14> memberPropertyNames = makeNameTable<0x14>({
+		{ 0x01, "name" },
+		{ 0x02, "text" },
+		{ 0x03, "textStyle" },
+		{ 0x04, "textFont" },
+		{ 0x05, "textHeight" },
+		{ 0x06, "textAlign" },
+		{ 0x07, "textSize" },
+		{ 0x08, "picture" },
+		{ 0x09, "hilite" },
+		{ 0x0a, "number" },
+		{ 0x0b, "size" },
+		{ 0x0c, "loop" },
+		{ 0x0d, "duration" },
+		{ 0x0e, "controller" },
+		{ 0x0f, "directToStage" },
+		{ 0x10, "sound" },
+		{ 0x11, "foreColor" },
+		{ 0x12, "backColor" },
+		{ 0x13, "type" }
+	});
+
+	static constexpr OpCode normalizeOpcode(uint8_t op) {
+		return static_cast<OpCode>(op >= 0x40 ? 0x40 + op % 0x40 : op);
+	}
+
+	static constexpr size_t operandWidth(uint8_t op) {
+		if (op >= 0xc0)
+			return 4;
+		if (op >= 0x80)
+			return 2;
+		if (op >= 0x40)
+			return 1;
+		return 0;
+	}
+
+	static constexpr const OpcodeInfo &opcodeInfo(uint8_t op) {
+		return opcodes[normalizeOpcode(op)];
+	}
 
 	static std::string getOpcodeName(uint8_t id);
-	static std::string getName(const std::map<unsigned int, std::string> &nameMap, unsigned int id);
+
+	template <size_t Size>
+	static constexpr std::string_view getName(const std::array<std::string_view, Size> &names, unsigned int id) {
+		if (id >= Size || names[id].empty())
+			return "ERROR";
+		return names[id];
+	}
 };
 
 /* Datum */
@@ -251,8 +588,8 @@ struct Datum {
 	DatumType type;
 	int i;
 	double f;
-	std::string s;
-	std::vector<std::shared_ptr<Node>> l;
+	std::string_view s;
+	std::vector<Node *> l;
 
 	Datum() {
 		type = kDatumVoid;
@@ -265,11 +602,11 @@ struct Datum {
 		type = kDatumFloat;
 		f = val;
 	}
-	Datum(DatumType t, std::string val) {
+	Datum(DatumType t, std::string_view val) {
 		type = t;
 		s = val;
 	}
-	Datum(DatumType t, std::vector<std::shared_ptr<Node>> val) {
+	Datum(DatumType t, std::vector<Node *> val) {
 		type = t;
 		l = val;
 	}
@@ -279,6 +616,28 @@ struct Datum {
 	void writeJSON(Common::JSONWriter &json) const;
 };
 
+/* BytecodeArray */
+
+// A handler's decoded instructions, one column per field. Loop and case
+// recognition mostly scans opcodes and positions, so keeping those apart
+// from the rest keeps the scans tight.
+struct BytecodeArray {
+	static constexpr uint32_t kNoIndex = UINT32_MAX;
+
+	std::vector<uint8_t> opID;
+	std::vector<OpCode> opcode;
+	std::vector<int32_t> obj;
+	std::vector<uint32_t> pos; // ascending
+	std::vector<BytecodeTag> tag;
+	std::vector<uint32_t> ownerLoop;
+	std::vector<Node *> translation;
+
+	size_t size() const { return pos.size(); }
+	void reserve(size_t count);
+	void push(uint8_t op, int32_t o, uint32_t p);
+	uint32_t indexAt(uint32_t p) const; // kNoIndex if no instruction starts at p
+};
+
 /* Handler */
 
 struct Handler {
@@ -303,14 +662,14 @@ struct Handler {
 	std::vector<int16_t> globalNameIDs;
 
 	ScriptChunk *script;
-	std::vector<Bytecode> bytecodeArray;
-	std::map<uint32_t, size_t> bytecodePosMap;
-	std::vector<std::string> argumentNames;
-	std::vector<std::string> localNames;
-	std::vector<std::string> globalNames;
-	std::string name;
-
-	std::vector<std::shared_ptr<Node>> stack;
+	BytecodeArray bytecodeArray;
+	std::vector<std::string_view> argumentNames;
+	std::vector<std::string_view> localNames;
+	std::vector<std::string_view> globalNames;
+	std::string_view name;
+
+	Common::Arena arena; // owns the AST and its datums
+	std::vector<Node *> stack;
 	std::unique_ptr<AST> ast;
 
 	bool isGenericEvent = false;
@@ -324,41 +683,25 @@ struct Handler {
 	std::vector<int16_t> readVarnamesTable(Common::ReadStream &stream, uint16_t count, uint32_t offset);
 	void readNames();
 	bool validName(int id) const;
-	std::string getName(int id) const;
-	std::string getArgumentName(int id) const;
-	std::string getLocalName(int id) const;
-	std::shared_ptr<Node> pop();
+	std::string_view getName(int id) const;
+	bool nameIs(int id, int internedID) const;
+	std::string_view getArgumentName(int id);
+	std::string_view getLocalName(int id);
+	Node *pop();
 	int variableMultiplier();
-	std::shared_ptr<Node> readVar(int varType);
-	std::string getVarNameFromSet(const Bytecode &bytecode);
-	std::shared_ptr<Node> readV4Property(int propertyType, int propertyID);
-	std::shared_ptr<Node> readChunkRef(std::shared_ptr<Node> string);
+	Node *readVar(int varType);
+	std::string_view getVarNameFromSet(uint32_t index);
+	Node *readV4Property(int propertyType, int propertyID);
+	Node *readChunkRef(Node *string);
 	void tagLoops();
 	bool isRepeatWithIn(uint32_t startIndex, uint32_t endIndex);
 	BytecodeTag identifyLoop(uint32_t startIndex, uint32_t endIndex);
 	void parse();
-	uint32_t translateBytecode(Bytecode &bytecode, uint32_t index);
+	uint32_t translateBytecode(uint32_t index);
 	void writeBytecodeText(Common::CodeWriter &code);
 	void writeJSON(Common::JSONWriter &json) const;
 };
 
-/* Bytecode */
-
-struct Bytecode {
-	uint8_t opID;
-	OpCode opcode;
-	int32_t obj;
-	uint32_t pos;
-	BytecodeTag tag;
-	uint32_t ownerLoop;
-	std::shared_ptr<Node> translation;
-
-	Bytecode(uint8_t op, int32_t o, uint32_t p)
-		: opID(op), obj(o), pos(p), tag(kTagNone), ownerLoop(UINT32_MAX) {
-		opcode = static_cast<OpCode>(op >= 0x40 ? 0x40 + op % 0x40 : op);
-	}
-};
-
 /* Node */
 
 struct Node {
@@ -372,7 +715,7 @@ struct Node {
 	Node(NodeType t) : type(t), isExpression(false), isStatement(false), isLabel(false), isLoop(false), parent(nullptr) {}
 	virtual ~Node() = default;
 	virtual void writeScriptText(Common::CodeWriter&, bool, bool) const {}
-	virtual std::shared_ptr<Datum> getValue();
+	virtual Datum *getValue();
 	Node *ancestorStatement();
 	LoopNode *ancestorLoop();
 	virtual bool hasSpaces(bool dot);
@@ -438,21 +781,21 @@ struct CommentNode : Node {
 /* LiteralNode */
 
 struct LiteralNode : ExprNode {
-	std::shared_ptr<Datum> value;
+	Datum *value;
 
-	LiteralNode(std::shared_ptr<Datum> d) : ExprNode(kLiteralNode) {
-		value = std::move(d);
+	LiteralNode(Datum *d) : ExprNode(kLiteralNode) {
+		value = d;
 	}
 	virtual ~LiteralNode() = default;
 	virtual void writeScriptText(Common::CodeWriter &code, bool dot, bool sum) const;
-	virtual std::shared_ptr<Datum> getValue();
+	virtual Datum *getValue();
 	virtual bool hasSpaces(bool dot);
 };
 
 /* BlockNode */
 
 struct BlockNode : Node {
-	std::vector<std::shared_ptr<Node>> children;
+	std::vector<Node *> children;
 
 	// for use during translation:
 	uint32_t endPos;
@@ -461,18 +804,18 @@ struct BlockNode : Node {
 	BlockNode() : Node(kBlockNode), endPos(-1), currentCaseLabel(nullptr) {}
 	virtual ~BlockNode() = default;
 	virtual void writeScriptText(Common::CodeWriter &code, bool dot, bool sum) const;
-	void addChild(std::shared_ptr<Node> child);
+	void addChild(Node *child);
 };
 
 /* HandlerNode */
 
 struct HandlerNode : Node {
 	Handler *handler;
-	std::shared_ptr<BlockNode> block;
+	BlockNode *block;
 
-	HandlerNode(Handler *h)
+	HandlerNode(Common::Arena &arena, Handler *h)
 		: Node(kHandlerNode), handler(h) {
-		block = std::make_shared<BlockNode>();
+		block = arena.make<BlockNode>();
 		block->parent = this;
 	}
 	virtual ~HandlerNode() = default;
@@ -490,10 +833,10 @@ struct ExitStmtNode : StmtNode {
 /* InverseOpNode */
 
 struct InverseOpNode : ExprNode {
-	std::shared_ptr<Node> operand;
+	Node *operand;
 
-	InverseOpNode(std::shared_ptr<Node> o) : ExprNode(kInverseOpNode) {
-		operand = std::move(o);
+	InverseOpNode(Node *o) : ExprNode(kInverseOpNode) {
+		operand = o;
 		operand->parent = this;
 	}
 	virtual ~InverseOpNode() = default;
@@ -503,10 +846,10 @@ struct InverseOpNode : ExprNode {
 /* NotOpNode */
 
 struct NotOpNode : ExprNode {
-	std::shared_ptr<Node> operand;
+	Node *operand;
 
-	NotOpNode(std::shared_ptr<Node> o) : ExprNode(kNotOpNode) {
-		operand = std::move(o);
+	NotOpNode(Node *o) : ExprNode(kNotOpNode) {
+		operand = o;
 		operand->parent = this;
 	}
 	virtual ~NotOpNode() = default;
@@ -517,14 +860,14 @@ struct NotOpNode : ExprNode {
 
 struct BinaryOpNode : ExprNode {
 	OpCode opcode;
-	std::shared_ptr<Node> left;
-	std::shared_ptr<Node> right;
+	Node *left;
+	Node *right;
 
-	BinaryOpNode(OpCode op, std::shared_ptr<Node> a, std::shared_ptr<Node> b)
+	BinaryOpNode(OpCode op, Node *a, Node *b)
 		: ExprNode(kBinaryOpNode), opcode(op) {
-		left = std::move(a);
+		left = a;
 		left->parent = this;
-		right = std::move(b);
+		right = b;
 		right->parent = this;
 	}
 	virtual ~BinaryOpNode() = default;
@@ -536,17 +879,17 @@ struct BinaryOpNode : ExprNode {
 
 struct ChunkExprNode : ExprNode {
 	ChunkExprType type;
-	std::shared_ptr<Node> first;
-	std::shared_ptr<Node> last;
-	std::shared_ptr<Node> string;
+	Node *first;
+	Node *last;
+	Node *string;
 
-	ChunkExprNode(ChunkExprType t, std::shared_ptr<Node> a, std::shared_ptr<Node> b, std::shared_ptr<Node> s)
+	ChunkExprNode(ChunkExprType t, Node *a, Node *b, Node *s)
 		: ExprNode(kChunkExprNode), type(t) {
-		first = std::move(a);
+		first = a;
 		first->parent = this;
-		last = std::move(b);
+		last = b;
 		last->parent = this;
-		string = std::move(s);
+		string = s;
 		string->parent = this;
 	}
 	virtual ~ChunkExprNode() = default;
@@ -556,10 +899,10 @@ struct ChunkExprNode : ExprNode {
 /* ChunkHiliteStmtNode */
 
 struct ChunkHiliteStmtNode : StmtNode {
-	std::shared_ptr<Node> chunk;
+	Node *chunk;
 
-	ChunkHiliteStmtNode(std::shared_ptr<Node> c) : StmtNode(kChunkHiliteStmtNode) {
-		chunk = std::move(c);
+	ChunkHiliteStmtNode(Node *c) : StmtNode(kChunkHiliteStmtNode) {
+		chunk = c;
 		chunk->parent = this;
 	}
 	virtual ~ChunkHiliteStmtNode() = default;
@@ -569,10 +912,10 @@ struct ChunkHiliteStmtNode : StmtNode {
 /* ChunkDeleteStmtNode */
 
 struct ChunkDeleteStmtNode : StmtNode {
-	std::shared_ptr<Node> chunk;
+	Node *chunk;
 
-	ChunkDeleteStmtNode(std::shared_ptr<Node> c) : StmtNode(kChunkDeleteStmtNode) {
-		chunk = std::move(c);
+	ChunkDeleteStmtNode(Node *c) : StmtNode(kChunkDeleteStmtNode) {
+		chunk = c;
 		chunk->parent = this;
 	}
 	virtual ~ChunkDeleteStmtNode() = default;
@@ -582,14 +925,14 @@ struct ChunkDeleteStmtNode : StmtNode {
 /* SpriteIntersectsExprNode */
 
 struct SpriteIntersectsExprNode : ExprNode {
-	std::shared_ptr<Node> firstSprite;
-	std::shared_ptr<Node> secondSprite;
+	Node *firstSprite;
+	Node *secondSprite;
 
-	SpriteIntersectsExprNode(std::shared_ptr<Node> a, std::shared_ptr<Node> b)
+	SpriteIntersectsExprNode(Node *a, Node *b)
 		: ExprNode(kSpriteIntersectsExprNode) {
-		firstSprite = std::move(a);
+		firstSprite = a;
 		firstSprite->parent = this;
-		secondSprite = std::move(b);
+		secondSprite = b;
 		secondSprite->parent = this;
 	}
 	virtual ~SpriteIntersectsExprNode() = default;
@@ -599,14 +942,14 @@ struct SpriteIntersectsExprNode : ExprNode {
 /* SpriteWithinExprNode */
 
 struct SpriteWithinExprNode : ExprNode {
-	std::shared_ptr<Node> firstSprite;
-	std::shared_ptr<Node> secondSprite;
+	Node *firstSprite;
+	Node *secondSprite;
 
-	SpriteWithinExprNode(std::shared_ptr<Node> a, std::shared_ptr<Node> b)
+	SpriteWithinExprNode(Node *a, Node *b)
 		: ExprNode(kSpriteWithinExprNode) {
-		firstSprite = std::move(a);
+		firstSprite = a;
 		firstSprite->parent = this;
-		secondSprite = std::move(b);
+		secondSprite = b;
 		secondSprite->parent = this;
 	}
 	virtual ~SpriteWithinExprNode() = default;
@@ -616,16 +959,16 @@ struct SpriteWithinExprNode : ExprNode {
 /* MemberExprNode */
 
 struct MemberExprNode : ExprNode {
-	std::string type;
-	std::shared_ptr<Node> memberID;
-	std::shared_ptr<Node> castID;
+	std::string_view type;
+	Node *memberID;
+	Node *castID = nullptr;
 
-	MemberExprNode(std::string type, std::shared_ptr<Node> memberID, std::shared_ptr<Node> castID)
+	MemberExprNode(std::string_view type, Node *memberID, Node *castID)
 		: ExprNode(kMemberExprNode), type(type) {
-		this->memberID = std::move(memberID);
+		this->memberID = memberID;
 		this->memberID->parent = this;
 		if (castID) {
-			this->castID = std::move(castID);
+			this->castID = castID;
 			this->castID->parent = this;
 		}
 	}
@@ -637,9 +980,9 @@ struct MemberExprNode : ExprNode {
 /* VarNode */
 
 struct VarNode : ExprNode {
-	std::string varName;
+	std::string_view varName;
 
-	VarNode(std::string v) : ExprNode(kVarNode), varName(v) {}
+	VarNode(std::string_view v) : ExprNode(kVarNode), varName(v) {}
 	virtual ~VarNode() = default;
 	virtual void writeScriptText(Common::CodeWriter &code, bool dot, bool sum) const;
 	virtual bool hasSpaces(bool dot);
@@ -648,15 +991,15 @@ struct VarNode : ExprNode {
 /* AssignmentStmtNode */
 
 struct AssignmentStmtNode : StmtNode {
-	std::shared_ptr<Node> variable;
-	std::shared_ptr<Node> value;
+	Node *variable;
+	Node *value;
 	bool forceVerbose;
 
-	AssignmentStmtNode(std::shared_ptr<Node> var, std::shared_ptr<Node> val, bool forceVerbose = false)
+	AssignmentStmtNode(Node *var, Node *val, bool forceVerbose = false)
 		: StmtNode(kAssignmentStmtNode), forceVerbose(forceVerbose) {
-		variable = std::move(var);
+		variable = var;
 		variable->parent = this;
-		value = std::move(val);
+		value = val;
 		value->parent = this;
 	}
 
@@ -668,16 +1011,16 @@ struct AssignmentStmtNode : StmtNode {
 
 struct IfStmtNode : StmtNode {
 	bool hasElse;
-	std::shared_ptr<Node> condition;
-	std::shared_ptr<BlockNode> block1;
-	std::shared_ptr<BlockNode> block2;
+	Node *condition;
+	BlockNode *block1;
+	BlockNode *block2;
 
-	IfStmtNode(std::shared_ptr<Node> c) : StmtNode(kIfStmtNode), hasElse(false) {
-		condition = std::move(c);
+	IfStmtNode(Common::Arena &arena, Node *c) : StmtNode(kIfStmtNode), hasElse(false) {
+		condition = c;
 		condition->parent = this;
-		block1 = std::make_shared<BlockNode>();
+		block1 = arena.make<BlockNode>();
 		block1->parent = this;
-		block2 = std::make_shared<BlockNode>();
+		block2 = arena.make<BlockNode>();
 		block2->parent = this;
 	}
 	virtual ~IfStmtNode() = default;
@@ -687,14 +1030,14 @@ struct IfStmtNode : StmtNode {
 /* RepeatWhileStmtNode */
 
 struct RepeatWhileStmtNode : LoopNode {
-	std::shared_ptr<Node> condition;
-	std::shared_ptr<BlockNode> block;
+	Node *condition;
+	BlockNode *block;
 
-	RepeatWhileStmtNode(uint32_t startIndex, std::shared_ptr<Node> c)
+	RepeatWhileStmtNode(Common::Arena &arena, uint32_t startIndex, Node *c)
 		: LoopNode(kRepeatWhileStmtNode, startIndex) {
-		condition = std::move(c);
+		condition = c;
 		condition->parent = this;
-		block = std::make_shared<BlockNode>();
+		block = arena.make<BlockNode>();
 		block->parent = this;
 	}
 	virtual ~RepeatWhileStmtNode() = default;
@@ -704,16 +1047,16 @@ struct RepeatWhileStmtNode : LoopNode {
 /* RepeatWithInStmtNode */
 
 struct RepeatWithInStmtNode : LoopNode {
-	std::string varName;
-	std::shared_ptr<Node> list;
-	std::shared_ptr<BlockNode> block;
+	std::string_view varName;
+	Node *list;
+	BlockNode *block;
 
-	RepeatWithInStmtNode(uint32_t startIndex, std::string v, std::shared_ptr<Node> l)
+	RepeatWithInStmtNode(Common::Arena &arena, uint32_t startIndex, std::string_view v, Node *l)
 		: LoopNode(kRepeatWithInStmtNode, startIndex) {
 		varName = v;
-		list = std::move(l);
+		list = l;
 		list->parent = this;
-		block = std::make_shared<BlockNode>();
+		block = arena.make<BlockNode>();
 		block->parent = this;
 	}
 	virtual ~RepeatWithInStmtNode() = default;
@@ -723,20 +1066,20 @@ struct RepeatWithInStmtNode : LoopNode {
 /* RepeatWithToStmtNode */
 
 struct RepeatWithToStmtNode : LoopNode {
-	std::string varName;
-	std::shared_ptr<Node> start;
+	std::string_view varName;
+	Node *start;
 	bool up;
-	std::shared_ptr<Node> end;
-	std::shared_ptr<BlockNode> block;
+	Node *end;
+	BlockNode *block;
 
-	RepeatWithToStmtNode(uint32_t startIndex, std::string v, std::shared_ptr<Node> s, bool up, std::shared_ptr<Node> e)
+	RepeatWithToStmtNode(Common::Arena &arena, uint32_t startIndex, std::string_view v, Node *s, bool up, Node *e)
 		: LoopNode(kRepeatWithToStmtNode, startIndex), up(up) {
 		varName = v;
-		start = std::move(s);
+		start = s;
 		start->parent = this;
-		end = std::move(e);
+		end = e;
 		end->parent = this;
-		block = std::make_shared<BlockNode>();
+		block = arena.make<BlockNode>();
 		block->parent = this;
 	}
 	virtual ~RepeatWithToStmtNode() = default;
@@ -746,16 +1089,16 @@ struct RepeatWithToStmtNode : LoopNode {
 /* CaseLabelNode */
 
 struct CaseLabelNode : LabelNode {
-	std::shared_ptr<Node> value;
+	Node *value;
 	CaseExpect expect;
 
-	std::shared_ptr<CaseLabelNode> nextOr;
+	CaseLabelNode *nextOr = nullptr;
 
-	std::shared_ptr<CaseLabelNode> nextLabel;
-	std::shared_ptr<BlockNode> block;
+	CaseLabelNode *nextLabel = nullptr;
+	BlockNode *block = nullptr;
 
-	CaseLabelNode(std::shared_ptr<Node> v, CaseExpect e) : LabelNode(kCaseLabelNode), expect(e) {
-		value = std::move(v);
+	CaseLabelNode(Node *v, CaseExpect e) : LabelNode(kCaseLabelNode), expect(e) {
+		value = v;
 		value->parent = this;
 	}
 	virtual ~CaseLabelNode() = default;
@@ -765,10 +1108,10 @@ struct CaseLabelNode : LabelNode {
 /* OtherwiseNode */
 
 struct OtherwiseNode : LabelNode {
-	std::shared_ptr<BlockNode> block;
+	BlockNode *block;
 
-	OtherwiseNode() : LabelNode(kOtherwiseNode) {
-		block = std::make_shared<BlockNode>();
+	OtherwiseNode(Common::Arena &arena) : LabelNode(kOtherwiseNode) {
+		block = arena.make<BlockNode>();
 		block->parent = this;
 	}
 	virtual ~OtherwiseNode() = default;
@@ -786,33 +1129,33 @@ struct EndCaseNode : LabelNode {
 /* CaseStmtNode */
 
 struct CaseStmtNode : StmtNode {
-	std::shared_ptr<Node> value;
-	std::shared_ptr<CaseLabelNode> firstLabel;
-	std::shared_ptr<OtherwiseNode> otherwise;
+	Node *value;
+	CaseLabelNode *firstLabel = nullptr;
+	OtherwiseNode *otherwise = nullptr;
 
 	// for use during translation:
 	int32_t endPos = -1;
 	int32_t potentialOtherwisePos = -1;
 
-	CaseStmtNode(std::shared_ptr<Node> v) : StmtNode(kCaseStmtNode) {
-		value = std::move(v);
+	CaseStmtNode(Node *v) : StmtNode(kCaseStmtNode) {
+		value = v;
 		value->parent = this;
 	}
 	virtual ~CaseStmtNode() = default;
 	virtual void writeScriptText(Common::CodeWriter &code, bool dot, bool sum) const;
-	void addOtherwise();
+	void addOtherwise(Common::Arena &arena);
 };
 
 /* TellStmtNode */
 
 struct TellStmtNode : StmtNode {
-	std::shared_ptr<Node> window;
-	std::shared_ptr<BlockNode> block;
+	Node *window;
+	BlockNode *block;
 
-	TellStmtNode(std::shared_ptr<Node> w) : StmtNode(kTellStmtNode) {
-		window = std::move(w);
+	TellStmtNode(Common::Arena &arena, Node *w) : StmtNode(kTellStmtNode) {
+		window = w;
 		window->parent = this;
-		block = std::make_shared<BlockNode>();
+		block = arena.make<BlockNode>();
 		block->parent = this;
 	}
 	virtual ~TellStmtNode() = default;
@@ -821,12 +1164,12 @@ struct TellStmtNode : StmtNode {
 
 /* SoundCmdStmtNode */
 struct SoundCmdStmtNode : StmtNode {
-	std::string cmd;
-	std::shared_ptr<Node> argList;
+	std::string_view cmd;
+	Node *argList;
 
-	SoundCmdStmtNode(std::string c, std::shared_ptr<Node> a) : StmtNode(kSoundCmdStmtNode) {
+	SoundCmdStmtNode(std::string_view c, Node *a) : StmtNode(kSoundCmdStmtNode) {
 		cmd = c;
-		argList = std::move(a);
+		argList = a;
 		argList->parent = this;
 	}
 	virtual ~SoundCmdStmtNode() = default;
@@ -836,12 +1179,12 @@ struct SoundCmdStmtNode : StmtNode {
 /* CallNode */
 
 struct CallNode : Node {
-	std::string name;
-	std::shared_ptr<Node> argList;
+	std::string_view name;
+	Node *argList;
 
-	CallNode(std::string n, std::shared_ptr<Node> a) : Node(kCallNode) {
+	CallNode(std::string_view n, Node *a) : Node(kCallNode) {
 		name = n;
-		argList = std::move(a);
+		argList = a;
 		argList->parent = this;
 		if (argList->getValue()->type == kDatumArgListNoRet)
 			isStatement = true;
@@ -858,12 +1201,12 @@ struct CallNode : Node {
 /* ObjCallNode */
 
 struct ObjCallNode : Node {
-	std::string name;
-	std::shared_ptr<Node> argList;
+	std::string_view name;
+	Node *argList;
 
-	ObjCallNode(std::string n, std::shared_ptr<Node> a) : Node(kObjCallNode) {
+	ObjCallNode(std::string_view n, Node *a) : Node(kObjCallNode) {
 		name = n;
-		argList = std::move(a);
+		argList = a;
 		argList->parent = this;
 		if (argList->getValue()->type == kDatumArgListNoRet)
 			isStatement = true;
@@ -878,12 +1221,12 @@ struct ObjCallNode : Node {
 /* ObjCallV4Node */
 
 struct ObjCallV4Node : Node {
-	std::shared_ptr<Node> obj;
-	std::shared_ptr<Node> argList;
+	Node *obj;
+	Node *argList;
 
-	ObjCallV4Node(std::shared_ptr<Node> o, std::shared_ptr<Node> a) : Node(kObjCallV4Node) {
+	ObjCallV4Node(Node *o, Node *a) : Node(kObjCallV4Node) {
 		obj = o;
-		argList = std::move(a);
+		argList = a;
 		argList->parent = this;
 		if (argList->getValue()->type == kDatumArgListNoRet)
 			isStatement = true;
@@ -898,9 +1241,9 @@ struct ObjCallV4Node : Node {
 /* TheExprNode */
 
 struct TheExprNode : ExprNode {
-	std::string prop;
+	std::string_view prop;
 
-	TheExprNode(std::string p) : ExprNode(kTheExprNode), prop(p) {}
+	TheExprNode(std::string_view p) : ExprNode(kTheExprNode), prop(p) {}
 	virtual ~TheExprNode() = default;
 	virtual void writeScriptText(Common::CodeWriter &code, bool dot, bool sum) const;
 };
@@ -909,11 +1252,11 @@ struct TheExprNode : ExprNode {
 
 struct LastStringChunkExprNode : ExprNode {
 	ChunkExprType type;
-	std::shared_ptr<Node> obj;
+	Node *obj;
 
-	LastStringChunkExprNode(ChunkExprType t, std::shared_ptr<Node> o)
+	LastStringChunkExprNode(ChunkExprType t, Node *o)
 		: ExprNode(kLastStringChunkExprNode), type(t) {
-		obj = std::move(o);
+		obj = o;
 		obj->parent = this;
 	}
 	virtual ~LastStringChunkExprNode() = default;
@@ -924,11 +1267,11 @@ struct LastStringChunkExprNode : ExprNode {
 
 struct StringChunkCountExprNode : ExprNode {
 	ChunkExprType type;
-	std::shared_ptr<Node> obj;
+	Node *obj;
 
-	StringChunkCountExprNode(ChunkExprType t, std::shared_ptr<Node> o)
+	StringChunkCountExprNode(ChunkExprType t, Node *o)
 		: ExprNode(kStringChunkCountExprNode), type(t) {
-		obj = std::move(o);
+		obj = o;
 		obj->parent = this;
 	}
 	virtual ~StringChunkCountExprNode() = default;
@@ -938,12 +1281,12 @@ struct StringChunkCountExprNode : ExprNode {
 /* MenuPropExprNode */
 
 struct MenuPropExprNode : ExprNode {
-	std::shared_ptr<Node> menuID;
+	Node *menuID;
 	unsigned int prop;
 
-	MenuPropExprNode(std::shared_ptr<Node> m, unsigned int p)
+	MenuPropExprNode(Node *m, unsigned int p)
 		: ExprNode(kMenuPropExprNode), prop(p) {
-		menuID = std::move(m);
+		menuID = m;
 		menuID->parent = this;
 	}
 	virtual ~MenuPropExprNode() = default;
@@ -953,15 +1296,15 @@ struct MenuPropExprNode : ExprNode {
 /* MenuItemPropExprNode */
 
 struct MenuItemPropExprNode : ExprNode {
-	std::shared_ptr<Node> menuID;
-	std::shared_ptr<Node> itemID;
+	Node *menuID;
+	Node *itemID;
 	unsigned int prop;
 
-	MenuItemPropExprNode(std::shared_ptr<Node> m, std::shared_ptr<Node> i, unsigned int p)
+	MenuItemPropExprNode(Node *m, Node *i, unsigned int p)
 		: ExprNode(kMenuItemPropExprNode), prop(p) {
-		menuID = std::move(m);
+		menuID = m;
 		menuID->parent = this;
-		itemID = std::move(i);
+		itemID = i;
 		itemID->parent = this;
 	}
 	virtual ~MenuItemPropExprNode() = default;
@@ -971,12 +1314,12 @@ struct MenuItemPropExprNode : ExprNode {
 /* SoundPropExprNode */
 
 struct SoundPropExprNode : ExprNode {
-	std::shared_ptr<Node> soundID;
+	Node *soundID;
 	unsigned int prop;
 
-	SoundPropExprNode(std::shared_ptr<Node> s, unsigned int p)
+	SoundPropExprNode(Node *s, unsigned int p)
 		: ExprNode(kSoundPropExprNode), prop(p) {
-		soundID = std::move(s);
+		soundID = s;
 		soundID->parent = this;
 	}
 	virtual ~SoundPropExprNode() = default;
@@ -986,12 +1329,12 @@ struct SoundPropExprNode : ExprNode {
 /* SpritePropExprNode */
 
 struct SpritePropExprNode : ExprNode {
-	std::shared_ptr<Node> spriteID;
+	Node *spriteID;
 	unsigned int prop;
 
-	SpritePropExprNode(std::shared_ptr<Node> s, unsigned int p)
+	SpritePropExprNode(Node *s, unsigned int p)
 		: ExprNode(kSpritePropExprNode), prop(p) {
-		spriteID = std::move(s);
+		spriteID = s;
 		spriteID->parent = this;
 	}
 	virtual ~SpritePropExprNode() = default;
@@ -1001,12 +1344,12 @@ struct SpritePropExprNode : ExprNode {
 /* ThePropExprNode */
 
 struct ThePropExprNode : ExprNode {
-	std::shared_ptr<Node> obj;
-	std::string prop;
+	Node *obj;
+	std::string_view prop;
 
-	ThePropExprNode(std::shared_ptr<Node> o, std::string p)
+	ThePropExprNode(Node *o, std::string_view p)
 		: ExprNode(kThePropExprNode), prop(p) {
-		obj = std::move(o);
+		obj = o;
 		obj->parent = this;
 	}
 	virtual ~ThePropExprNode() = default;
@@ -1016,12 +1359,12 @@ struct ThePropExprNode : ExprNode {
 /* ObjPropExprNode */
 
 struct ObjPropExprNode : ExprNode {
-	std::shared_ptr<Node> obj;
-	std::string prop;
+	Node *obj;
+	std::string_view prop;
 
-	ObjPropExprNode(std::shared_ptr<Node> o, std::string p)
+	ObjPropExprNode(Node *o, std::string_view p)
 		: ExprNode(kObjPropExprNode), prop(p) {
-		obj = std::move(o);
+		obj = o;
 		obj->parent = this;
 	}
 	virtual ~ObjPropExprNode() = default;
@@ -1032,14 +1375,14 @@ struct ObjPropExprNode : ExprNode {
 /* ObjBracketExprNode */
 
 struct ObjBracketExprNode : ExprNode {
-	std::shared_ptr<Node> obj;
-	std::shared_ptr<Node> prop;
+	Node *obj;
+	Node *prop;
 
-	ObjBracketExprNode(std::shared_ptr<Node> o, std::shared_ptr<Node> p)
+	ObjBracketExprNode(Node *o, Node *p)
 		: ExprNode(kObjBracketExprNode) {
-		obj = std::move(o);
+		obj = o;
 		obj->parent = this;
-		prop = std::move(p);
+		prop = p;
 		prop->parent = this;
 	}
 	virtual ~ObjBracketExprNode() = default;
@@ -1050,19 +1393,19 @@ struct ObjBracketExprNode : ExprNode {
 /* ObjPropIndexExprNode */
 
 struct ObjPropIndexExprNode : ExprNode {
-	std::shared_ptr<Node> obj;
-	std::string prop;
-	std::shared_ptr<Node> index;
-	std::shared_ptr<Node> index2;
+	Node *obj;
+	std::string_view prop;
+	Node *index;
+	Node *index2 = nullptr;
 
-	ObjPropIndexExprNode(std::shared_ptr<Node> o, std::string p, std::shared_ptr<Node> i, std::shared_ptr<Node> i2)
+	ObjPropIndexExprNode(Node *o, std::string_view p, Node *i, Node *i2)
 		: ExprNode(kObjPropIndexExprNode), prop(p) {
-		obj = std::move(o);
+		obj = o;
 		obj->parent = this;
-		index = std::move(i);
+		index = i;
 		index->parent = this;
 		if (i2) {
-			index2 = std::move(i2);
+			index2 = i2;
 			index2->parent = this;
 		}
 	}
@@ -1091,14 +1434,14 @@ struct NextRepeatStmtNode : StmtNode {
 
 struct PutStmtNode : StmtNode {
 	PutType type;
-	std::shared_ptr<Node> variable;
-	std::shared_ptr<Node> value;
+	Node *variable;
+	Node *value;
 
-	PutStmtNode(PutType t, std::shared_ptr<Node> var, std::shared_ptr<Node> val)
+	PutStmtNode(PutType t, Node *var, Node *val)
 		: StmtNode(kPutStmtNode), type(t) {
-		variable = std::move(var);
+		variable = var;
 		variable->parent = this;
-		value = std::move(val);
+		value = val;
 		value->parent = this;
 	}
 	virtual ~PutStmtNode() = default;
@@ -1109,9 +1452,9 @@ struct PutStmtNode : StmtNode {
 
 struct WhenStmtNode : StmtNode {
 	int event;
-	std::string script;
+	std::string_view script;
 
-	WhenStmtNode(int e, std::string s)
+	WhenStmtNode(int e, std::string_view s)
 		: StmtNode(kWhenStmtNode), event(e), script(s) {}
 	virtual ~WhenStmtNode() = default;
 	virtual void writeScriptText(Common::CodeWriter &code, bool dot, bool sum) const;
@@ -1120,27 +1463,28 @@ struct WhenStmtNode : StmtNode {
 /* NewObjNode */
 
 struct NewObjNode : ExprNode {
-	std::string objType;
-	std::shared_ptr<Node> objArgs;
+	std::string_view objType;
+	Node *objArgs;
 
-	NewObjNode(std::string o, std::shared_ptr<Node> args) : ExprNode(kNewObjNode), objType(o), objArgs(args) {}
+	NewObjNode(std::string_view o, Node *args) : ExprNode(kNewObjNode), objType(o), objArgs(args) {}
 	virtual ~NewObjNode() = default;
 	virtual void writeScriptText(Common::CodeWriter &code, bool dot, bool sum) const;
 };
 
 /* AST */
 
+// Nodes are owned by the handler's arena.
 struct AST {
-	std::shared_ptr<HandlerNode> root;
+	HandlerNode *root;
 	BlockNode *currentBlock;
 
-	AST(Handler *handler){
-		root = std::make_shared<HandlerNode>(handler);
-		currentBlock = root->block.get();
+	AST(Common::Arena &arena, Handler *handler){
+		root = arena.make<HandlerNode>(arena, handler);
+		currentBlock = root->block;
 	}
 
 	void writeScriptText(Common::CodeWriter &code, bool dot, bool sum) const;
-	void addStatement(std::shared_ptr<Node> statement);
+	void addStatement(Node *statement);
 	void enterBlock(BlockNode *block);
 	void exitBlock();
 };
@@ -0,0 +1,153 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include <exception>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+#include <boost/format.hpp>
+
+#include "common/fileio.h"
+#include "common/log.h"
+#include "common/stream.h"
+#include "common/util.h"
+#include "director/scriptcache.h"
+
+namespace fs = std::filesystem;
+
+namespace Director {
+
+static const uint32_t kEntryMagic = FOURCC('P', 'R', 'S', 'C');
+static const uint16_t kEntryFormatVersion = 1;
+// Smallest possible records: a name with an empty string, and a variant
+// with no names and empty texts.
+static const size_t kMinNameSize = 9;
+static const size_t kMinVariantSize = 12;
+
+static size_t entrySize(const std::vector<CachedScript> &variants) {
+	size_t size = 8;
+	for (const auto &variant : variants) {
+		size += 4;
+		for (const auto &name : variant.names) {
+			size += 9 + name.name.size();
+		}
+		size += 4 + variant.scriptText.size();
+		size += 4 + variant.bytecodeText.size();
+	}
+	return size;
+}
+
+static std::string readLongString(Common::ReadStream &stream) {
+	uint32_t len = stream.readUint32();
+	return stream.readString(len);
+}
+
+static void writeLongString(Common::WriteStream &stream, const std::string &value) {
+	stream.writeUint32(value.size());
+	stream.writeString(value);
+}
+
+/* ScriptCache */
+
+ScriptCache::ScriptCache(const fs::path &dir) : _dir(dir) {}
+
+fs::path ScriptCache::entryPath(const Common::Hash128 &key) const {
+	// Spread entries over subdirectories so that none gets too large.
+	std::string name = key.toString();
+	return _dir / name.substr(0, 2) / name;
+}
+
+std::vector<CachedScript> ScriptCache::readEntry(const fs::path &path) const {
+	std::vector<CachedScript> variants;
+	std::vector<uint8_t> buf;
+	if (!Common::readFile(path, buf))
+		return variants;
+
+	try {
+		Common::ReadStream stream(buf.data(), buf.size());
+		if (stream.readUint32() != kEntryMagic || stream.readUint16() != kEntryFormatVersion)
+			return variants;
+
+		// Check counts against the bytes left before allocating for them, so
+		// a damaged count can't make us allocate gigabytes.
+		uint16_t variantCount = stream.readUint16();
+		if (variantCount > (stream.size() - stream.pos()) / kMinVariantSize)
+			throw std::runtime_error("Variant count out of range");
+		variants.resize(variantCount);
+		for (auto &variant : variants) {
+			uint32_t nameCount = stream.readUint32();
+			if (nameCount > (stream.size() - stream.pos()) / kMinNameSize)
+				throw std::runtime_error("Name count out of range");
+			variant.names.resize(nameCount);
+			for (auto &name : variant.names) {
+				name.id = stream.readInt32();
+				name.valid = stream.readUint8();
+				name.name = readLongString(stream);
+			}
+			variant.scriptText = readLongString(stream);
+			variant.bytecodeText = readLongString(stream);
+		}
+	} catch (const std::exception &) {
+		// A truncated or otherwise damaged entry is just a miss.
+		Common::warning(boost::format("Ignoring damaged script cache entry %s") % path.string());
+		variants.clear();
+	}
+	return variants;
+}
+
+std::vector<CachedScript> ScriptCache::load(const Common::Hash128 &key) const {
+	return readEntry(entryPath(key));
+}
+
+void ScriptCache::store(const Common::Hash128 &key, const CachedScript &script) {
+	fs::path path = entryPath(key);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::vector<CachedScript> variants = readEntry(path);
+	if (variants.size() >= kMaxVariants) {
+		variants.erase(variants.begin());
+	}
+	variants.push_back(script);
+
+	std::vector<uint8_t> buf(entrySize(variants));
+	Common::WriteStream stream(buf.data(), buf.size());
+	stream.writeUint32(kEntryMagic);
+	stream.writeUint16(kEntryFormatVersion);
+	stream.writeUint16(variants.size());
+	for (const auto &variant : variants) {
+		stream.writeUint32(variant.names.size());
+		for (const auto &name : variant.names) {
+			stream.writeInt32(name.id);
+			stream.writeUint8(name.valid);
+			writeLongString(stream, name.name);
+		}
+		writeLongString(stream, variant.scriptText);
+		writeLongString(stream, variant.bytecodeText);
+	}
+
+	// Write to a file of our own and rename it into place, so readers in
+	// other processes never see a partial entry.
+	std::error_code ec;
+	fs::create_directories(path.parent_path(), ec);
+	static const std::string token = std::to_string(std::random_device()());
+	fs::path tempPath = path;
+	tempPath += ".tmp" + token;
+	std::ofstream f(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	f.write((const char *)buf.data(), buf.size());
+	f.close();
+	if (f.fail()) {
+		Common::warning(boost::format("Could not write script cache entry %s") % tempPath.string());
+		fs::remove(tempPath, ec);
+		return;
+	}
+	fs::rename(tempPath, path, ec);
+	if (ec) {
+		fs::remove(tempPath, ec);
+	}
+}
+
+} // namespace Director
@@ -0,0 +1,61 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef DIRECTOR_SCRIPTCACHE_H
+#define DIRECTOR_SCRIPTCACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/hash.h"
+
+namespace Director {
+
+// A name a script looked up while it was decompiled, and what it resolved to.
+struct CachedName {
+	int32_t id;
+	bool valid;
+	std::string name;
+};
+
+struct CachedScript {
+	std::vector<CachedName> names;
+	std::string scriptText;
+	std::string bytecodeText;
+};
+
+/* ScriptCache */
+
+// On-disk cache of decompiled scripts shared across files and runs. Entries
+// are addressed by a hash of the script's bytecode and the settings that
+// affect decompilation. Since the same bytecode can refer to different names
+// in different movies, each entry keeps every variant that has been seen
+// along with the names it used, and the caller picks the one whose names
+// match. Safe to use from several threads and processes at once; a lost
+// race only loses a variant.
+class ScriptCache {
+private:
+	std::filesystem::path _dir;
+	std::mutex _mutex;
+
+	std::filesystem::path entryPath(const Common::Hash128 &key) const;
+	std::vector<CachedScript> readEntry(const std::filesystem::path &path) const;
+
+public:
+	static const size_t kMaxVariants = 16;
+
+	ScriptCache(const std::filesystem::path &dir);
+
+	std::vector<CachedScript> load(const Common::Hash128 &key) const;
+	void store(const Common::Hash128 &key, const CachedScript &script);
+};
+
+} // namespace Director
+
+#endif // DIRECTOR_SCRIPTCACHE_H
@@ -24,12 +24,57 @@ off_t ReadStream_lseek(void *stream, off_t offset, int whence) {
 	return ((Common::ReadStream *)stream)->lseek(offset, whence);
 }
 
+// Setting up an mpg123 handle is relatively expensive, so each thread
+// keeps one around and reuses it for every chunk it decodes.
+class MP3Handle {
+private:
+	mpg123_handle *_mh;
+
+public:
+	MP3Handle() : _mh(nullptr) {}
+	~MP3Handle() {
+		if (_mh) {
+			mpg123_delete(_mh);
+		}
+	}
+
+	mpg123_handle *get(int *err) {
+		if (!_mh) {
+			_mh = mpg123_new(NULL, err);
+		}
+		return _mh;
+	}
+
+	void discard() {
+		mpg123_delete(_mh);
+		_mh = nullptr;
+	}
+};
+
+static thread_local MP3Handle t_mp3Handle;
+
+// Closes the handle's stream when decoding finishes. If decoding failed,
+// the handle may be in a bad state, so it isn't reused.
+class MP3HandleLease {
+private:
+	mpg123_handle *_mh;
+
+public:
+	bool succeeded;
+
+	MP3HandleLease(mpg123_handle *mh) : _mh(mh), succeeded(false) {}
+	~MP3HandleLease() {
+		mpg123_close(_mh);
+		if (!succeeded) {
+			t_mp3Handle.discard();
+		}
+	}
+};
+
 #define CHECK_ERR(name) \
 	do { \
 		if (err != MPG123_OK && err != MPG123_DONE) { \
 			Common::warning(boost::format(name": %s") % mpg123_plain_strerror(err)); \
-			mpg123_close(mh); \
-			mpg123_delete(mh); \
 			return false; \
 		} \
 	} while (0)
@@ -55,17 +100,18 @@ bool decodeMP3(
 	int32_t chunkID
 ) {
 	size_t bytesToRead = out.size() - out.pos();
-	Common::debug(boost::format("Chunk %d: Decoding %zu bytes of MP3 data (rate: %d channels: %d bitdepth: %d)")
+	LOG_DEBUG(boost::format("Chunk %d: Decoding %zu bytes of MP3 data (rate: %d channels: %d bitdepth: %d)")
 					% chunkID % bytesToRead % hdrSampleRate % hdrChannels % hdrSampleSize);
 
 	int err;
 	mpg123_handle *mh;
 
-	// initialize an mpg123 handle
-	if ((mh = mpg123_new(NULL, &err)) == NULL) {
+	// get this thread's mpg123 handle
+	if ((mh = t_mp3Handle.get(&err)) == NULL) {
 		Common::warning(boost::format("mpg123_new: %s") % mpg123_plain_strerror(err));
 		return false;
 	}
+	MP3HandleLease lease(mh);
 
 	// clear its supported formats
 	err = mpg123_format_none(mh);
@@ -131,13 +177,13 @@ bool decodeMP3(
 		bytesToRead -= done;
 	}
 
-	mpg123_close(mh);
-	mpg123_delete(mh);
-
+	lease.succeeded = true;
 	return true;
 }
 
-ssize_t decompressSnd(Common::ReadStream &in, Common::WriteStream &out, int32_t chunkID) {
+// If decodeSamples is false, only the sound header is written, with a sample
+// count of zero, and `in` is left at the start of the MP3 data.
+ssize_t decompressSnd(Common::ReadStream &in, Common::WriteStream &out, int32_t chunkID, bool decodeSamples) {
 	if (in.size() == 0)
 		return 0;
 
@@ -189,6 +235,7 @@ ssize_t decompressSnd(Common::ReadStream &in, Common::WriteStream &out, int32_t
 	uint32_t samplePtr = in.readUint32();
 	out.writeUint32(samplePtr);
 
+	size_t encodeDependentPos = out.pos();
 	uint32_t encodeDependent = in.readUint32();
 	out.writeUint32(encodeDependent);
 
@@ -219,12 +266,19 @@ ssize_t decompressSnd(Common::ReadStream &in, Common::WriteStream &out, int32_t
 		numSamples = encodeDependent;
 		numChannels = 1;
 		sampleSize = 8;
+
+		if (!decodeSamples) {
+			size_t p = out.pos();
+			out.seek(encodeDependentPos);
+			out.writeUint32(0);
+			out.seek(p);
+		}
 	} else if (encode == 0xFF || encode == 0xFD) {
 		// Extended header
 		numChannels = encodeDependent;
 
 		numSamples = in.readUint32();
-		out.writeUint32(numSamples);
+		out.writeUint32(decodeSamples ? numSamples : 0);
 
 		Common::BufferView AIFFSampleRate = in.readByteView(10);
 		out.writeBytes(AIFFSampleRate);
@@ -261,6 +315,9 @@ ssize_t decompressSnd(Common::ReadStream &in, Common::WriteStream &out, int32_t
 
 	uint32_t skipSamples = in.readUint32();
 
+	if (!decodeSamples)
+		return out.pos();
+
 	// MP3 data
 
 	Common::BufferView mp3View = in.readByteView(in.size() - in.pos());
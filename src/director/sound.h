@@ -16,7 +16,7 @@ class WriteStream;
 
 namespace Director {
 
-ssize_t decompressSnd(Common::ReadStream &in, Common::WriteStream &out, int32_t castID);
+ssize_t decompressSnd(Common::ReadStream &in, Common::WriteStream &out, int32_t castID, bool decodeSamples = true);
 
 } // namespace Director
 
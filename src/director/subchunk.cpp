@@ -107,7 +107,8 @@ void LiteralStore::readData(Common::ReadStream &stream, uint32_t startOffset) {
 		stream.seek(startOffset + offset);
 		auto length = stream.readUint32();
 		if (type == kLiteralString) {
-			value = std::make_shared<Datum>(kDatumString, stream.readString(length - 1));
+			text = stream.readString(length - 1);
+			value = std::make_shared<Datum>(kDatumString, text);
 		} else if (type == kLiteralFloat) {
 			double floatVal = 0.0;
 			if (length == 8) {
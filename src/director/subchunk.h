@@ -74,6 +74,9 @@ struct KeyTableEntry {
 struct LiteralStore {
 	LiteralType type;
 	uint32_t offset;
+	// String values refer to text, so a literal must not be moved once its
+	// data has been read.
+	std::string text;
 	std::shared_ptr<Datum> value;
 
 	void readRecord(Common::ReadStream &stream, int version);
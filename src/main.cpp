@@ -4,34 +4,83 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <csignal>
 #include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 namespace fs = std::filesystem;
 
 #include "common/options.h"
 #include "common/fileio.h"
+#include "common/json.h"
 #include "common/log.h"
+#include "common/manifest.h"
+#include "common/profile.h"
 #include "common/stream.h"
+#include "common/threadpool.h"
 #include "common/util.h"
 #include "director/chunk.h"
 #include "director/dirfile.h"
+#include "director/scriptcache.h"
 #include "director/util.h"
 
 using namespace Director;
 
-bool processFile(fs::path input, Common::Options &options, bool outputIsDirectory) {
-	std::vector<uint8_t> buf;
-	if (!Common::readFile(input, buf)) {
+// The file and stream must outlive the DirectorFile, which reads from them.
+std::unique_ptr<DirectorFile> loadFile(Common::MappedFile &file, Common::ReadStream &stream, const fs::path &input,
+		Common::Options &options, Common::ThreadPool *threadPool, Common::Profile *profile, ScriptCache *scriptCache) {
+	if (!file.open(input)) {
 		Common::warning(boost::format("Could not read %s!") % input);
-		return false;
+		return nullptr;
 	}
+	// Only the maps and the chunks they point to are read at first.
+	file.advise(Common::kAccessRandom);
 
-	Common::ReadStream stream(buf.data(), buf.size());
+	stream = Common::ReadStream(file.view());
 	auto dir = std::make_unique<DirectorFile>();
+	dir->sourceFile = &file;
+	dir->threadPool = threadPool;
+	dir->profile = profile;
+	if (options.cmd() == Common::kCmdDecompile) {
+		dir->scriptCache = scriptCache;
+	}
+	if (options.hasOption("sound")) {
+		dir->soundMode = (Common::SoundMode)options.enumValue("sound");
+	}
 	if (!dir->read(&stream))
+		return nullptr;
+
+	return dir;
+}
+
+bool processFile(const fs::path &input, Common::Options &options, const fs::path &outputDir,
+		Common::ThreadPool *threadPool = nullptr, Common::Profile *profile = nullptr,
+		ScriptCache *scriptCache = nullptr, fs::path *writtenPath = nullptr) {
+	Common::ScopedTimer timer(profile, Common::kPhaseTotal);
+
+	Common::MappedFile file;
+	Common::ReadStream stream(nullptr, 0);
+	auto dir = loadFile(file, stream, input, options, threadPool, profile, scriptCache);
+	if (!dir)
 		return false;
 
 	if (options.hasOption("dump-chunks")) {
@@ -46,7 +95,7 @@ bool processFile(fs::path input, Common::Options &options, bool outputIsDirector
 	case Common::kCmdDecompile:
 		{
 			fs::path output;
-			if (options.hasOption("output") && !outputIsDirectory) {
+			if (options.hasOption("output") && outputDir.empty()) {
 				output = options.stringValue("output");
 			} else {
 				std::string oldExtension = input.extension().string();
@@ -56,22 +105,34 @@ bool processFile(fs::path input, Common::Options &options, bool outputIsDirector
 					fileName += "_decompiled";
 				}
 				fileName += newExtension;
-				if (options.hasOption("output") && outputIsDirectory) {
-					output = options.stringValue("output");
-					output /= fileName;
+				if (!outputDir.empty()) {
+					fs::create_directories(outputDir);
+					output = outputDir / fileName;
 				} else {
 					output = input;
 					output.replace_filename(fileName);
 				}
 			}
 
+			// Unless we're only patching, every chunk is about to be
+			// copied to the output.
+			bool patch = options.hasOption("patch") && dir->canPatch();
+			if (!patch) {
+				file.advise(Common::kAccessWillNeed);
+			}
+
 			dir->config->unprotect();
 			dir->parseScripts();
 			if (options.hasOption("dump-scripts")) {
 				dir->dumpScripts();
 			}
 			dir->restoreScriptText();
-			dir->writeToFile(output);
+			bool written = patch ? dir->patchFile(output) : dir->writeToFile(output);
+			if (!written)
+				return false;
+			if (writtenPath) {
+				*writtenPath = output;
+			}
 
 			std::string fileType = (dir->isCast()) ? "cast" : "movie";
 			Common::log(
@@ -109,6 +170,640 @@ bool processFile(fs::path input, Common::Options &options, bool outputIsDirector
 	return true;
 }
 
+void printProfile(const Common::Profile &profile, const Common::Options &options, const std::string &name) {
+	if (options.enumValue("profile") == Common::kProfileFormatJSON) {
+		Common::JSONWriter json("", "");
+		json.startObject();
+			json.writeKey("name");
+			json.writeVal(name);
+			json.writeKey("profile");
+			profile.writeJSON(json);
+		json.endObject();
+		std::string res = json.str();
+		if (!res.empty() && res.back() == '\n') {
+			res.pop_back();
+		}
+		Common::log(res);
+	} else {
+		Common::log(profile.table("Profile for " + name + ":"));
+	}
+}
+
+// Director files are recognized by their header, not their extension.
+bool isDirectorFile(const fs::path &path) {
+	uint8_t header[DirectorFile::kSniffSize];
+	std::ifstream f(path, std::ios::in | std::ios::binary);
+	if (!f.read((char *)header, sizeof(header)))
+		return false;
+
+	return DirectorFile::sniff(Common::BufferView(header, sizeof(header)));
+}
+
+// Everything besides the inputs that determines what a decompile run writes,
+// so that a manifest from a run with different settings isn't trusted.
+std::string outputFingerprint(const Common::Options &options) {
+	std::string res = "ProjectorRays " STR(VERSION_NUMBER) "-" STR(GIT_SHA);
+	if (options.hasOption("output")) {
+		res += " output=" + fs::absolute(options.stringValue("output")).lexically_normal().string();
+	}
+	if (options.hasOption("sound")) {
+		res += " sound=" + std::to_string(options.enumValue("sound"));
+	}
+	for (const char *flag : { "patch", "dump-scripts", "dump-chunks", "dump-json" }) {
+		if (options.hasOption(flag)) {
+			res += std::string(" ") + flag;
+		}
+	}
+	return res;
+}
+
+/* BatchProcessor */
+
+class BatchProcessor {
+private:
+	Common::Options &_options;
+	std::unique_ptr<Common::ThreadPool> _pool;
+
+	std::mutex _mutex;
+	size_t _processed;
+	size_t _unchanged;
+	std::vector<fs::path> _failures;
+	Common::Profile _profile;
+	std::unique_ptr<ScriptCache> _scriptCache;
+	std::unique_ptr<Common::Manifest> _manifest;
+
+	void process(const fs::path &input, const fs::path &outputDir, bool sniff);
+
+public:
+	BatchProcessor(Common::Options &options, unsigned int jobs);
+
+	void add(const fs::path &input, const fs::path &outputDir, bool sniff);
+	bool finish();
+};
+
+BatchProcessor::BatchProcessor(Common::Options &options, unsigned int jobs)
+	: _options(options), _processed(0), _unchanged(0) {
+	// Keep the queue short so that enumerating a huge corpus
+	// doesn't get far ahead of the workers.
+	if (jobs > 1) {
+		_pool = std::make_unique<Common::ThreadPool>(jobs, 4 * jobs);
+	}
+	if (options.hasOption("script-cache")) {
+		_scriptCache = std::make_unique<ScriptCache>(options.stringValue("script-cache"));
+	}
+	if (options.cmd() == Common::kCmdDecompile && options.hasOption("manifest")) {
+		_manifest = std::make_unique<Common::Manifest>(options.stringValue("manifest"), outputFingerprint(options));
+		_manifest->load();
+	}
+}
+
+void BatchProcessor::add(const fs::path &input, const fs::path &outputDir, bool sniff) {
+	if (!_pool) {
+		process(input, outputDir, sniff);
+		return;
+	}
+
+	_pool->enqueue([this, input, outputDir, sniff]() {
+		Common::LogCapture capture;
+		process(input, outputDir, sniff);
+	});
+}
+
+void BatchProcessor::process(const fs::path &input, const fs::path &outputDir, bool sniff) {
+	// Anything in the manifest was a Director file last time.
+	if (_manifest && _manifest->upToDate(input)) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_unchanged++;
+		return;
+	}
+	if (sniff && !isDirectorFile(input))
+		return;
+
+	bool profiling = _options.hasOption("profile");
+	Common::Profile profile;
+	bool success = false;
+	fs::path output;
+	try {
+		success = processFile(input, _options, outputDir, nullptr, profiling ? &profile : nullptr,
+			_scriptCache.get(), &output);
+	} catch (const std::exception &e) {
+		Common::warning(boost::format("Failed to process %s: %s") % input.string() % e.what());
+	}
+	if (profiling) {
+		printProfile(profile, _options, input.string());
+		_profile.merge(profile);
+	}
+	if (_manifest) {
+		if (success) {
+			_manifest->update(input, output);
+		} else {
+			_manifest->remove(input);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_processed++;
+	if (!success) {
+		_failures.push_back(input);
+	}
+}
+
+bool BatchProcessor::finish() {
+	if (_pool) {
+		_pool->wait();
+	}
+
+	if (_manifest) {
+		_manifest->save();
+		Common::log(boost::format("Processed %zu files: %zu succeeded, %zu failed, %zu skipped as unchanged")
+			% _processed % (_processed - _failures.size()) % _failures.size() % _unchanged);
+	} else {
+		Common::log(boost::format("Processed %zu files: %zu succeeded, %zu failed")
+			% _processed % (_processed - _failures.size()) % _failures.size());
+	}
+	for (const fs::path &input : _failures) {
+		Common::warning(boost::format("Failed: %s") % input.string());
+	}
+	if (_options.hasOption("profile")) {
+		printProfile(_profile, _options, "all files");
+	}
+
+	return _failures.empty();
+}
+
+// Walk the input directory, queueing files as they're found rather than
+// collecting the whole listing first.
+void addDirectory(BatchProcessor &batch, const fs::path &inputRoot, const fs::path &outputRoot, bool recursive) {
+	fs::path skipDir = outputRoot.empty() ? fs::path() : fs::absolute(outputRoot).lexically_normal();
+	std::error_code ec;
+	fs::recursive_directory_iterator it(inputRoot, fs::directory_options::skip_permission_denied, ec);
+	for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+		const fs::directory_entry &dirEntry = *it;
+		if (dirEntry.is_directory(ec)) {
+			// Don't descend into our own output.
+			if (!recursive || fs::absolute(dirEntry.path()).lexically_normal() == skipDir) {
+				it.disable_recursion_pending();
+			}
+			continue;
+		}
+		if (!dirEntry.is_regular_file(ec))
+			continue;
+
+		// Skip editable movies and casts. This is what we write, so they'd
+		// otherwise be picked up again when the output is inside the input.
+		fs::path path = dirEntry.path();
+		std::string extension = path.extension().string();
+		if (Common::compareIgnoreCase(extension, ".dir") == 0
+				|| Common::compareIgnoreCase(extension, ".cst") == 0)
+			continue;
+
+		fs::path outputDir;
+		if (!outputRoot.empty()) {
+			outputDir = outputRoot / path.parent_path().lexically_relative(inputRoot);
+		}
+		batch.add(path, outputDir.lexically_normal(), true);
+	}
+	if (ec) {
+		Common::warning(boost::format("Could not read directory %s: %s") % inputRoot.string() % ec.message());
+	}
+}
+
+bool addFileList(BatchProcessor &batch, const std::string &listPath, const fs::path &outputDir) {
+	std::ifstream f;
+	std::istream *in = &std::cin;
+	if (listPath != "-") {
+		f.open(listPath);
+		if (f.fail()) {
+			Common::warning("Could not read " + listPath + "!");
+			return false;
+		}
+		in = &f;
+	}
+
+	std::string line;
+	while (std::getline(*in, line)) {
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		if (line.empty())
+			continue;
+
+		batch.add(line, outputDir, false);
+	}
+	return true;
+}
+
+/* Server */
+
+// Formats a number from a request as it would be typed on the command line.
+// Only integers that fit are cast, since the cast is undefined otherwise.
+std::string numberToString(double n) {
+	if (n >= (double)LLONG_MIN && n < (double)LLONG_MAX && std::trunc(n) == n)
+		return std::to_string((long long)n);
+	return Common::floatToString(n);
+}
+
+// Long-running mode for callers with many files to process. Each request is
+// one line of JSON, e.g.
+//   {"id": 1, "command": "decompile", "input": "a.dcr", "options": {"output": "a.dir"}}
+// where command is "decompile", "version" or "dump", and options holds
+// command line options by long name, with true for flags. "dump" reads the
+// file and responds with its decompiled scripts without writing anything.
+// Requests are processed concurrently and each gets one line back, in the
+// order they finish, with the request's id, whether it succeeded, the
+// messages it logged and how long it took.
+class Server {
+private:
+	// Where responses go: standard output, or a socket connection which is
+	// closed when the last response for it has been sent.
+	class Connection {
+	private:
+		int _fd;
+		std::mutex _mutex;
+
+	public:
+		Connection(int fd) : _fd(fd) {}
+		~Connection();
+		Connection(const Connection &) = delete;
+		Connection &operator=(const Connection &) = delete;
+
+		void send(const std::string &line);
+	};
+
+	Common::ThreadPool _pool;
+
+#ifndef _WIN32
+	// Threads reading from socket connections, tracked so that they can be
+	// stopped and joined before the server goes away. The descriptors are
+	// those of the connections still being read.
+	std::mutex _readersMutex;
+	std::map<uint64_t, std::thread> _readers;
+	std::map<uint64_t, int> _readerFds;
+	std::vector<uint64_t> _finishedReaders;
+	uint64_t _nextReaderID = 0;
+#endif
+
+	void enqueue(const std::string &line, const std::shared_ptr<Connection> &connection);
+	std::string handle(const std::string &line, uint64_t queuedUs);
+	void readLines(std::istream &in, const std::shared_ptr<Connection> &connection);
+#ifndef _WIN32
+	void readSocket(uint64_t readerID, int fd);
+	void joinFinishedReaders();
+	void stopReaders();
+#endif
+
+public:
+	Server(unsigned int jobs) : _pool(jobs, 4 * jobs) {}
+
+	void serveStdin();
+	bool serveSocket(const fs::path &path);
+};
+
+Server::Connection::~Connection() {
+#ifndef _WIN32
+	if (_fd != -1) {
+		::close(_fd);
+	}
+#endif
+}
+
+void Server::Connection::send(const std::string &line) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_fd == -1) {
+		// Don't interleave with log output, which also goes to stdout.
+		Common::flushLog();
+		std::cout << line << std::flush;
+		return;
+	}
+#ifndef _WIN32
+	const char *data = line.data();
+	size_t remaining = line.size();
+	while (remaining > 0) {
+		ssize_t written = ::write(_fd, data, remaining);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			// The client went away; there's no one left to tell.
+			return;
+		}
+		data += written;
+		remaining -= written;
+	}
+#endif
+}
+
+void Server::enqueue(const std::string &line, const std::shared_ptr<Connection> &connection) {
+	auto queued = std::chrono::steady_clock::now();
+	_pool.enqueue([this, line, connection, queued]() {
+		uint64_t queuedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - queued).count();
+		connection->send(handle(line, queuedUs));
+	});
+}
+
+std::string Server::handle(const std::string &line, uint64_t queuedUs) {
+	auto start = std::chrono::steady_clock::now();
+	Common::LogCapture capture;
+	Common::Profile profile;
+	Common::JSONWriter json("", "");
+	json.startObject();
+
+	bool ok = false;
+	std::string error;
+	Common::JSONValue request;
+	if (!Common::parseJSON(line, request, error)) {
+		json.writeKey("id");
+		json.writeNull();
+		error = "Invalid request: " + error;
+	} else {
+		const Common::JSONValue *id = request.get("id");
+		const Common::JSONValue *command = request.get("command");
+		const Common::JSONValue *input = request.get("input");
+		const Common::JSONValue *options = request.get("options");
+		json.writeKey("id");
+		if (!id || id->type == Common::JSONValue::kJSONNull) {
+			json.writeNull();
+		} else if (id->type == Common::JSONValue::kJSONNumber) {
+			double n = id->numberVal;
+			if (n >= INT_MIN && n <= INT_MAX && std::trunc(n) == n) {
+				json.writeVal((int)n);
+			} else {
+				json.writeVal(n);
+			}
+		} else {
+			json.writeVal(id->stringVal);
+		}
+
+		if (!command || !command->isString()) {
+			error = "Missing command";
+		} else if (!input || !input->isString()) {
+			error = "Missing input";
+		} else if (options && options->type != Common::JSONValue::kJSONObject) {
+			error = "options must be an object";
+		} else {
+			// Options are checked exactly as they would be on the command line.
+			bool dump = (command->stringVal == "dump");
+			std::vector<std::string> args = { "projectorrays", dump ? "decompile" : command->stringVal, input->stringVal };
+			if (options) {
+				for (const auto &[name, value] : options->objectVal) {
+					switch (value.type) {
+					case Common::JSONValue::kJSONBool:
+						if (value.boolVal) {
+							args.push_back("--" + name);
+						}
+						break;
+					case Common::JSONValue::kJSONNumber:
+						args.push_back("--" + name + "=" + numberToString(value.numberVal));
+						break;
+					case Common::JSONValue::kJSONString:
+						args.push_back("--" + name + "=" + value.stringVal);
+						break;
+					default:
+						break;
+					}
+				}
+			}
+			Common::Options parsed;
+			parsed.setPrintUsage(false);
+			parsed.parse(args);
+			if (!parsed.valid() || parsed.cmd() == Common::kCmdServe || parsed.hasOption("files-from")) {
+				error = "Invalid command or options";
+			} else {
+				std::unique_ptr<ScriptCache> scriptCache;
+				if (parsed.hasOption("script-cache")) {
+					scriptCache = std::make_unique<ScriptCache>(parsed.stringValue("script-cache"));
+				}
+				try {
+					if (dump) {
+						Common::ScopedTimer timer(&profile, Common::kPhaseTotal);
+						Common::MappedFile file;
+						Common::ReadStream stream(nullptr, 0);
+						auto dir = loadFile(file, stream, input->stringVal, parsed, nullptr, &profile, nullptr);
+						if (dir) {
+							dir->config->unprotect();
+							dir->parseScripts();
+							json.writeKey("scripts");
+							dir->writeScriptsJSON(json);
+							ok = true;
+						}
+					} else {
+						fs::path output;
+						ok = processFile(input->stringVal, parsed, fs::path(), nullptr, &profile, scriptCache.get(), &output);
+						if (ok && !output.empty()) {
+							json.writeKey("output");
+							json.writeVal(output.string());
+						}
+					}
+				} catch (const std::exception &e) {
+					error = e.what();
+				}
+				if (!ok && error.empty()) {
+					error = "Failed to process " + input->stringVal;
+				}
+			}
+		}
+	}
+
+	json.writeKey("ok");
+	json.writeBool(ok);
+	if (!ok) {
+		json.writeKey("error");
+		json.writeVal(error);
+	}
+	json.writeKey("messages");
+	json.startArray();
+		for (const auto &message : capture.take()) {
+			json.startObject();
+				json.writeKey("level");
+				json.writeVal(std::string(message.isWarning ? "warning" : "info"));
+				json.writeKey("text");
+				json.writeVal(message.text);
+			json.endObject();
+		}
+	json.endArray();
+	json.writeKey("timing");
+	json.startObject();
+		json.writeKey("queuedUs");
+		json.writeVal(queuedUs);
+		json.writeKey("elapsedUs");
+		json.writeVal((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start).count());
+		json.writeKey("profile");
+		profile.writeJSON(json);
+	json.endObject();
+	json.endObject();
+	return json.str() + "\n";
+}
+
+void Server::readLines(std::istream &in, const std::shared_ptr<Connection> &connection) {
+	std::string line;
+	while (std::getline(in, line)) {
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		if (line.empty())
+			continue;
+
+		enqueue(line, connection);
+	}
+}
+
+void Server::serveStdin() {
+	readLines(std::cin, std::make_shared<Connection>(-1));
+	_pool.wait();
+}
+
+#ifndef _WIN32
+
+void Server::readSocket(uint64_t readerID, int fd) {
+	auto connection = std::make_shared<Connection>(fd);
+	std::string pending;
+	char buf[4096];
+	while (true) {
+		ssize_t n = ::read(fd, buf, sizeof(buf));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+
+		pending.append(buf, n);
+		size_t start = 0;
+		size_t end;
+		while ((end = pending.find('\n', start)) != std::string::npos) {
+			std::string line = pending.substr(start, end - start);
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			if (!line.empty()) {
+				enqueue(line, connection);
+			}
+			start = end + 1;
+		}
+		pending.erase(0, start);
+	}
+
+	// The connection stays open until its last response has been sent, but
+	// stopReaders mustn't touch it from here on.
+	std::lock_guard<std::mutex> lock(_readersMutex);
+	_readerFds.erase(readerID);
+	_finishedReaders.push_back(readerID);
+}
+
+void Server::joinFinishedReaders() {
+	std::vector<std::thread> finished;
+	{
+		std::lock_guard<std::mutex> lock(_readersMutex);
+		for (uint64_t readerID : _finishedReaders) {
+			auto it = _readers.find(readerID);
+			finished.push_back(std::move(it->second));
+			_readers.erase(it);
+		}
+		_finishedReaders.clear();
+	}
+	for (auto &thread : finished) {
+		thread.join();
+	}
+}
+
+void Server::stopReaders() {
+	std::vector<std::thread> readers;
+	{
+		std::lock_guard<std::mutex> lock(_readersMutex);
+		// Shutting down the reading side ends each reader's loop, while
+		// responses to requests already read can still be sent.
+		for (const auto &[readerID, fd] : _readerFds) {
+			shutdown(fd, SHUT_RD);
+		}
+		for (auto &[readerID, thread] : _readers) {
+			readers.push_back(std::move(thread));
+		}
+		_readers.clear();
+		_finishedReaders.clear();
+	}
+	for (auto &thread : readers) {
+		thread.join();
+	}
+	_pool.wait();
+}
+
+bool Server::serveSocket(const fs::path &path) {
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	std::string pathString = path.string();
+	if (pathString.size() >= sizeof(addr.sun_path)) {
+		Common::warning("Socket path is too long: " + pathString);
+		return false;
+	}
+	strncpy(addr.sun_path, pathString.c_str(), sizeof(addr.sun_path) - 1);
+
+	int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFd == -1) {
+		Common::warning(boost::format("Could not create socket: %s") % strerror(errno));
+		return false;
+	}
+	// Replace a socket left behind by an earlier server.
+	std::error_code ec;
+	if (fs::is_socket(path, ec)) {
+		fs::remove(path, ec);
+	}
+	if (bind(listenFd, (sockaddr *)&addr, sizeof(addr)) == -1 || listen(listenFd, 16) == -1) {
+		Common::warning(boost::format("Could not listen on %s: %s") % pathString % strerror(errno));
+		::close(listenFd);
+		return false;
+	}
+	// Writing to a client that hung up shouldn't kill the server.
+	signal(SIGPIPE, SIG_IGN);
+	Common::log("Listening on " + pathString);
+
+	while (true) {
+		int fd = accept(listenFd, nullptr, nullptr);
+		if (fd == -1) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			Common::warning(boost::format("Could not accept connection: %s") % strerror(errno));
+			break;
+		}
+		joinFinishedReaders();
+
+		std::lock_guard<std::mutex> lock(_readersMutex);
+		uint64_t readerID = _nextReaderID++;
+		_readerFds[readerID] = fd;
+		_readers.emplace(readerID, std::thread([this, readerID, fd]() { readSocket(readerID, fd); }));
+	}
+	::close(listenFd);
+	stopReaders();
+	return false;
+}
+
+#else
+
+bool Server::serveSocket(const fs::path &) {
+	Common::warning("--socket is not supported on this platform");
+	return false;
+}
+
+#endif
+
+bool parseJobs(const Common::Options &options, unsigned int &jobs) {
+	jobs = 1;
+	if (!options.hasOption("jobs"))
+		return true;
+
+	std::string value = options.stringValue("jobs");
+	try {
+		size_t end;
+		unsigned long n = std::stoul(value, &end);
+		if (end != value.size())
+			throw std::invalid_argument(value);
+		jobs = (n == 0) ? Common::ThreadPool::hardwareThreads() : n;
+	} catch (const std::exception &) {
+		Common::warning("Invalid number of jobs: " + value);
+		return false;
+	}
+	return true;
+}
+
 int main(int argc, char *argv[]) {
 	Common::Options options;
 	options.parse(argc, argv);
@@ -116,46 +811,80 @@ int main(int argc, char *argv[]) {
 		return EXIT_FAILURE;
 	}
 	if (options.hasOption("verbose")) {
-		Common::g_verbose = true;
+		Common::g_logLevel = Common::kLogLevelDebug;
+	}
+
+	unsigned int jobs;
+	if (!parseJobs(options, jobs)) {
+		return EXIT_FAILURE;
+	}
+
+	if (options.cmd() == Common::kCmdServe) {
+		Server server(jobs);
+		if (options.hasOption("socket")) {
+			return server.serveSocket(options.stringValue("socket")) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		server.serveStdin();
+		return EXIT_SUCCESS;
 	}
 
+	bool batch = options.hasOption("files-from");
 	fs::path input = options.inputFile();
-	if (fs::is_directory(input)) {
+	if (!batch && fs::is_directory(input)) {
+		batch = true;
+	}
+
+	if (batch) {
+		fs::path output;
 		if (options.hasOption("output")) {
-			fs::path output = options.stringValue("output");
+			output = options.stringValue("output");
 			if (fs::exists(output)) {
 				if (!fs::is_directory(output)) {
-					Common::warning(boost::format("Output must be a directory when input is a directory!"));
+					Common::warning(boost::format("Output must be a directory when processing multiple files!"));
 					return EXIT_FAILURE;
 				}
 			} else {
-				fs::create_directory(output);
+				fs::create_directories(output);
 			}
 		}
-		for (const fs::directory_entry &dirEntry : fs::directory_iterator(input)) {
-			if (!dirEntry.is_regular_file())
-				continue;
-
-			fs::path path = dirEntry.path();
-			std::string extension = path.extension().string();
-			if (!(Common::compareIgnoreCase(extension, ".dcr") == 0
-					|| Common::compareIgnoreCase(extension, ".dxr") == 0
-					|| Common::compareIgnoreCase(extension, ".cct") == 0
-					|| Common::compareIgnoreCase(extension, ".cxt") == 0))
-				continue;
 
-			if (!processFile(path, options, true))
-				return EXIT_FAILURE;
+		BatchProcessor processor(options, jobs);
+		bool success = true;
+		if (options.hasOption("files-from")) {
+			success = addFileList(processor, options.stringValue("files-from"), output);
+		} else {
+			addDirectory(processor, input, output, options.hasOption("recursive"));
 		}
+		if (!processor.finish())
+			success = false;
+		if (!success)
+			return EXIT_FAILURE;
 	} else {
-		bool outputIsDirectory = false;
+		fs::path outputDir;
 		if (options.hasOption("output")) {
 			fs::path output = options.stringValue("output");
 			if (fs::is_directory(output)) {
-				outputIsDirectory = true;
+				outputDir = output;
 			}
 		}
-		if (!processFile(input, options, outputIsDirectory))
+		// A single file spreads its own work across the pool instead.
+		std::unique_ptr<Common::ThreadPool> threadPool;
+		if (jobs > 1) {
+			threadPool = std::make_unique<Common::ThreadPool>(jobs - 1);
+		}
+		std::unique_ptr<Common::Profile> profile;
+		if (options.hasOption("profile")) {
+			profile = std::make_unique<Common::Profile>();
+		}
+		std::unique_ptr<ScriptCache> scriptCache;
+		if (options.hasOption("script-cache")) {
+			scriptCache = std::make_unique<ScriptCache>(options.stringValue("script-cache"));
+		}
+		bool success = processFile(input, options, outputDir, threadPool.get(), profile.get(), scriptCache.get());
+		if (profile) {
+			printProfile(*profile, options, input.string());
+		}
+		if (!success)
 			return EXIT_FAILURE;
 	}
 
@@ -0,0 +1,132 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include "common/fileio.h"
+#include "common/log.h"
+#include "common/profile.h"
+#include "common/stream.h"
+#include "common/threadpool.h"
+#include "director/chunk.h"
+#include "director/dirfile.h"
+#include "director/util.h"
+#include "projectorrays.h"
+
+using namespace Director;
+
+namespace ProjectorRays {
+
+static bool decompileMovie(const uint8_t *data, size_t size, Sink &sink, const Options &options,
+		Common::ThreadPool *threadPool, Common::Profile *profile) {
+	Common::ScopedTimer timer(profile, Common::kPhaseTotal);
+
+	// The input is only ever read, but streams don't distinguish.
+	Common::ReadStream stream(const_cast<uint8_t *>(data), size);
+	DirectorFile dir;
+	dir.threadPool = threadPool;
+	dir.profile = profile;
+	dir.soundMode = options.decodeSounds ? Common::kSoundModeDecode : Common::kSoundModeKeepUnplayable;
+	if (!dir.read(&stream))
+		return false;
+
+	MovieInfo info;
+	info.version = humanVersion(dir.config->directorVersion);
+	info.versionString = versionString(info.version, dir.fverVersionString);
+	info.isCast = dir.isCast();
+	info.afterburned = dir.afterburned;
+	sink.info(info);
+
+	dir.config->unprotect();
+	dir.parseScripts();
+	dir.restoreScriptText();
+
+	for (const auto &cast : dir.casts) {
+		if (!cast->lctx)
+			continue;
+
+		for (const auto &[scriptId, script] : cast->lctx->scripts) {
+			CastMemberChunk *member = script->member;
+			if (!member)
+				continue;
+
+			ScriptInfo scriptInfo;
+			scriptInfo.castName = cast->name;
+			scriptInfo.memberID = member->id;
+			scriptInfo.memberName = member->getName();
+			scriptInfo.type = dir.scriptTypeName(member);
+			scriptInfo.text = script->scriptText(options.lineEnding.c_str());
+			scriptInfo.bytecode = script->bytecodeText(options.lineEnding.c_str());
+			sink.script(scriptInfo);
+		}
+	}
+
+	dir.generateInitialMap();
+	dir.generateMemoryMap();
+	size_t outputSize = dir.size();
+	uint8_t *output = sink.allocate(outputSize);
+	if (output) {
+		Common::ScopedTimer writeTimer(profile, Common::kPhaseWrite);
+		Common::BufferWriter writer(output, outputSize);
+		dir.write(writer);
+	}
+	return true;
+}
+
+static Stats makeStats(const Common::Profile &profile) {
+	Stats stats;
+	stats.totalUs = profile.nanoseconds(Common::kPhaseTotal) / 1000;
+	stats.readMapsUs = profile.nanoseconds(Common::kPhaseReadMaps) / 1000;
+	stats.readCastsUs = profile.nanoseconds(Common::kPhaseReadCasts) / 1000;
+	stats.decompressUs = profile.nanoseconds(Common::kPhaseDecompress) / 1000;
+	stats.deserializeUs = profile.nanoseconds(Common::kPhaseDeserialize) / 1000;
+	stats.parseScriptsUs = profile.nanoseconds(Common::kPhaseParseScripts) / 1000;
+	stats.restoreScriptTextUs = profile.nanoseconds(Common::kPhaseRestoreScriptText) / 1000;
+	stats.writeUs = profile.nanoseconds(Common::kPhaseWrite) / 1000;
+	stats.bytesDecompressed = profile.counter(Common::kCounterBytesDecompressed);
+	stats.chunksDeserialized = profile.counter(Common::kCounterChunksDeserialized);
+	stats.handlersParsed = profile.counter(Common::kCounterHandlersParsed);
+	stats.astNodes = profile.counter(Common::kCounterASTNodes);
+	return stats;
+}
+
+bool decompile(const uint8_t *data, size_t size, Sink &sink, const Options &options) {
+	std::unique_ptr<Common::ThreadPool> threadPool;
+	if (options.jobs > 1) {
+		// The calling thread takes part in the work as well.
+		threadPool = std::make_unique<Common::ThreadPool>(options.jobs - 1);
+	}
+	std::unique_ptr<Common::Profile> profile;
+	if (options.collectStats) {
+		profile = std::make_unique<Common::Profile>();
+	}
+
+	bool ok = false;
+	std::vector<Common::LogMessage> messages;
+	{
+		// Everything logged while decompiling goes to the sink rather than
+		// the process-wide log.
+		Common::LogCapture capture;
+		try {
+			ok = decompileMovie(data, size, sink, options, threadPool.get(), profile.get());
+		} catch (const std::exception &e) {
+			Common::warning(std::string("Failed to decompile: ") + e.what());
+			ok = false;
+		}
+		messages = capture.take();
+	}
+	for (const auto &message : messages) {
+		sink.message(message.isWarning, message.text);
+	}
+	if (profile) {
+		sink.stats(makeStats(*profile));
+	}
+	return ok;
+}
+
+} // namespace ProjectorRays
@@ -0,0 +1,92 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef PROJECTORRAYS_H
+#define PROJECTORRAYS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Library interface for decompiling movies and casts held in memory. Nothing
+// here touches the filesystem or any state shared between calls, so any
+// number of calls can run at once on different threads.
+namespace ProjectorRays {
+
+struct Options {
+	// Convert sounds to a format Director can read. If false, MP3 sounds
+	// are copied through as they are and won't play in Director.
+	bool decodeSounds = true;
+	// Line ending used in the script text passed to Sink::script.
+	std::string lineEnding = "\n";
+	// Number of threads to decompress chunks and parse scripts on. 1 or less
+	// does everything on the calling thread.
+	int jobs = 1;
+	// Time each stage and pass the results to Sink::stats.
+	bool collectStats = false;
+};
+
+struct MovieInfo {
+	unsigned int version;
+	std::string versionString;
+	bool isCast;
+	bool afterburned;
+};
+
+struct ScriptInfo {
+	std::string castName;
+	int32_t memberID;
+	std::string memberName;
+	std::string type;
+	std::string text;
+	std::string bytecode;
+};
+
+// Time spent in each stage, in microseconds, and how much work was done.
+// Stages nest (decompression happens while deserializing, for instance), so
+// each stage's time includes the stages run inside it. Time spent on several
+// threads at once is summed over all of them.
+struct Stats {
+	uint64_t totalUs = 0;
+	uint64_t readMapsUs = 0;
+	uint64_t readCastsUs = 0;
+	uint64_t decompressUs = 0;
+	uint64_t deserializeUs = 0;
+	uint64_t parseScriptsUs = 0;
+	uint64_t restoreScriptTextUs = 0;
+	uint64_t writeUs = 0;
+	uint64_t bytesDecompressed = 0;
+	uint64_t chunksDeserialized = 0;
+	uint64_t handlersParsed = 0;
+	uint64_t astNodes = 0;
+};
+
+/* Sink */
+
+// Receives the results of decompile() on the calling thread.
+class Sink {
+public:
+	virtual ~Sink() = default;
+
+	// Returns space for the restored file, which must stay valid until
+	// decompile() returns, or nullptr to skip writing it.
+	virtual uint8_t *allocate(size_t size) = 0;
+	virtual void info(const MovieInfo &) {}
+	virtual void script(const ScriptInfo &) {}
+	virtual void message(bool, const std::string &) {}
+	// Only called if Options::collectStats is set.
+	virtual void stats(const Stats &) {}
+};
+
+// Restores the scripts of the movie or cast in data and writes the result to
+// the space sink allocates. Messages that would otherwise be logged, errors
+// included, are passed to the sink. Returns false if the input couldn't be
+// decompiled.
+bool decompile(const uint8_t *data, size_t size, Sink &sink, const Options &options = Options());
+
+} // namespace ProjectorRays
+
+#endif // PROJECTORRAYS_H